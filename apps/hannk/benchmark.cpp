@@ -1,23 +1,55 @@
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 #include "HalideRuntime.h"
 
 #include "halide_benchmark.h"
 #include "interpreter/interpreter.h"
+#include "interpreter/request_batcher.h"
 #include "tflite/tflite_parser.h"
 #include "util/error_util.h"
 #include "util/file_util.h"
 
 namespace hannk {
 
-void run_benchmark(const std::string &filename, const InterpreterOptions &options) {
+double benchmark_interpreter(const std::vector<char> &buffer, const InterpreterOptions &options) {
+    std::unique_ptr<OpGroup> model = parse_tflite_model_from_buffer(buffer.data());
+    Interpreter interpreter(std::move(model), options);
+    return Halide::Tools::benchmark([&]() { interpreter.execute(); }).wall_time;
+}
+
+bool ends_with(const std::string &s, const std::string &suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void run_benchmark(const std::string &filename, const InterpreterOptions &options, bool compare_sequential, bool save_prepared) {
     if (!options.trace) {
         // In trace mode, don't send *anything* to stdout
         std::cout << filename;
     }
 
+    if (ends_with(filename, ".hannk")) {
+        // A prepared model, saved by --save_prepared.
+        std::unique_ptr<Interpreter> interpreter = Interpreter::load(filename, options);
+        if (!options.trace) {
+            auto result = Halide::Tools::benchmark([&]() { interpreter->execute(); });
+            std::cout << ": " << result.wall_time * 1e6 << " us" << std::endl;
+
+            halide_profiler_report(nullptr);
+            halide_profiler_reset();
+        } else {
+            std::cout << std::endl;
+            interpreter->execute();
+        }
+        return;
+    }
+
+    auto prepare_start = std::chrono::steady_clock::now();
     std::vector<char> buffer = read_entire_file(filename);
     std::unique_ptr<OpGroup> model = parse_tflite_model_from_buffer(buffer.data());
 
@@ -26,10 +58,34 @@ void run_benchmark(const std::string &filename, const InterpreterOptions &option
     }
 
     Interpreter interpreter(std::move(model), options);
+    std::chrono::duration<double> prepare_time = std::chrono::steady_clock::now() - prepare_start;
+
+    if (save_prepared) {
+        const std::string prepared_filename = filename + ".hannk";
+        interpreter.save(prepared_filename);
+
+        auto load_start = std::chrono::steady_clock::now();
+        Interpreter::load(prepared_filename, options);
+        std::chrono::duration<double> load_time = std::chrono::steady_clock::now() - load_start;
+        if (!options.trace) {
+            std::cout << " (prepare: " << prepare_time.count() * 1e3 << " ms, load "
+                      << prepared_filename << ": " << load_time.count() * 1e3 << " ms)";
+        }
+    }
 
     if (!options.trace) {
         auto result = Halide::Tools::benchmark([&]() { interpreter.execute(); });
-        std::cout << ": " << result.wall_time * 1e6 << " us" << std::endl;
+        std::cout << ": " << result.wall_time * 1e6 << " us";
+
+        if (compare_sequential) {
+            InterpreterOptions sequential_options = options;
+            sequential_options.max_concurrent_ops = 1;
+            sequential_options.verbose = false;
+            double sequential_time = benchmark_interpreter(buffer, sequential_options);
+            std::cout << " (sequential: " << sequential_time * 1e6 << " us, speedup: "
+                      << sequential_time / result.wall_time << "x)";
+        }
+        std::cout << std::endl;
 
         halide_profiler_report(nullptr);
         halide_profiler_reset();
@@ -39,10 +95,72 @@ void run_benchmark(const std::string &filename, const InterpreterOptions &option
     }
 }
 
+// Measure the latency and throughput of serving inferences requested by
+// batch_size concurrent clients, batched with a RequestBatcher.
+void run_batching_benchmark(const std::string &filename, const InterpreterOptions &options, int batch_size) {
+    std::vector<char> buffer = read_entire_file(filename);
+    std::unique_ptr<OpGroup> model = parse_tflite_model_from_buffer(buffer.data(), batch_size);
+    Interpreter interpreter(std::move(model), options);
+    RequestBatcher batcher(&interpreter, std::chrono::milliseconds(1));
+
+    const int clients = batch_size;
+    const int requests_per_client = std::max(10, 100 / batch_size);
+
+    std::vector<std::vector<double>> latencies(clients);
+    auto client = [&](int c) {
+        // Make the buffers for one request, with a batch dimension of extent 1.
+        std::vector<HalideBuffer<const void>> inputs;
+        for (const TensorPtr &t : interpreter.inputs()) {
+            HalideBuffer<void> input = HalideBuffer<void>::make_with_shape_of(t->buffer().cropped(t->rank() - 1, 0, 1));
+            memset(input.data(), 0, input.size_in_bytes());
+            inputs.push_back(input);
+        }
+        std::vector<HalideBuffer<void>> outputs;
+        for (const TensorPtr &t : interpreter.outputs()) {
+            outputs.push_back(HalideBuffer<void>::make_with_shape_of(t->buffer().cropped(t->rank() - 1, 0, 1)));
+        }
+
+        for (int i = 0; i < requests_per_client; i++) {
+            auto start = std::chrono::steady_clock::now();
+            batcher.run(inputs, outputs);
+            auto end = std::chrono::steady_clock::now();
+            latencies[c].push_back(std::chrono::duration<double>(end - start).count());
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; c++) {
+        threads.emplace_back(client, c);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    const double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const auto &l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    std::sort(all.begin(), all.end());
+    double mean = 0;
+    for (double l : all) {
+        mean += l / all.size();
+    }
+    const double p99 = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+
+    std::cout << filename << " batch size " << batch_size << ": "
+              << all.size() / wall_time << " inferences/s, latency mean "
+              << mean * 1e6 << " us, p99 " << p99 * 1e6 << " us" << std::endl;
+}
+
 }  // namespace hannk
 
 int main(int argc, char **argv) {
     hannk::InterpreterOptions options;
+    bool compare_sequential = false;
+    bool save_prepared = false;
+    std::vector<int> batch_sizes;
 
     for (int i = 1; i < argc; i++) {
         if (!strcmp(argv[i], "--verbose")) {
@@ -53,6 +171,35 @@ int main(int argc, char **argv) {
             options.trace = true;
             continue;
         }
+        if (!strcmp(argv[i], "--fuse_ops")) {
+            options.fuse_ops = true;
+            continue;
+        }
+        if (!strncmp(argv[i], "--max_concurrent_ops=", 21)) {
+            options.max_concurrent_ops = atoi(argv[i] + 21);
+            continue;
+        }
+        if (!strcmp(argv[i], "--compare_sequential")) {
+            compare_sequential = true;
+            continue;
+        }
+        if (!strcmp(argv[i], "--save_prepared")) {
+            save_prepared = true;
+            continue;
+        }
+        if (!strncmp(argv[i], "--batch_sizes=", 14)) {
+            for (const char *p = argv[i] + 14; *p;) {
+                char *end;
+                long batch_size = strtol(p, &end, 10);
+                if (end == p || (*end && *end != ',') || batch_size < 1) {
+                    HLOG(ERROR) << "Invalid batch size in " << argv[i] << ".\n";
+                    exit(-1);
+                }
+                batch_sizes.push_back((int)batch_size);
+                p = *end ? end + 1 : end;
+            }
+            continue;
+        }
         if (argv[i][0] == '-') {
             HLOG(ERROR) << "Unknown flag: " << argv[i] << ".\n";
             exit(-1);
@@ -68,7 +215,13 @@ int main(int argc, char **argv) {
         if (!strncmp(argv[i], "--", 2)) {
             continue;
         }
-        hannk::run_benchmark(argv[i], options);
+        if (!batch_sizes.empty()) {
+            for (int batch_size : batch_sizes) {
+                hannk::run_batching_benchmark(argv[i], options, batch_size);
+            }
+        } else {
+            hannk::run_benchmark(argv[i], options, compare_sequential, save_prepared);
+        }
     }
 
     std::cout << "Done!\n";
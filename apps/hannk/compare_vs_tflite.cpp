@@ -67,6 +67,14 @@ int main(int argc, char **argv) {
     };
 
     const FlagFnMap m = {
+        {"batch_size", [&runner](const std::string &value) {
+             runner.batch_size = std::stoi(value);
+             if (runner.batch_size < 1) {
+                 std::cerr << "--batch_size must be at least 1\n";
+                 return -1;
+             }
+             return 0;
+         }},
         {"benchmark", [&runner](const std::string &value) {
              runner.do_benchmark = std::stoi(value) != 0;
              return 0;
@@ -93,6 +101,9 @@ int main(int argc, char **argv) {
                  case 'i':
                      runner.do_run[ModelRunner::kInternalDelegate] = true;
                      break;
+                 case 'p':
+                     runner.do_run[ModelRunner::kHannkPrepared] = true;
+                     break;
                  default:
                      std::cerr << "Unknown option to --enable: " << c << "\n";
                      return -1;
@@ -104,6 +115,14 @@ int main(int argc, char **argv) {
              runner.external_delegate_path = value;
              return 0;
          }},
+        {"fuse_ops", [&runner](const std::string &value) {
+             runner.fuse_ops = std::stoi(value) != 0;
+             return 0;
+         }},
+        {"max_concurrent_ops", [&runner](const std::string &value) {
+             runner.max_concurrent_ops = std::stoi(value);
+             return 0;
+         }},
         {"seed", [&seed](const std::string &value) {
              seed = std::stoi(value);
              return 0;
@@ -0,0 +1,94 @@
+#include "interpreter/allocation_planner.h"
+#include "util/error_util.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace hannk {
+
+namespace {
+
+size_t align_up(size_t x, size_t n) {
+    return (x + n - 1) / n * n;
+}
+
+}  // namespace
+
+AllocationPlanner::AllocationPlanner(size_t alignment)
+    : alignment_(alignment) {
+    assert(alignment_ > 0);
+}
+
+int AllocationPlanner::add(size_t size, int first_use, int last_use) {
+    assert(!committed_);
+    assert(first_use <= last_use);
+    allocations_.push_back({align_up(size, alignment_), first_use, last_use, 0});
+    return (int)allocations_.size() - 1;
+}
+
+void AllocationPlanner::commit() {
+    assert(!committed_);
+    committed_ = true;
+
+    // Place the largest allocations first, as they are the hardest to fit
+    // into gaps later.
+    std::vector<int> order(allocations_.size());
+    for (int i = 0; i < (int)order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return allocations_[a].size > allocations_[b].size;
+    });
+
+    // The allocations placed so far, sorted by offset.
+    std::vector<int> placed;
+    for (int i : order) {
+        Allocation &a = allocations_[i];
+
+        size_t best_offset = 0;
+        size_t best_gap = std::numeric_limits<size_t>::max();
+        size_t end_of_previous = 0;
+        for (int j : placed) {
+            const Allocation &p = allocations_[j];
+            if (p.last_use < a.first_use || p.first_use > a.last_use) {
+                // Not live at the same time as this allocation.
+                continue;
+            }
+            if (p.offset > end_of_previous) {
+                const size_t gap = p.offset - end_of_previous;
+                if (gap >= a.size && gap < best_gap) {
+                    best_offset = end_of_previous;
+                    best_gap = gap;
+                }
+            }
+            end_of_previous = std::max(end_of_previous, p.offset + p.size);
+        }
+        a.offset = best_gap != std::numeric_limits<size_t>::max() ? best_offset : end_of_previous;
+        arena_size_ = std::max(arena_size_, a.offset + a.size);
+
+        auto at = std::upper_bound(placed.begin(), placed.end(), a.offset, [&](size_t offset, int j) {
+            return offset < allocations_[j].offset;
+        });
+        placed.insert(at, i);
+    }
+}
+
+size_t AllocationPlanner::offset(int id) const {
+    assert(committed_);
+    return allocations_[id].offset;
+}
+
+size_t AllocationPlanner::arena_size() const {
+    assert(committed_);
+    return arena_size_;
+}
+
+size_t AllocationPlanner::total_size() const {
+    size_t result = 0;
+    for (const Allocation &a : allocations_) {
+        result += a.size;
+    }
+    return result;
+}
+
+}  // namespace hannk
@@ -0,0 +1,57 @@
+#ifndef HANNK_ALLOCATION_PLANNER_H
+#define HANNK_ALLOCATION_PLANNER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace hannk {
+
+// Packs a set of allocations with known lifetimes into a single arena.
+// Lifetimes are inclusive ranges of op indices in execution order, and
+// allocations whose lifetimes overlap are assigned disjoint ranges of the
+// arena. Allocations are placed from the largest to the smallest, each in
+// the smallest gap between the allocations it overlaps with that will
+// hold it (or after all of them, if none will).
+class AllocationPlanner {
+    struct Allocation {
+        size_t size;
+        int first_use, last_use;
+        size_t offset;
+    };
+
+    const size_t alignment_;
+    std::vector<Allocation> allocations_;
+    size_t arena_size_ = 0;
+    bool committed_ = false;
+
+public:
+    explicit AllocationPlanner(size_t alignment);
+
+    // Add an allocation of `size` bytes, used by the ops with indices in
+    // [first_use, last_use]. Returns an id to look up its offset with.
+    int add(size_t size, int first_use, int last_use);
+
+    // Assign offsets to all the allocations.
+    void commit();
+
+    // The offset in bytes of an allocation into the arena.
+    size_t offset(int id) const;
+
+    // The size of the arena needed to hold all the allocations.
+    size_t arena_size() const;
+
+    // The sum of the sizes of all the allocations, i.e. the memory used
+    // if each one were allocated separately.
+    size_t total_size() const;
+
+    // Movable but not copyable.
+    AllocationPlanner() = delete;
+    AllocationPlanner(const AllocationPlanner &) = delete;
+    AllocationPlanner &operator=(const AllocationPlanner &) = delete;
+    AllocationPlanner(AllocationPlanner &&) = default;
+    AllocationPlanner &operator=(AllocationPlanner &&) = delete;
+};
+
+}  // namespace hannk
+
+#endif  // HANNK_ALLOCATION_PLANNER_H
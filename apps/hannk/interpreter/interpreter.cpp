@@ -1,9 +1,14 @@
 #include "interpreter/interpreter.h"
+#include "interpreter/allocation_planner.h"
+#include "interpreter/prepared_model.h"
 #include "interpreter/transforms.h"
 #include "util/error_util.h"
+#include "util/file_util.h"
 
+#include <algorithm>
 #include <cmath>
 #include <list>
+#include <map>
 
 namespace hannk {
 
@@ -17,6 +22,116 @@ Interpreter::~Interpreter() {
 
 namespace {
 
+// Memory for tensors is aligned to this many bytes, which is enough
+// alignment for all the platforms we might use.
+constexpr size_t tensor_alignment = 128;
+
+// Find the lifetimes of the storage of all the tensors that need memory,
+// as the range of indices of the ops using them in execution order.
+class FindStorageLifetimes : public OpVisitor {
+    std::map<TensorStorage *, int> index_of_;
+    int op_index_ = 0;
+
+    void visit(OpGroup *g) {
+        const int first_index = op_index_;
+        for (int i = 0; i < g->op_count(); i++) {
+            Op *op = g->op(i);
+            const int index = op_index_++;
+            for (int j = 0; j < op->input_count(); j++) {
+                use(op->input(j), index, index);
+            }
+            for (int j = 0; j < op->output_count(); j++) {
+                use(op->output(j), index, index);
+            }
+            op->accept(this);
+        }
+        if (g->is_tiled()) {
+            // The ops of a tiled group execute interleaved with each other,
+            // so all of their tensors are live for the whole group.
+            const int last_index = op_index_ - 1;
+            for (int i = 0; i < g->op_count(); i++) {
+                Op *op = g->op(i);
+                for (int j = 0; j < op->input_count(); j++) {
+                    use(op->input(j), first_index, last_index);
+                }
+                for (int j = 0; j < op->output_count(); j++) {
+                    use(op->output(j), first_index, last_index);
+                }
+            }
+        }
+    }
+
+public:
+    struct Lifetime {
+        std::shared_ptr<TensorStorage> storage;
+        int first_use, last_use;
+    };
+    // In the order they were first seen, so planning is deterministic.
+    std::vector<Lifetime> lifetimes;
+
+    // Extend the lifetime of the storage of `t` to include [first_use, last_use].
+    void use(const TensorPtr &t, int first_use, int last_use) {
+        if (t->is_constant() || t->is_dynamic() || t->is_allocated()) {
+            return;
+        }
+        std::shared_ptr<TensorStorage> storage = t->storage();
+        if (storage->is_allocated()) {
+            return;
+        }
+        auto i = index_of_.find(storage.get());
+        if (i == index_of_.end()) {
+            index_of_[storage.get()] = (int)lifetimes.size();
+            lifetimes.push_back({storage, first_use, last_use});
+        } else {
+            Lifetime &l = lifetimes[i->second];
+            l.first_use = std::min(l.first_use, first_use);
+            l.last_use = std::max(l.last_use, last_use);
+        }
+    }
+
+    int op_count() const {
+        return op_index_;
+    }
+};
+
+// Allocate the tensors that aren't live at the same time as each other
+// from the same memory.
+void plan_tensor_storage(OpGroup *model, bool verbose) {
+    FindStorageLifetimes find_lifetimes;
+    model->accept(&find_lifetimes);
+
+    // The inputs and outputs of the model are accessed before and after
+    // executing it, so they need to be live throughout.
+    const int last_op = std::max(find_lifetimes.op_count() - 1, 0);
+    for (int i = 0; i < model->input_count(); i++) {
+        find_lifetimes.use(model->input(i), 0, last_op);
+    }
+    for (int i = 0; i < model->output_count(); i++) {
+        find_lifetimes.use(model->output(i), 0, last_op);
+    }
+
+    AllocationPlanner planner(tensor_alignment);
+    std::vector<int> ids;
+    for (const auto &l : find_lifetimes.lifetimes) {
+        ids.push_back(planner.add(l.storage->size_in_bytes(), l.first_use, l.last_use));
+    }
+    planner.commit();
+
+    if (verbose) {
+        HLOG(INFO) << "Tensor arena size: " << planner.arena_size() << " bytes, for "
+                   << find_lifetimes.lifetimes.size() << " tensor buffers totalling "
+                   << planner.total_size() << " bytes\n";
+    }
+
+    if (planner.arena_size() == 0) {
+        return;
+    }
+    HalideBuffer<void> arena = HalideBuffer<uint8_t>((int)planner.arena_size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        find_lifetimes.lifetimes[i].storage->allocate_from(arena, planner.offset(ids[i]));
+    }
+}
+
 class AllocateAll : public OpVisitor {
     void visit(OpGroup *g) {
         for (int i = 0; i < g->op_count(); i++) {
@@ -39,11 +154,39 @@ void Interpreter::init(InterpreterOptions options) {
     in_place(model_.get());
     fold_constants(model_.get());
     remove_dead_ops(model_.get());
+    if (options.fuse_ops) {
+        fuse_ops(model_.get());
+    }
 
-    // TODO: Find a better schedule for executing the ops, including
-    // better lifetime management for these allocations.
+    // TODO: Find a better schedule for executing the ops, to reduce
+    // the memory needed for the tensors.
+    plan_tensor_storage(model_.get(), options.verbose);
+
+    // Point each tensor at its storage, and allocate the tensors left
+    // out of the plan.
+    AllocateAll allocate_all;
+    model_->accept(&allocate_all);
+
+    model_->set_max_concurrent_ops(options.max_concurrent_ops);
+}
+
+Interpreter::Interpreter(std::shared_ptr<MappedFile> file, std::unique_ptr<OpGroup> m, InterpreterOptions options)
+    : file_(std::move(file)), model_(std::move(m)) {
+    // The model was transformed and its memory planned before it was saved.
     AllocateAll allocate_all;
     model_->accept(&allocate_all);
+
+    model_->set_max_concurrent_ops(options.max_concurrent_ops);
+}
+
+void Interpreter::save(const std::string &filename) {
+    save_prepared_model(model_.get(), filename);
+}
+
+std::unique_ptr<Interpreter> Interpreter::load(const std::string &filename, InterpreterOptions options) {
+    auto file = std::make_shared<MappedFile>(filename);
+    std::unique_ptr<OpGroup> model = load_prepared_model(file->data(), file->size());
+    return std::unique_ptr<Interpreter>(new Interpreter(std::move(file), std::move(model), options));
 }
 
 void Interpreter::execute() {
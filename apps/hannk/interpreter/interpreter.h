@@ -1,6 +1,7 @@
 #ifndef HANNK_INTERPRETER_H
 #define HANNK_INTERPRETER_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -14,17 +15,45 @@ struct InterpreterOptions {
 
     // Whether to enable tracing.
     bool trace = false;
+
+    // Whether to execute chains of convolutions and elementwise ops one
+    // tile at a time, so the intermediate tensors stay in cache. This is
+    // experimental, so it is off by default. The hannk tests with the
+    // .fused suffix check it against TFLite.
+    bool fuse_ops = false;
+
+    // The most ops to execute at the same time, when they don't depend on
+    // each other. Each op's own parallelism shares the Halide thread pool
+    // with the other ops running at the same time.
+    int max_concurrent_ops = 1;
 };
 
+class MappedFile;
+
 class Interpreter {
+    // The file a prepared model was loaded from, which holds the constant
+    // tensors of the model.
+    std::shared_ptr<MappedFile> file_;
     std::unique_ptr<OpGroup> model_;
 
     void init(InterpreterOptions options);
 
+    Interpreter(std::shared_ptr<MappedFile> file, std::unique_ptr<OpGroup> m, InterpreterOptions options);
+
 public:
     explicit Interpreter(std::unique_ptr<OpGroup> m, InterpreterOptions options = InterpreterOptions());
     ~Interpreter();
 
+    // Save the model, as prepared to execute by this interpreter, to
+    // `filename`. Loading the file with `load` skips parsing, transforming,
+    // and planning the memory of the model.
+    void save(const std::string &filename);
+
+    // Load a model saved by `save`. The file is mapped into memory, and
+    // the constant tensors of the model are used from the mapping.
+    // `options` only affects how the model executes.
+    static std::unique_ptr<Interpreter> load(const std::string &filename, InterpreterOptions options = InterpreterOptions());
+
     // Return the Tensor in the current Model with the given name.
     // If none with that name, return null. Tensor is still owned by the Model.
     TensorPtr get_tensor(const std::string &name);
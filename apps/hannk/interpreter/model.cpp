@@ -2,8 +2,13 @@
 #include "interpreter/ops.h"
 #include "util/error_util.h"
 
+#include <algorithm>
 #include <cmath>
 #include <list>
+#include <mutex>
+#include <queue>
+
+#include "HalideRuntime.h"
 
 namespace hannk {
 
@@ -72,6 +77,14 @@ void TensorStorage::allocate() {
     }
 }
 
+void TensorStorage::allocate_from(const HalideBuffer<void> &arena, size_t offset) {
+    assert(!buffer_.data());
+    assert(offset + size_in_bytes() <= arena.size_in_bytes());
+    arena_ = arena;
+    buffer_ = HalideBuffer<void>(buffer_.type(), (uint8_t *)arena.data() + offset,
+                                 buffer_.dimensions(), buffer_.raw_buffer()->dim);
+}
+
 Tensor::Tensor(std::string name, HalideBuffer<void> buffer, QuantizationInfo quantization)
     : name_(std::move(name)),
       buffer_(std::move(buffer)),
@@ -206,9 +219,13 @@ bool Tensor::is_alias() const {
 }
 
 void Tensor::set_alias_of(const TensorPtr &t, const SmallVector<int, max_rank> &storage_offset) {
+    set_storage(t->storage(), storage_offset);
+}
+
+void Tensor::set_storage(std::shared_ptr<TensorStorage> storage, const SmallVector<int, max_rank> &storage_offset) {
     assert(!is_dynamic());
 
-    storage_ = t->storage();
+    storage_ = std::move(storage);
     storage_offset_ = storage_offset;
 
     Box offset_bounds = bounds();
@@ -218,6 +235,15 @@ void Tensor::set_alias_of(const TensorPtr &t, const SmallVector<int, max_rank> &
     storage_->add_use(type(), offset_bounds);
 }
 
+void Tensor::set_crop_of(const Tensor &t, const Box &crop) {
+    assert(t.is_allocated());
+    assert((int)crop.size() == t.rank());
+    buffer_ = drop_reference(t.buffer_);
+    for (int i = 0; i < (int)crop.size(); i++) {
+        buffer_.crop(i, crop[i].min, crop[i].extent());
+    }
+}
+
 void Tensor::replace_all_consumers_with(const TensorPtr &other) {
     // We need to make a copy of the list of consumers so it doesn't get invalidated
     // by set_input below.
@@ -308,7 +334,313 @@ void Op::set_output(TensorPtr t) {
     set_output(0, std::move(t));
 }
 
+namespace {
+
+struct MemoryAccess {
+    const char *begin, *end;
+    bool write;
+
+    bool conflicts_with(const MemoryAccess &other) const {
+        return (write || other.write) && begin < other.end && other.begin < end;
+    }
+};
+
+// Find the memory accessed by an op, including by the ops inside it if it
+// is an OpGroup.
+class FindMemoryAccesses : public OpVisitor {
+    void visit(OpGroup *g) {
+        for (int i = 0; i < g->op_count(); i++) {
+            add(g->op(i));
+        }
+    }
+
+    void add(const TensorPtr &t, bool write) {
+        if (t->is_dynamic()) {
+            // The memory of a dynamic tensor changes when it is resized,
+            // so identify it by the tensor itself instead.
+            const char *id = (const char *)t.get();
+            accesses.push_back({id, id + 1, write});
+            return;
+        }
+
+        const halide_buffer_t *buf = t->raw_buffer();
+        int64_t lo = 0, hi = 0;
+        for (int i = 0; i < buf->dimensions; i++) {
+            const int64_t last = (int64_t)(buf->dim[i].extent - 1) * buf->dim[i].stride;
+            if (last < 0) {
+                lo += last;
+            } else {
+                hi += last;
+            }
+        }
+        const int bytes = buf->type.bytes();
+        const char *host = (const char *)buf->host;
+        accesses.push_back({host + lo * bytes, host + (hi + 1) * bytes, write});
+    }
+
+public:
+    std::vector<MemoryAccess> accesses;
+
+    void add(Op *op) {
+        for (int i = 0; i < op->input_count(); i++) {
+            add(op->input(i), false);
+        }
+        for (int i = 0; i < op->output_count(); i++) {
+            add(op->output(i), true);
+        }
+        op->accept(this);
+    }
+};
+
+// The state shared by the tasks executing the ops of an OpGroup
+// concurrently. A task of the Halide thread pool can be picked up by any
+// thread waiting in the pool, including one in the middle of executing an
+// op, so tasks must never wait for each other. Instead, each task executes
+// ready ops, earliest first, until there are none left, and then returns.
+// A task that makes more ops ready than it can execute itself starts more
+// tasks to execute them, up to the limit on concurrent ops.
+struct ConcurrentExecution {
+    OpGroup *group;
+    const std::vector<std::vector<int>> &successors;
+    std::vector<int> waiting_for;
+    const int max_tasks;
+
+    std::mutex mutex;
+    std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+    // The number of tasks executing ops, including those about to start.
+    int active_tasks = 0;
+
+    ConcurrentExecution(OpGroup *group, const std::vector<std::vector<int>> &successors,
+                        const std::vector<int> &predecessor_count, int max_tasks)
+        : group(group), successors(successors), waiting_for(predecessor_count), max_tasks(max_tasks) {
+        for (int i = 0; i < group->op_count(); i++) {
+            if (waiting_for[i] == 0) {
+                ready.push(i);
+            }
+        }
+    }
+
+    // Execute all of the ops, returning when they are done.
+    void execute() {
+        active_tasks = std::min((int)ready.size(), max_tasks);
+        start_tasks(active_tasks);
+    }
+
+    // Returns when all n tasks have returned. The calling thread helps
+    // execute them.
+    void start_tasks(int n) {
+        halide_do_par_for(nullptr, task, 0, n, (uint8_t *)this);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!ready.empty()) {
+            const int i = ready.top();
+            ready.pop();
+
+            lock.unlock();
+            group->op(i)->execute();
+            lock.lock();
+
+            for (int j : successors[i]) {
+                if (--waiting_for[j] == 0) {
+                    ready.push(j);
+                }
+            }
+
+            const int more_tasks = std::min((int)ready.size() - 1, max_tasks - active_tasks);
+            if (more_tasks > 0) {
+                // One of the new tasks takes over from this one.
+                active_tasks += more_tasks;
+                lock.unlock();
+                start_tasks(more_tasks + 1);
+                return;
+            }
+        }
+        // Any op made ready from now on is made ready by a task that is
+        // still running, which will execute it.
+        active_tasks--;
+    }
+
+    static int task(void *user_context, int index, uint8_t *closure) {
+        ((ConcurrentExecution *)closure)->run();
+        return 0;
+    }
+};
+
+}  // namespace
+
+void OpGroup::set_max_concurrent_ops(int n) {
+    max_concurrent_ops_ = n;
+    successors_.assign(op_count(), {});
+    predecessor_count_.assign(op_count(), 0);
+    if (n <= 1) {
+        return;
+    }
+
+    std::vector<std::vector<MemoryAccess>> accesses(op_count());
+    for (int i = 0; i < op_count(); i++) {
+        FindMemoryAccesses find_accesses;
+        find_accesses.add(op(i));
+        accesses[i] = std::move(find_accesses.accesses);
+    }
+
+    for (int j = 0; j < op_count(); j++) {
+        for (int i = 0; i < j; i++) {
+            bool depends = false;
+            for (const MemoryAccess &a : accesses[i]) {
+                for (const MemoryAccess &b : accesses[j]) {
+                    depends = depends || a.conflicts_with(b);
+                }
+            }
+            if (depends) {
+                successors_[i].push_back(j);
+                predecessor_count_[j]++;
+            }
+        }
+    }
+}
+
+void OpGroup::execute_concurrently() {
+    ConcurrentExecution execution(this, successors_, predecessor_count_, max_concurrent_ops_);
+    execution.execute();
+}
+
+// The ops used to execute the tiles of a tiled OpGroup. These are copies
+// of the ops in the group, referring to views of the tensors, so cropping
+// the views to a tile doesn't affect anything else using the tensors.
+struct OpGroup::TiledExecution {
+    std::vector<OpPtr> ops;
+    // The bounds required of each input of each op, and the index of the op
+    // in the group that produces it, or -1 if it is an input of the group.
+    std::vector<std::vector<BoundsMap>> input_bounds;
+    std::vector<std::vector<int>> input_producer;
+
+    explicit TiledExecution(OpGroup *group) {
+        TensorMap views;
+        auto make_view = [&](const TensorPtr &t) {
+            if (!views.count(t)) {
+                views[t] = std::make_shared<Tensor>(t->name(), t->type(), t->bounds(), t->quantization());
+            }
+        };
+        for (int i = 0; i < group->op_count(); i++) {
+            Op *op = group->op(i);
+            input_bounds.emplace_back();
+            input_producer.emplace_back();
+            for (int j = 0; j < op->input_count(); j++) {
+                make_view(op->input(j));
+                input_bounds.back().push_back(op->map_bounds(j, 0));
+                int producer = -1;
+                for (int k = 0; k < i; k++) {
+                    if (group->op(k)->output() == op->input(j)) {
+                        producer = k;
+                    }
+                }
+                input_producer.back().push_back(producer);
+            }
+            make_view(op->output());
+            ops.push_back(op->clone(views));
+        }
+    }
+};
+
+OpGroup::OpGroup(std::vector<TensorPtr> inputs, std::vector<TensorPtr> outputs, std::vector<OpPtr> ops)
+    : Op(std::move(inputs), std::move(outputs)), ops_(std::move(ops)) {
+}
+
+OpGroup::~OpGroup() {
+}
+
+void OpGroup::set_tiling(int dim, int extent) {
+    assert(extent > 0);
+    assert(output_count() == 1);
+    assert(op_count() > 0 && op(op_count() - 1)->output() == output());
+    tile_dim_ = dim;
+    tile_extent_ = extent;
+    tiled_execution_ = nullptr;
+}
+
+void OpGroup::execute_tiled() {
+    if (!tiled_execution_) {
+        tiled_execution_.reset(new TiledExecution(this));
+    }
+    const TiledExecution &tiled = *tiled_execution_;
+    const int n = op_count();
+
+    // The intermediate tensors are stored in full, so the rows of them
+    // computed for one tile don't need to be computed again for the next.
+    // Track the last row of each op's output computed so far.
+    std::vector<int> done(n);
+    for (int i = 0; i < n; i++) {
+        done[i] = op(i)->output()->bounds(tile_dim_).min - 1;
+    }
+
+    std::vector<Box> crops(n);
+    const Interval rows = output()->bounds(tile_dim_);
+    for (int y = rows.min; y <= rows.max; y += tile_extent_) {
+        // Working backwards from the tile of the output, find the region of
+        // each op's output needed for this tile, and not already computed.
+        for (Box &crop : crops) {
+            crop.clear();
+        }
+        crops[n - 1] = output()->bounds();
+        crops[n - 1][tile_dim_] = Interval(y, std::min(y + tile_extent_ - 1, rows.max));
+        for (int i = n - 1; i >= 0; i--) {
+            Box &crop = crops[i];
+            if (crop.empty()) {
+                continue;
+            }
+            crop[tile_dim_].min = std::max(crop[tile_dim_].min, done[i] + 1);
+            if (crop[tile_dim_].empty()) {
+                crop.clear();
+                continue;
+            }
+            for (int j = 0; j < op(i)->input_count(); j++) {
+                const int producer = tiled.input_producer[i][j];
+                if (producer < 0) {
+                    continue;
+                }
+                Box required = tiled.input_bounds[i][j].evaluate(crop);
+                required = intersect(required, op(producer)->output()->bounds());
+                crops[producer] = crops[producer].empty() ? required : Union(crops[producer], required);
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (crops[i].empty()) {
+                continue;
+            }
+            Op *op_i = op(i);
+            Op *tile_op = tiled.ops[i].get();
+            for (int j = 0; j < op_i->input_count(); j++) {
+                // Crop the inputs to the region required, except for dimensions that
+                // are broadcast, or that need more than the tensor has (which the
+                // ops handle themselves, e.g. by requiring an aligned extent).
+                Box required = tiled.input_bounds[i][j].evaluate(crops[i]);
+                Box crop = op_i->input(j)->bounds();
+                for (int d = 0; d < (int)crop.size(); d++) {
+                    if (crop[d].extent() > 1 && is_subset_of(required[d], crop[d])) {
+                        crop[d] = required[d];
+                    }
+                }
+                tile_op->input(j)->set_crop_of(*op_i->input(j), crop);
+            }
+            tile_op->output()->set_crop_of(*op_i->output(), crops[i]);
+            tile_op->execute();
+            done[i] = crops[i][tile_dim_].max;
+        }
+    }
+}
+
 void OpGroup::execute() {
+    if (is_tiled()) {
+        execute_tiled();
+        return;
+    }
+    if (max_concurrent_ops_ > 1 && (int)predecessor_count_.size() == op_count()) {
+        execute_concurrently();
+        return;
+    }
     for (int i = 0; i < op_count(); i++) {
         op(i)->execute();
     }
@@ -321,6 +653,9 @@ BoundsMap OpGroup::map_bounds(int input_idx, int output_idx) const {
 }
 
 void OpGroup::add(OpPtr to_add, const Op *before) {
+    // The dependencies between the ops are out of date.
+    set_max_concurrent_ops(1);
+    tiled_execution_ = nullptr;
     for (auto i = ops_.begin(); i != ops_.end(); ++i) {
         if (i->get() == before) {
             ops_.insert(i, std::move(to_add));
@@ -341,6 +676,9 @@ void OpGroup::add(OpPtr to_add, const Op *before) {
 }
 
 void OpGroup::remove(const Op *op) {
+    // The dependencies between the ops are out of date.
+    set_max_concurrent_ops(1);
+    tiled_execution_ = nullptr;
     for (auto i = ops_.begin(); i != ops_.end(); ++i) {
         if (i->get() == op) {
             ops_.erase(i);
@@ -364,7 +702,11 @@ OpPtr OpGroup::clone(TensorMap &tensor_map) const {
         ops.push_back(op(i)->clone(tensor_map));
     }
 
-    return make_op<OpGroup>(std::move(inputs), std::move(outputs), std::move(ops));
+    std::unique_ptr<OpGroup> result = make_op<OpGroup>(std::move(inputs), std::move(outputs), std::move(ops));
+    if (is_tiled()) {
+        result->set_tiling(tile_dim_, tile_extent_);
+    }
+    return std::move(result);
 }
 
 void OpGroup::accept(OpVisitor *v) {
@@ -372,7 +714,11 @@ void OpGroup::accept(OpVisitor *v) {
 }
 
 void OpGroup::dump(std::ostream &os) const {
-    os << "Ops: " << std::endl;
+    os << "Ops: ";
+    if (is_tiled()) {
+        os << "(tiles of " << tile_extent_ << " in dimension " << tile_dim_ << ")";
+    }
+    os << std::endl;
     for (const auto &i : ops_) {
         i->dump(os);
     }
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -44,6 +45,9 @@ inline std::ostream &operator<<(std::ostream &s, const QuantizationInfo &q) {
 // buffer.
 class TensorStorage {
     HalideBuffer<void> buffer_;
+    // If this storage was allocated from an arena shared with other
+    // storage, keeps the arena alive.
+    HalideBuffer<void> arena_;
 
 public:
     TensorStorage();
@@ -76,6 +80,17 @@ public:
 
     bool is_allocated() const;
     void allocate();
+    // Use the memory at `offset` bytes into `arena` for this storage.
+    void allocate_from(const HalideBuffer<void> &arena, size_t offset);
+
+    size_t size_in_bytes() const {
+        return buffer_.size_in_bytes();
+    }
+
+    // The arena this storage was allocated from, if any.
+    const HalideBuffer<void> &arena() const {
+        return arena_;
+    }
 };
 
 class Op;
@@ -211,6 +226,16 @@ public:
     bool is_alias() const;
     void set_alias_of(const TensorPtr &t, const SmallVector<int, max_rank> &offset = {});
 
+    // Use `storage` for this tensor, at `offset` in the storage's coordinates.
+    void set_storage(std::shared_ptr<TensorStorage> storage, const SmallVector<int, max_rank> &offset = {});
+    const SmallVector<int, max_rank> &storage_offset() const {
+        return storage_offset_;
+    }
+
+    // Make this tensor refer to the region `crop` of the buffer of `t`. This
+    // is used to execute ops on part of their outputs.
+    void set_crop_of(const Tensor &t, const Box &crop);
+
     void add_consumer(Op *op);
     void add_producer(Op *op);
     void remove_consumer(Op *op);
@@ -545,10 +570,26 @@ public:
 class OpGroup : public Op {
     std::vector<OpPtr> ops_;
 
+    // When executing ops concurrently, the ops that must wait for each op,
+    // and the number of ops each op must wait for.
+    int max_concurrent_ops_ = 1;
+    std::vector<std::vector<int>> successors_;
+    std::vector<int> predecessor_count_;
+
+    void execute_concurrently();
+
+    // When executing the ops one tile at a time, the dimension and extent
+    // of the tiles of the output, and the state used to execute them.
+    int tile_dim_ = -1;
+    int tile_extent_ = 0;
+    struct TiledExecution;
+    std::unique_ptr<TiledExecution> tiled_execution_;
+
+    void execute_tiled();
+
 public:
-    OpGroup(std::vector<TensorPtr> inputs, std::vector<TensorPtr> outputs, std::vector<OpPtr> ops = {})
-        : Op(std::move(inputs), std::move(outputs)), ops_(std::move(ops)) {
-    }
+    OpGroup(std::vector<TensorPtr> inputs, std::vector<TensorPtr> outputs, std::vector<OpPtr> ops = {});
+    ~OpGroup();
 
     void add(OpPtr to_insert, const Op *before = nullptr);
     void remove(const Op *op);
@@ -557,6 +598,29 @@ public:
 
     void execute();
 
+    // Allow up to `n` ops that don't depend on each other to execute at the
+    // same time, on the Halide thread pool. An op depends on an earlier op
+    // if they access overlapping memory, and at least one of them writes
+    // to it. This must be called after the tensors are allocated, and again
+    // after any changes to the ops.
+    void set_max_concurrent_ops(int n);
+
+    // Execute the ops one tile of the output at a time, where each tile
+    // covers `extent` coordinates of dimension `dim`, so the intermediate
+    // tensors are used soon after they are produced. The ops must be a
+    // chain that can execute on a crop of their outputs, where the last op
+    // produces the output of this group.
+    void set_tiling(int dim, int extent);
+    bool is_tiled() const {
+        return tile_extent_ > 0;
+    }
+    int tile_dim() const {
+        return tile_dim_;
+    }
+    int tile_extent() const {
+        return tile_extent_;
+    }
+
     int op_count() const {
         return ops_.size();
     }
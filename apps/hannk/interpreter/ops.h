@@ -60,6 +60,13 @@ public:
             apply(map, output()), op_, activation_);
     }
 
+    Operator op() const {
+        return op_;
+    }
+    ActivationFunction activation() const {
+        return activation_;
+    }
+
     void accept(OpVisitor *v);
 
     void execute();
@@ -94,6 +101,10 @@ public:
             std::move(inputs), apply(map, output()), axis_);
     }
 
+    bool is_no_op() const {
+        return is_no_op_;
+    }
+
     void accept(OpVisitor *v);
 
     BoundsMap map_bounds(int input_idx, int output_idx) const;
@@ -128,6 +139,19 @@ public:
             apply(map, output()), stride_, dilation_, padding_, activation_);
     }
 
+    const std::array<int, 2> &stride() const {
+        return stride_;
+    }
+    const std::array<int, 2> &dilation() const {
+        return dilation_;
+    }
+    Padding padding() const {
+        return padding_;
+    }
+    ActivationFunction activation() const {
+        return activation_;
+    }
+
     void accept(OpVisitor *v);
 
     const TensorPtr &filter() const {
@@ -182,6 +206,22 @@ public:
             padding_, activation_);
     }
 
+    int depth_multiplier() const {
+        return depth_multiplier_;
+    }
+    const std::array<int, 2> &stride() const {
+        return stride_;
+    }
+    const std::array<int, 2> &dilation() const {
+        return dilation_;
+    }
+    Padding padding() const {
+        return padding_;
+    }
+    ActivationFunction activation() const {
+        return activation_;
+    }
+
     void accept(OpVisitor *v);
 
     const TensorPtr &filter() const {
@@ -224,12 +264,16 @@ public:
             inputs.push_back(apply(map, input(i)));
         }
         for (int i = 0; i < output_count(); i++) {
-            inputs.push_back(apply(map, output(i)));
+            outputs.push_back(apply(map, output(i)));
         }
         return make_op<ElementwiseProgramOp>(
             std::move(inputs), std::move(outputs), program_);
     }
 
+    const Halide::Runtime::Buffer<int16_t> &program() const {
+        return program_;
+    }
+
     void accept(OpVisitor *v);
 
     void execute();
@@ -254,6 +298,10 @@ public:
             apply(map, output()), activation_);
     }
 
+    ActivationFunction activation() const {
+        return activation_;
+    }
+
     void accept(OpVisitor *v);
 
     const TensorPtr &filter() const {
@@ -290,6 +338,10 @@ public:
         return make_op<GatherOp>(apply(map, input(0)), apply(map, input(1)), apply(map, output()), axis_);
     }
 
+    int axis() const {
+        return axis_;
+    }
+
     void accept(OpVisitor *v);
 
     BoundsMap map_bounds(int input_idx, int output_idx) const;
@@ -389,6 +441,16 @@ public:
 
     BoundsMap map_bounds(int input_idx, int output_idx) const;
 
+    const std::array<int, 2> &stride() const {
+        return stride_;
+    }
+    const std::array<int, 2> &filter_size() const {
+        return filter_size_;
+    }
+    ActivationFunction activation() const {
+        return activation_;
+    }
+
     void accept(OpVisitor *v);
 
     void execute();
@@ -423,6 +485,10 @@ public:
 
     BoundsMap map_bounds(int input_idx, int output_idx) const;
 
+    Operator op() const {
+        return op_;
+    }
+
     void accept(OpVisitor *v);
 
     void execute();
@@ -491,6 +557,10 @@ public:
         return make_op<SoftmaxOp>(apply(map, input()), apply(map, output()), beta_);
     }
 
+    float beta() const {
+        return beta_;
+    }
+
     void accept(OpVisitor *v);
 
     BoundsMap map_bounds(int input_idx, int output_idx) const;
@@ -514,6 +584,10 @@ public:
         return make_op<SpaceDepthOp>(apply(map, input()), apply(map, output()), block_size_);
     }
 
+    int block_size() const {
+        return block_size_;
+    }
+
     void accept(OpVisitor *v);
 
     BoundsMap map_bounds(int input_idx, int output_idx) const;
@@ -551,6 +625,10 @@ public:
         is_no_op_ = true;
     }
 
+    bool is_no_op() const {
+        return is_no_op_;
+    }
+
     void accept(OpVisitor *v);
 
     BoundsMap map_bounds(int input_idx, int output_idx) const;
@@ -631,6 +709,10 @@ public:
             apply(map, input()), apply(map, output()), op_);
     }
 
+    Operator op() const {
+        return op_;
+    }
+
     void accept(OpVisitor *v);
 
     void execute();
@@ -0,0 +1,693 @@
+#include "interpreter/prepared_model.h"
+#include "interpreter/ops.h"
+#include "util/error_util.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+
+namespace hannk {
+
+namespace {
+
+// A prepared model file is:
+//
+//   - A header, with the magic string, and the size and offset of the
+//     sections that follow.
+//   - The graph: the storage of the tensors, the tensors, and the ops,
+//     in the native byte order.
+//   - The data of the constant tensors. Each constant is aligned to
+//     `data_alignment` bytes from the start of the file.
+//
+// Changes to the format must change the magic string.
+const char magic[8] = {'H', 'A', 'N', 'N', 'K', 'P', 'M', '1'};
+
+struct Header {
+    char magic[8];
+    int64_t graph_size;
+    int64_t data_offset;
+};
+
+// The same alignment the interpreter uses for tensor memory.
+constexpr size_t data_alignment = 128;
+
+enum class OpTag : int32_t {
+    Binary,
+    Concatenation,
+    Conv2D,
+    DepthwiseConv2D,
+    ElementwiseProgram,
+    FullyConnected,
+    Gather,
+    L2Normalization,
+    Pad,
+    Pool2D,
+    Reduction,
+    Reshape,
+    Shape,
+    Softmax,
+    SpaceDepth,
+    Split,
+    TileConvFilter,
+    Transpose,
+    Unary,
+    Group,
+};
+
+class Writer {
+    std::vector<char> graph_;
+    std::vector<char> data_;
+
+public:
+    template<typename T>
+    void write(const T &value) {
+        const char *p = (const char *)&value;
+        graph_.insert(graph_.end(), p, p + sizeof(T));
+    }
+
+    void write(const std::string &s) {
+        write<int32_t>(s.size());
+        graph_.insert(graph_.end(), s.begin(), s.end());
+    }
+
+    // Write the dimensions of `buf`.
+    void write_dims(const halide_buffer_t *buf) {
+        write<int32_t>(buf->dimensions);
+        for (int i = 0; i < buf->dimensions; i++) {
+            write<int32_t>(buf->dim[i].min);
+            write<int32_t>(buf->dim[i].extent);
+            write<int32_t>(buf->dim[i].stride);
+        }
+    }
+
+    // Add `size` bytes to the data section, and return their offset
+    // from the start of the data section.
+    int64_t add_data(const void *data, size_t size) {
+        size_t offset = align_up(data_.size(), data_alignment);
+        data_.resize(offset + size);
+        memcpy(data_.data() + offset, data, size);
+        return offset;
+    }
+
+    void save(const std::string &filename) const {
+        Header header;
+        memcpy(header.magic, magic, sizeof(magic));
+        header.graph_size = graph_.size();
+        header.data_offset = align_up(sizeof(Header) + graph_.size(), data_alignment);
+
+        std::ofstream f(filename, std::ios::out | std::ios::binary);
+        HCHECK(f.is_open()) << "Unable to open file: " << filename;
+        f.write((const char *)&header, sizeof(header));
+        f.write(graph_.data(), graph_.size());
+        std::vector<char> padding(header.data_offset - sizeof(Header) - graph_.size(), 0);
+        f.write(padding.data(), padding.size());
+        f.write(data_.data(), data_.size());
+        HCHECK(f.good()) << "Unable to write file: " << filename;
+    }
+};
+
+class Reader {
+    const char *p_;
+    const char *end_;
+
+public:
+    Reader(const char *begin, const char *end)
+        : p_(begin), end_(end) {
+    }
+
+    template<typename T>
+    T read() {
+        HCHECK(end_ - p_ >= (ptrdiff_t)sizeof(T)) << "Prepared model is truncated.";
+        T result;
+        memcpy(&result, p_, sizeof(T));
+        p_ += sizeof(T);
+        return result;
+    }
+
+    std::string read_string() {
+        int32_t size = read<int32_t>();
+        HCHECK(size >= 0 && end_ - p_ >= size) << "Prepared model is truncated.";
+        std::string result(p_, size);
+        p_ += size;
+        return result;
+    }
+
+    SmallVector<halide_dimension_t, max_rank> read_dims() {
+        int32_t rank = read<int32_t>();
+        HCHECK(rank >= 0 && rank <= max_rank) << "Invalid rank " << rank << " in prepared model.";
+        SmallVector<halide_dimension_t, max_rank> dims(rank);
+        for (int i = 0; i < rank; i++) {
+            dims[i].min = read<int32_t>();
+            dims[i].extent = read<int32_t>();
+            dims[i].stride = read<int32_t>();
+        }
+        return dims;
+    }
+};
+
+// Find the tensors used by a model, in the order they are first used.
+class FindTensors : public OpVisitor {
+    std::set<Tensor *> found_;
+
+    void add_tensor(const TensorPtr &t) {
+        if (t && found_.insert(t.get()).second) {
+            tensors.push_back(t);
+        }
+    }
+
+    void visit(OpGroup *g) {
+        for (int i = 0; i < g->op_count(); i++) {
+            Op *op = g->op(i);
+            add(op);
+            op->accept(this);
+        }
+    }
+
+public:
+    std::vector<TensorPtr> tensors;
+
+    void add(Op *op) {
+        for (int i = 0; i < op->input_count(); i++) {
+            add_tensor(op->input(i));
+        }
+        for (int i = 0; i < op->output_count(); i++) {
+            add_tensor(op->output(i));
+        }
+    }
+};
+
+class PreparedModelWriter : public OpVisitor {
+    Writer &w_;
+    std::map<TensorStorage *, int> storage_ids_;
+    std::map<Tensor *, int> tensor_ids_;
+    int ops_written_ = 0;
+
+    void write_tensors(const std::vector<TensorPtr> &tensors) {
+        w_.write<int32_t>(tensors.size());
+        for (const TensorPtr &t : tensors) {
+            w_.write<int32_t>(t ? tensor_ids_.at(t.get()) : -1);
+        }
+    }
+
+    void write_op(Op *op, OpTag tag) {
+        std::vector<TensorPtr> inputs, outputs;
+        for (int i = 0; i < op->input_count(); i++) {
+            inputs.push_back(op->input(i));
+        }
+        for (int i = 0; i < op->output_count(); i++) {
+            outputs.push_back(op->output(i));
+        }
+        w_.write(tag);
+        write_tensors(inputs);
+        write_tensors(outputs);
+        ops_written_++;
+    }
+
+    void visit(BinaryOp *op) {
+        write_op(op, OpTag::Binary);
+        w_.write<int32_t>(op->op());
+        w_.write(op->activation());
+    }
+    void visit(ConcatenationOp *op) {
+        write_op(op, OpTag::Concatenation);
+        w_.write<int32_t>(op->axis());
+        w_.write<uint8_t>(op->is_no_op());
+    }
+    void visit(Conv2DOp *op) {
+        write_op(op, OpTag::Conv2D);
+        w_.write(op->stride());
+        w_.write(op->dilation());
+        w_.write(op->padding());
+        w_.write(op->activation());
+    }
+    void visit(DepthwiseConv2DOp *op) {
+        write_op(op, OpTag::DepthwiseConv2D);
+        w_.write<int32_t>(op->depth_multiplier());
+        w_.write(op->stride());
+        w_.write(op->dilation());
+        w_.write(op->padding());
+        w_.write(op->activation());
+    }
+    void visit(ElementwiseProgramOp *op) {
+        write_op(op, OpTag::ElementwiseProgram);
+        Halide::Runtime::Buffer<int16_t> program = op->program().copy();
+        w_.write_dims(program.raw_buffer());
+        w_.write<int64_t>(w_.add_data(program.data(), program.size_in_bytes()));
+    }
+    void visit(FullyConnectedOp *op) {
+        write_op(op, OpTag::FullyConnected);
+        w_.write(op->activation());
+    }
+    void visit(GatherOp *op) {
+        write_op(op, OpTag::Gather);
+        w_.write<int32_t>(op->axis());
+    }
+    void visit(L2NormalizationOp *op) {
+        write_op(op, OpTag::L2Normalization);
+    }
+    void visit(PadOp *op) {
+        write_op(op, OpTag::Pad);
+    }
+    void visit(Pool2DOp *op) {
+        write_op(op, OpTag::Pool2D);
+        w_.write(op->stride());
+        w_.write(op->filter_size());
+        w_.write(op->padding());
+        w_.write<int32_t>(op->op());
+        w_.write(op->activation());
+    }
+    void visit(ReductionOp *op) {
+        write_op(op, OpTag::Reduction);
+        w_.write<int32_t>(op->op());
+    }
+    void visit(ReshapeOp *op) {
+        write_op(op, OpTag::Reshape);
+    }
+    void visit(ShapeOp *op) {
+        write_op(op, OpTag::Shape);
+    }
+    void visit(SoftmaxOp *op) {
+        write_op(op, OpTag::Softmax);
+        w_.write(op->beta());
+    }
+    void visit(SpaceDepthOp *op) {
+        write_op(op, OpTag::SpaceDepth);
+        w_.write<int32_t>(op->block_size());
+    }
+    void visit(SplitOp *op) {
+        write_op(op, OpTag::Split);
+        w_.write<int32_t>(op->axis());
+        w_.write<uint8_t>(op->is_no_op());
+    }
+    void visit(TileConvFilterOp *op) {
+        write_op(op, OpTag::TileConvFilter);
+    }
+    void visit(TransposeOp *op) {
+        write_op(op, OpTag::Transpose);
+    }
+    void visit(UnaryOp *op) {
+        write_op(op, OpTag::Unary);
+        w_.write<int32_t>(op->op());
+    }
+    void visit(OpGroup *op) {
+        write_op(op, OpTag::Group);
+        w_.write<int32_t>(op->tile_dim());
+        w_.write<int32_t>(op->tile_extent());
+        w_.write<int32_t>(op->op_count());
+        for (int i = 0; i < op->op_count(); i++) {
+            write(op->op(i));
+        }
+    }
+
+    void write(Op *op) {
+        const int ops_written = ops_written_;
+        op->accept(this);
+        HCHECK(ops_written_ > ops_written) << "Unable to save op to a prepared model.";
+    }
+
+public:
+    explicit PreparedModelWriter(Writer &w)
+        : w_(w) {
+    }
+
+    void write_model(OpGroup *model) {
+        FindTensors find_tensors;
+        find_tensors.add(model);
+        model->accept(&find_tensors);
+        const std::vector<TensorPtr> &tensors = find_tensors.tensors;
+        for (int i = 0; i < (int)tensors.size(); i++) {
+            tensor_ids_[tensors[i].get()] = i;
+        }
+
+        // Find the storage of the tensors, and the arena it was allocated from.
+        std::vector<std::shared_ptr<TensorStorage>> storages;
+        for (const TensorPtr &t : tensors) {
+            if (t->is_constant() || t->is_dynamic()) {
+                continue;
+            }
+            HCHECK(t->is_allocated()) << "Tensor " << t->name() << " of a prepared model is not allocated.";
+            std::shared_ptr<TensorStorage> storage = t->storage();
+            if (!storage_ids_.count(storage.get())) {
+                storage_ids_[storage.get()] = storages.size();
+                storages.push_back(storage);
+            }
+        }
+        const void *arena = nullptr;
+        size_t arena_size = 0;
+        for (const auto &s : storages) {
+            if (s->arena().data()) {
+                HCHECK(!arena || arena == s->arena().data()) << "Tensors of a prepared model must use a single arena.";
+                arena = s->arena().data();
+                arena_size = s->arena().size_in_bytes();
+            }
+        }
+
+        w_.write<int64_t>(arena_size);
+        w_.write<int32_t>(storages.size());
+        for (const auto &s : storages) {
+            const HalideBuffer<void> &buf = s->buffer();
+            w_.write(buf.type());
+            w_.write_dims(buf.raw_buffer());
+            if (s->arena().data()) {
+                w_.write<int64_t>((const char *)buf.data() - (const char *)arena);
+            } else {
+                w_.write<int64_t>(-1);
+            }
+        }
+
+        w_.write<int32_t>(tensors.size());
+        for (const TensorPtr &t : tensors) {
+            w_.write(t->name());
+            w_.write(t->type());
+            uint8_t flags = (t->is_constant() ? 1 : 0) | (t->is_input() ? 2 : 0) |
+                            (t->is_output() ? 4 : 0) | (t->is_dynamic() ? 8 : 0);
+            w_.write(flags);
+
+            const QuantizationInfo &q = t->quantization();
+            w_.write<int32_t>(q.scale.size());
+            for (float i : q.scale) {
+                w_.write(i);
+            }
+            w_.write<int32_t>(q.zero.size());
+            for (int32_t i : q.zero) {
+                w_.write(i);
+            }
+            w_.write(q.dimension);
+
+            if (t->is_constant()) {
+                // Copy the constant to a dense buffer, to store only the
+                // elements of the tensor.
+                HalideBuffer<const void> buf = t->buffer();
+                HalideBuffer<void> dense = HalideBuffer<void>::make_with_shape_of(buf);
+                dense.copy_from(buf);
+                w_.write_dims(dense.raw_buffer());
+                w_.write<int64_t>(w_.add_data(dense.data(), dense.size_in_bytes()));
+            } else {
+                w_.write_dims(t->buffer().raw_buffer());
+                if (t->is_dynamic()) {
+                    w_.write<int32_t>(-1);
+                } else {
+                    w_.write<int32_t>(storage_ids_.at(t->storage().get()));
+                    const SmallVector<int, max_rank> &offset = t->storage_offset();
+                    w_.write<int32_t>(offset.size());
+                    for (int i : offset) {
+                        w_.write<int32_t>(i);
+                    }
+                }
+            }
+        }
+
+        write(model);
+    }
+};
+
+class PreparedModelReader {
+    Reader r_;
+    const char *data_;
+    const char *data_end_;
+    std::vector<TensorPtr> tensors_;
+
+    // Get a pointer to `size` bytes at `offset` in the data section.
+    const char *data_at(int64_t offset, size_t size) {
+        HCHECK(offset >= 0 && offset % data_alignment == 0 && (size_t)(data_end_ - data_) >= offset + size)
+            << "Invalid data offset in prepared model.";
+        return data_ + offset;
+    }
+
+    TensorPtr read_tensor() {
+        int32_t id = r_.read<int32_t>();
+        HCHECK(id >= -1 && id < (int)tensors_.size()) << "Invalid tensor " << id << " in prepared model.";
+        return id >= 0 ? tensors_[id] : nullptr;
+    }
+
+    std::vector<TensorPtr> read_tensors() {
+        int32_t count = r_.read<int32_t>();
+        HCHECK(count >= 0) << "Invalid tensor count in prepared model.";
+        std::vector<TensorPtr> result;
+        for (int i = 0; i < count; i++) {
+            result.push_back(read_tensor());
+        }
+        return result;
+    }
+
+    std::unique_ptr<OpGroup> read_group(std::vector<TensorPtr> inputs, std::vector<TensorPtr> outputs) {
+        int tile_dim = r_.read<int32_t>();
+        int tile_extent = r_.read<int32_t>();
+        int op_count = r_.read<int32_t>();
+        HCHECK(op_count >= 0) << "Invalid op count in prepared model.";
+        std::vector<OpPtr> ops;
+        for (int i = 0; i < op_count; i++) {
+            ops.push_back(read_op());
+        }
+        auto group = make_op<OpGroup>(std::move(inputs), std::move(outputs), std::move(ops));
+        if (tile_extent > 0) {
+            group->set_tiling(tile_dim, tile_extent);
+        }
+        return group;
+    }
+
+    OpPtr read_op() {
+        OpTag tag = r_.read<OpTag>();
+        std::vector<TensorPtr> inputs = read_tensors();
+        std::vector<TensorPtr> outputs = read_tensors();
+
+        // Check the number of inputs and outputs of ops that have a fixed number.
+        auto check_counts = [&](int input_count, int output_count) {
+            HCHECK((int)inputs.size() == input_count && (int)outputs.size() == output_count)
+                << "Invalid op in prepared model.";
+        };
+        switch (tag) {
+        case OpTag::Binary: {
+            check_counts(2, 1);
+            auto op = (BinaryOp::Operator)r_.read<int32_t>();
+            auto activation = r_.read<ActivationFunction>();
+            return make_op<BinaryOp>(inputs[0], inputs[1], outputs[0], op, activation);
+        }
+        case OpTag::Concatenation: {
+            check_counts(inputs.size(), 1);
+            int axis = r_.read<int32_t>();
+            bool is_no_op = r_.read<uint8_t>();
+            auto op = make_op<ConcatenationOp>(inputs, outputs[0], axis);
+            if (is_no_op) {
+                op->set_no_op();
+            }
+            return op;
+        }
+        case OpTag::Conv2D: {
+            check_counts(3, 1);
+            auto stride = r_.read<std::array<int, 2>>();
+            auto dilation = r_.read<std::array<int, 2>>();
+            auto padding = r_.read<Padding>();
+            auto activation = r_.read<ActivationFunction>();
+            return make_op<Conv2DOp>(inputs[0], inputs[1], inputs[2], outputs[0], stride, dilation, padding, activation);
+        }
+        case OpTag::DepthwiseConv2D: {
+            check_counts(3, 1);
+            int depth_multiplier = r_.read<int32_t>();
+            auto stride = r_.read<std::array<int, 2>>();
+            auto dilation = r_.read<std::array<int, 2>>();
+            auto padding = r_.read<Padding>();
+            auto activation = r_.read<ActivationFunction>();
+            return make_op<DepthwiseConv2DOp>(inputs[0], inputs[1], inputs[2], outputs[0], depth_multiplier,
+                                              stride, dilation, padding, activation);
+        }
+        case OpTag::ElementwiseProgram: {
+            auto dims = r_.read_dims();
+            HalideBuffer<int16_t> program(nullptr, (int)dims.size(), dims.data());
+            program.allocate();
+            memcpy(program.data(), data_at(r_.read<int64_t>(), program.size_in_bytes()), program.size_in_bytes());
+            return make_op<ElementwiseProgramOp>(inputs, outputs, program);
+        }
+        case OpTag::FullyConnected: {
+            check_counts(3, 1);
+            auto activation = r_.read<ActivationFunction>();
+            return make_op<FullyConnectedOp>(inputs[0], inputs[1], inputs[2], outputs[0], activation);
+        }
+        case OpTag::Gather: {
+            check_counts(2, 1);
+            int axis = r_.read<int32_t>();
+            return make_op<GatherOp>(inputs[0], inputs[1], outputs[0], axis);
+        }
+        case OpTag::L2Normalization:
+            check_counts(1, 1);
+            return make_op<L2NormalizationOp>(inputs[0], outputs[0]);
+        case OpTag::Pad:
+            check_counts(2, 1);
+            return make_op<PadOp>(inputs[0], inputs[1], outputs[0]);
+        case OpTag::Pool2D: {
+            check_counts(1, 1);
+            auto stride = r_.read<std::array<int, 2>>();
+            auto filter_size = r_.read<std::array<int, 2>>();
+            auto padding = r_.read<Padding>();
+            auto op = (Pool2DOp::Operator)r_.read<int32_t>();
+            auto activation = r_.read<ActivationFunction>();
+            return make_op<Pool2DOp>(inputs[0], outputs[0], stride, filter_size, padding, op, activation);
+        }
+        case OpTag::Reduction: {
+            check_counts(2, 1);
+            auto op = (ReductionOp::Operator)r_.read<int32_t>();
+            return make_op<ReductionOp>(inputs[0], inputs[1], outputs[0], op);
+        }
+        case OpTag::Reshape:
+            check_counts(2, 1);
+            return make_op<ReshapeOp>(inputs[0], inputs[1], outputs[0]);
+        case OpTag::Shape:
+            check_counts(1, 1);
+            return make_op<ShapeOp>(inputs[0], outputs[0]);
+        case OpTag::Softmax: {
+            check_counts(1, 1);
+            float beta = r_.read<float>();
+            return make_op<SoftmaxOp>(inputs[0], outputs[0], beta);
+        }
+        case OpTag::SpaceDepth: {
+            check_counts(1, 1);
+            int block_size = r_.read<int32_t>();
+            return make_op<SpaceDepthOp>(inputs[0], outputs[0], block_size);
+        }
+        case OpTag::Split: {
+            check_counts(1, outputs.size());
+            int axis = r_.read<int32_t>();
+            bool is_no_op = r_.read<uint8_t>();
+            auto op = make_op<SplitOp>(inputs[0], outputs, axis);
+            if (is_no_op) {
+                op->set_no_op();
+            }
+            return op;
+        }
+        case OpTag::TileConvFilter:
+            check_counts(1, 1);
+            return make_op<TileConvFilterOp>(inputs[0], outputs[0]);
+        case OpTag::Transpose:
+            check_counts(2, 1);
+            return make_op<TransposeOp>(inputs[0], inputs[1], outputs[0]);
+        case OpTag::Unary: {
+            check_counts(1, 1);
+            auto op = (UnaryOp::Operator)r_.read<int32_t>();
+            return make_op<UnaryOp>(inputs[0], outputs[0], op);
+        }
+        case OpTag::Group:
+            return read_group(inputs, outputs);
+        }
+        HLOG(FATAL) << "Unknown op " << (int)tag << " in prepared model.";
+        return nullptr;
+    }
+
+public:
+    PreparedModelReader(const char *graph, const char *graph_end, const char *data, const char *data_end)
+        : r_(graph, graph_end), data_(data), data_end_(data_end) {
+    }
+
+    std::unique_ptr<OpGroup> read_model() {
+        int64_t arena_size = r_.read<int64_t>();
+        HCHECK(arena_size >= 0) << "Invalid arena size in prepared model.";
+
+        // Make the storage of the tensors. We can't allocate it from the
+        // arena until the tensors using it have been added.
+        int32_t storage_count = r_.read<int32_t>();
+        std::vector<std::shared_ptr<TensorStorage>> storages;
+        std::vector<int64_t> arena_offsets;
+        for (int i = 0; i < storage_count; i++) {
+            halide_type_t type = r_.read<halide_type_t>();
+            auto dims = r_.read_dims();
+            storages.push_back(std::make_shared<TensorStorage>(
+                HalideBuffer<void>(type, nullptr, (int)dims.size(), dims.data())));
+            arena_offsets.push_back(r_.read<int64_t>());
+        }
+
+        int32_t tensor_count = r_.read<int32_t>();
+        for (int i = 0; i < tensor_count; i++) {
+            std::string name = r_.read_string();
+            halide_type_t type = r_.read<halide_type_t>();
+            uint8_t flags = r_.read<uint8_t>();
+
+            QuantizationInfo q;
+            q.scale.resize(r_.read<int32_t>());
+            for (float &j : q.scale) {
+                j = r_.read<float>();
+            }
+            q.zero.resize(r_.read<int32_t>());
+            for (int32_t &j : q.zero) {
+                j = r_.read<int32_t>();
+            }
+            q.dimension = r_.read<int32_t>();
+
+            auto dims = r_.read_dims();
+            TensorPtr t;
+            if (flags & 1) {
+                // Use the constant data in place.
+                HalideBuffer<void> buf(type, nullptr, (int)dims.size(), dims.data());
+                const char *data = data_at(r_.read<int64_t>(), buf.size_in_bytes());
+                buf = HalideBuffer<void>(type, const_cast<char *>(data), (int)dims.size(), dims.data());
+                t = std::make_shared<Tensor>(name, buf, q);
+                t->set_constant();
+            } else {
+                Box bounds;
+                for (const halide_dimension_t &d : dims) {
+                    bounds.emplace_back(d.min, d.min + d.extent - 1);
+                }
+                t = std::make_shared<Tensor>(name, type, bounds, q);
+                if (flags & 8) {
+                    t->set_dynamic();
+                    HCHECK(r_.read<int32_t>() == -1) << "Dynamic tensor " << name << " has storage in prepared model.";
+                } else {
+                    int32_t storage_id = r_.read<int32_t>();
+                    HCHECK(storage_id >= 0 && storage_id < storage_count) << "Invalid storage for tensor " << name << " in prepared model.";
+                    SmallVector<int, max_rank> offset(r_.read<int32_t>());
+                    HCHECK(offset.size() <= dims.size()) << "Invalid storage offset for tensor " << name << " in prepared model.";
+                    for (int &j : offset) {
+                        j = r_.read<int32_t>();
+                    }
+                    HCHECK(storages[storage_id]->type() == type) << "Invalid storage for tensor " << name << " in prepared model.";
+                    t->set_storage(storages[storage_id], offset);
+                }
+            }
+            t->set_input((flags & 2) != 0);
+            t->set_output((flags & 4) != 0);
+            tensors_.push_back(t);
+        }
+
+        if (arena_size > 0) {
+            HalideBuffer<void> arena = HalideBuffer<uint8_t>((int)arena_size);
+            for (int i = 0; i < storage_count; i++) {
+                if (arena_offsets[i] >= 0) {
+                    HCHECK(arena_offsets[i] + storages[i]->size_in_bytes() <= (size_t)arena_size)
+                        << "Invalid arena offset in prepared model.";
+                    storages[i]->allocate_from(arena, arena_offsets[i]);
+                }
+            }
+        }
+
+        HCHECK(r_.read<OpTag>() == OpTag::Group) << "Prepared model is not an OpGroup.";
+        std::vector<TensorPtr> inputs = read_tensors();
+        std::vector<TensorPtr> outputs = read_tensors();
+        return read_group(std::move(inputs), std::move(outputs));
+    }
+};
+
+}  // namespace
+
+void save_prepared_model(OpGroup *model, const std::string &filename) {
+    Writer w;
+    PreparedModelWriter writer(w);
+    writer.write_model(model);
+    w.save(filename);
+}
+
+std::unique_ptr<OpGroup> load_prepared_model(const void *data, size_t size) {
+    const char *begin = (const char *)data;
+    HCHECK(size >= sizeof(Header)) << "Prepared model is truncated.";
+    Header header;
+    memcpy(&header, begin, sizeof(Header));
+    HCHECK(memcmp(header.magic, magic, sizeof(magic)) == 0) << "Not a prepared model, or a prepared model from a different version of hannk.";
+    HCHECK(header.graph_size >= 0 && header.data_offset >= (int64_t)sizeof(Header) + header.graph_size &&
+           (size_t)header.data_offset <= size)
+        << "Prepared model is truncated.";
+    HCHECK((uintptr_t)begin % data_alignment == 0) << "Prepared model is not aligned.";
+
+    PreparedModelReader reader(begin + sizeof(Header), begin + sizeof(Header) + header.graph_size,
+                               begin + header.data_offset, begin + size);
+    return reader.read_model();
+}
+
+}  // namespace hannk
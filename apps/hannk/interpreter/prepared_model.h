@@ -0,0 +1,32 @@
+#ifndef HANNK_PREPARED_MODEL_H
+#define HANNK_PREPARED_MODEL_H
+
+#include <memory>
+#include <string>
+
+#include "interpreter/model.h"
+
+namespace hannk {
+
+// A prepared model is a model after the transforms done by the Interpreter,
+// with its memory plan, stored so it can be executed without parsing or
+// transforming it again. The file holds the ops and tensors of the model,
+// the data of the constant tensors (including the tiled convolution
+// filters), and the offset of each tensor's storage in the memory arena.
+// Constant data is aligned, so a model loaded from a memory mapping of the
+// file can use it in place.
+//
+// Prepared models are specific to the hannk build and target that made them.
+
+// Write `model`, which must have been prepared by an Interpreter, to `filename`.
+void save_prepared_model(OpGroup *model, const std::string &filename);
+
+// Load a prepared model from `data`, which holds the contents of a file
+// written by save_prepared_model. The constant tensors of the model refer
+// to `data`, which must outlive the model. The tensors are allocated from
+// an arena, as planned when the model was prepared.
+std::unique_ptr<OpGroup> load_prepared_model(const void *data, size_t size);
+
+}  // namespace hannk
+
+#endif  // HANNK_PREPARED_MODEL_H
@@ -0,0 +1,80 @@
+#include "interpreter/request_batcher.h"
+#include "util/error_util.h"
+
+namespace hannk {
+
+namespace {
+
+// Element `i` of the batch dimension of `buf`, as a buffer with a batch
+// dimension of extent 1 at 0.
+template<typename T>
+HalideBuffer<T> batch_element(HalideBuffer<T> buf, int i) {
+    const int batch_dim = buf.dimensions() - 1;
+    buf.crop(batch_dim, i, 1);
+    buf.translate(batch_dim, -i);
+    return buf;
+}
+
+}  // namespace
+
+RequestBatcher::RequestBatcher(Interpreter *interpreter, std::chrono::microseconds max_delay)
+    : interpreter_(interpreter), inputs_(interpreter->inputs()), outputs_(interpreter->outputs()),
+      batch_size_(0), max_delay_(max_delay) {
+    for (const auto &t : inputs_) {
+        HCHECK(t->rank() > 0 && !t->is_dynamic()) << "Input " << t->name() << " has no batch dimension\n";
+        HCHECK(batch_size_ == 0 || t->extent(t->rank() - 1) == batch_size_) << "Inputs have different batch sizes\n";
+        batch_size_ = t->extent(t->rank() - 1);
+    }
+    for (const auto &t : outputs_) {
+        HCHECK(t->rank() > 0 && !t->is_dynamic()) << "Output " << t->name() << " has no batch dimension\n";
+        HCHECK(t->extent(t->rank() - 1) == batch_size_) << "Outputs have different batch sizes to the inputs\n";
+    }
+    HCHECK(batch_size_ > 0);
+}
+
+void RequestBatcher::run(const std::vector<HalideBuffer<const void>> &inputs,
+                         const std::vector<HalideBuffer<void>> &outputs) {
+    assert(inputs.size() == inputs_.size());
+    assert(outputs.size() == outputs_.size());
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Wait for a batch that is being filled and has room for this request.
+    cv_.wait(lock, [&]() { return !executing_ && unread_ == 0 && filled_ < batch_size_; });
+    const int index = filled_++;
+    const long long batch = batches_executed_;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        batch_element(inputs_[i]->buffer(), index).copy_from(inputs[i]);
+    }
+
+    if (index == 0) {
+        // The first request in the batch executes it, once it is full or
+        // this request has waited long enough.
+        cv_.notify_all();
+        cv_.wait_for(lock, max_delay_, [&]() { return filled_ == batch_size_; });
+        executing_ = true;
+        lock.unlock();
+        interpreter_->execute();
+        lock.lock();
+        executing_ = false;
+        unread_ = filled_;
+        filled_ = 0;
+        batches_executed_++;
+        cv_.notify_all();
+    } else {
+        if (filled_ == batch_size_) {
+            cv_.notify_all();
+        }
+        cv_.wait(lock, [&]() { return batches_executed_ != batch; });
+    }
+
+    for (size_t i = 0; i < outputs.size(); i++) {
+        HalideBuffer<void> output = outputs[i];
+        output.copy_from(batch_element(outputs_[i]->buffer(), index));
+    }
+    if (--unread_ == 0) {
+        cv_.notify_all();
+    }
+}
+
+}  // namespace hannk
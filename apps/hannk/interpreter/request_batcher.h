@@ -0,0 +1,60 @@
+#ifndef HANNK_REQUEST_BATCHER_H
+#define HANNK_REQUEST_BATCHER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "interpreter/interpreter.h"
+
+namespace hannk {
+
+// Runs inferences requested concurrently by many threads in batches. The
+// interpreter should run a model with a batch dimension (the last dimension
+// of each input and output) of extent `batch_size`, e.g. one parsed with
+// `parse_tflite_model(model, batch_size)`. Each request fills one element of
+// a batch, and a batch is executed when it is full, or when the first request
+// in it has waited for `max_delay`. This way, each op loads its weights once
+// for the whole batch.
+class RequestBatcher {
+    Interpreter *interpreter_;
+    std::vector<TensorPtr> inputs_;
+    std::vector<TensorPtr> outputs_;
+    int batch_size_;
+    std::chrono::microseconds max_delay_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    // The number of requests in the batch being filled.
+    int filled_ = 0;
+    // Whether the batch is executing.
+    bool executing_ = false;
+    // The number of requests in the last batch executed that have not yet
+    // copied their outputs. A new batch can't start until this is zero.
+    int unread_ = 0;
+    // The number of batches executed so far.
+    long long batches_executed_ = 0;
+
+public:
+    RequestBatcher(Interpreter *interpreter, std::chrono::microseconds max_delay);
+
+    // Run one inference. `inputs` and `outputs` correspond to the inputs and
+    // outputs of the interpreter, with a batch dimension of extent 1. This
+    // can be called by many threads at once.
+    void run(const std::vector<HalideBuffer<const void>> &inputs,
+             const std::vector<HalideBuffer<void>> &outputs);
+
+    int batch_size() const {
+        return batch_size_;
+    }
+
+    // Not copyable or movable.
+    RequestBatcher() = delete;
+    RequestBatcher(const RequestBatcher &) = delete;
+    RequestBatcher &operator=(const RequestBatcher &) = delete;
+};
+
+}  // namespace hannk
+
+#endif  // HANNK_REQUEST_BATCHER_H
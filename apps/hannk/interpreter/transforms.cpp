@@ -1,5 +1,7 @@
 #include "interpreter/transforms.h"
 
+#include <algorithm>
+
 namespace hannk {
 
 namespace {
@@ -371,4 +373,145 @@ void fold_constants(OpGroup *root) {
     }
 }
 
+namespace {
+
+// Find ops that can execute on a crop of their output, given crops of
+// their inputs covering the region required by map_bounds.
+class IsTileable : public OpVisitor {
+    void visit_elementwise(ElementwiseOp *op) {
+        // The elementwise ops require the inputs to have the same shape as
+        // the output (after broadcasting).
+        result = true;
+        for (int i = 0; i < op->input_count(); i++) {
+            result = result && op->input(i)->rank() == op->output()->rank();
+        }
+    }
+
+    void visit(BinaryOp *op) {
+        visit_elementwise(op);
+    }
+    void visit(ElementwiseProgramOp *op) {
+        visit_elementwise(op);
+    }
+    void visit(UnaryOp *op) {
+        visit_elementwise(op);
+    }
+    void visit(Conv2DOp *op) {
+        result = true;
+    }
+    void visit(DepthwiseConv2DOp *op) {
+        result = true;
+    }
+
+public:
+    bool result = false;
+};
+
+bool is_tileable(Op *op) {
+    IsTileable v;
+    op->accept(&v);
+    if (!v.result || op->output_count() != 1 || op->output()->rank() != 4) {
+        return false;
+    }
+    for (int i = 0; i < op->input_count(); i++) {
+        if (op->input(i)->is_dynamic()) {
+            return false;
+        }
+    }
+    return !op->output()->is_dynamic();
+}
+
+int index_of(OpGroup *group, const Op *op) {
+    for (int i = 0; i < group->op_count(); i++) {
+        if (group->op(i) == op) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The dimension of the tensors of tileable ops to tile (y), and the
+// number of bytes of intermediate tensors to aim for in each tile, which
+// should fit in the L2 cache.
+const int fused_tile_dim = 2;
+const int fused_tile_bytes = 256 * 1024;
+
+}  // namespace
+
+void fuse_ops(OpGroup *root) {
+    for (int i = 0; i < root->op_count(); i++) {
+        Op *op = root->op(i);
+        if (OpGroup *group = cast_op<OpGroup>(op)) {
+            if (!group->is_tiled()) {
+                fuse_ops(group);
+            }
+            continue;
+        }
+        if (!is_tileable(op)) {
+            continue;
+        }
+
+        // Find a chain of tileable ops, where each op is the only
+        // consumer of the previous op's output.
+        std::vector<Op *> chain = {op};
+        while (true) {
+            const TensorPtr &output = chain.back()->output();
+            if (output->is_output() || output->consumers().size() != 1) {
+                break;
+            }
+            Op *next = output->consumers().front();
+            if (index_of(root, next) <= i || !is_tileable(next) ||
+                next->output()->extent(fused_tile_dim) != output->extent(fused_tile_dim)) {
+                break;
+            }
+            chain.push_back(next);
+        }
+        if (chain.size() < 2) {
+            continue;
+        }
+
+        // Pick the tile size for the bytes produced per row of the output.
+        size_t bytes_per_row = 0;
+        for (Op *j : chain) {
+            const TensorPtr &output = j->output();
+            bytes_per_row += output->number_of_elements() / output->extent(fused_tile_dim) * output->type().bytes();
+        }
+        const int output_rows = chain.back()->output()->extent(fused_tile_dim);
+        const int tile_rows = std::max<int>(1, fused_tile_bytes / std::max<size_t>(bytes_per_row, 1));
+        if (tile_rows >= output_rows) {
+            // The whole chain already fits in a tile.
+            continue;
+        }
+
+        // Move the chain into a group, in place of the last op of the chain,
+        // after everything the chain depends on.
+        std::vector<TensorPtr> inputs;
+        std::vector<OpPtr> ops;
+        TensorMap same_tensors;
+        for (Op *j : chain) {
+            for (int k = 0; k < j->input_count(); k++) {
+                const TensorPtr &input = j->input(k);
+                const bool produced_by_chain =
+                    !input->producers().empty() &&
+                    std::find(chain.begin(), chain.end(), input->producers().front()) != chain.end();
+                if (!produced_by_chain && std::find(inputs.begin(), inputs.end(), input) == inputs.end()) {
+                    inputs.push_back(input);
+                }
+                same_tensors[input] = input;
+            }
+            same_tensors[j->output()] = j->output();
+            ops.push_back(j->clone(same_tensors));
+        }
+        std::unique_ptr<OpGroup> group =
+            make_op<OpGroup>(std::move(inputs), std::vector<TensorPtr>{chain.back()->output()}, std::move(ops));
+        group->set_tiling(fused_tile_dim, tile_rows);
+        root->add(std::move(group), chain.back());
+        for (Op *j : chain) {
+            root->remove(j);
+        }
+        // Look at the op that is now at index i again.
+        i--;
+    }
+}
+
 }  // namespace hannk
@@ -19,6 +19,10 @@ void pad_for_ops(OpGroup *op);
 // constant as well.
 void fold_constants(OpGroup *op);
 
+// Group chains of convolutions and elementwise ops into groups that
+// execute one tile at a time, so the intermediate tensors stay in cache.
+void fuse_ops(OpGroup *op);
+
 }  // namespace hannk
 
 #endif  // HANNK_TRANSFORMS_H
\ No newline at end of file
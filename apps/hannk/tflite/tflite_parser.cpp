@@ -20,12 +20,19 @@ tflite::BuiltinOperator get_builtin_code(const tflite::OperatorCode *op_code) {
 
 class Parser {
     const tflite::Model *model_;
+    int batch_size_;
     std::vector<TensorPtr> tensors_;
     std::vector<std::unique_ptr<OpGroup>> subgraphs_;
 
+    // Tensors computed by the model with a batch dimension (the outermost
+    // dimension) of extent 1 instead get a batch dimension of batch_size_.
+    bool is_batched(const std::vector<int> &shape) const {
+        return batch_size_ > 1 && shape.size() >= 2 && shape.back() == 1;
+    }
+
 public:
-    explicit Parser(const tflite::Model *model)
-        : model_(model) {
+    Parser(const tflite::Model *model, int batch_size)
+        : model_(model), batch_size_(batch_size) {
     }
 
     static ActivationFunction parse_activation_function(
@@ -130,6 +137,10 @@ public:
             }
         }
 
+        if (is_batched(shape)) {
+            shape.back() = batch_size_;
+        }
+
         // Create an "unallocated" Buffer, which points to null.
         HalideBuffer<void> buffer(type, nullptr, shape);
         return make_op<Tensor>(t->name()->str(), std::move(buffer), std::move(quantization));
@@ -278,6 +289,19 @@ public:
             }
             shape_tensor = std::make_shared<Tensor>(input->name() + "_shape", shape_data);
         }
+        if (shape_tensor && shape_tensor->is_constant() && shape_tensor->rank() == 1 &&
+            shape_tensor->type() == halide_type_of<int32_t>()) {
+            // The new shape is outermost dimension first.
+            const auto &shape_buf = shape_tensor->buffer<const int32_t>();
+            std::vector<int> new_shape(shape_buf.begin(), shape_buf.end());
+            std::reverse(new_shape.begin(), new_shape.end());
+            if (is_batched(new_shape)) {
+                HalideBuffer<int32_t> batched_shape(shape_buf.dim(0).extent());
+                batched_shape.copy_from(shape_buf);
+                batched_shape(0) = batch_size_;
+                shape_tensor = std::make_shared<Tensor>(input->name() + "_batched_shape", batched_shape);
+            }
+        }
         return make_op<ReshapeOp>(input, shape_tensor, output);
     }
 
@@ -541,12 +565,12 @@ public:
 
 }  // namespace
 
-std::unique_ptr<OpGroup> parse_tflite_model(const tflite::Model *model) {
-    return Parser(model).parse();
+std::unique_ptr<OpGroup> parse_tflite_model(const tflite::Model *model, int batch_size) {
+    return Parser(model, batch_size).parse();
 }
 
-std::unique_ptr<OpGroup> parse_tflite_model_from_buffer(const void *buffer) {
-    return parse_tflite_model(tflite::GetModel(buffer));
+std::unique_ptr<OpGroup> parse_tflite_model_from_buffer(const void *buffer, int batch_size) {
+    return parse_tflite_model(tflite::GetModel(buffer), batch_size);
 }
 
 }  // namespace hannk
@@ -14,11 +14,14 @@ struct Model;
 namespace hannk {
 
 // Translate from a tflite::Model to our own model representation.
-std::unique_ptr<OpGroup> parse_tflite_model(const tflite::Model *model);
+// If batch_size is greater than 1, the tensors computed by a model with
+// a batch size of 1 get a batch dimension of extent batch_size instead,
+// so the model computes batch_size inferences at once.
+std::unique_ptr<OpGroup> parse_tflite_model(const tflite::Model *model, int batch_size = 1);
 
 // Call tflite::GetModel() and then call parse_tflite_model() on the result --
 // avoids the need for client to include any tflite-specific files.
-std::unique_ptr<OpGroup> parse_tflite_model_from_buffer(const void *model);
+std::unique_ptr<OpGroup> parse_tflite_model_from_buffer(const void *model, int batch_size = 1);
 
 }  // namespace hannk
 
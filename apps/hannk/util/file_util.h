@@ -1,6 +1,11 @@
 #ifndef HANNK_FILE_UTIL_H
 #define HANNK_FILE_UTIL_H
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <fstream>
 #include <memory>
 #include <vector>
@@ -25,6 +30,43 @@ inline std::vector<char> read_entire_file(const std::string &filename) {
     return result;
 }
 
+// A read-only memory mapping of an entire file.
+class MappedFile {
+    void *data_ = nullptr;
+    size_t size_ = 0;
+
+public:
+    explicit MappedFile(const std::string &filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        HCHECK(fd >= 0) << "Unable to open file: " << filename;
+        struct stat st;
+        HCHECK(fstat(fd, &st) == 0) << "Unable to stat file: " << filename;
+        size_ = st.st_size;
+        if (size_ > 0) {
+            data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            HCHECK(data_ != MAP_FAILED) << "Unable to map file: " << filename;
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) {
+            munmap(data_, size_);
+        }
+    }
+
+    const void *data() const {
+        return data_;
+    }
+    size_t size() const {
+        return size_;
+    }
+
+    // Not copyable or movable.
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+};
+
 }  // namespace hannk
 
 #endif  // HANNK_FILE_UTIL_H
@@ -1,13 +1,16 @@
 #include <chrono>
+#include <cstdlib>
 #include <dlfcn.h>
 #include <iostream>
 #include <random>
+#include <thread>
 
 #include "util/model_runner.h"
 
 #include "delegate/hannk_delegate.h"
 #include "halide_benchmark.h"
 #include "interpreter/interpreter.h"
+#include "interpreter/request_batcher.h"
 #include "tflite/tflite_parser.h"
 #include "util/buffer_util.h"
 #include "util/error_util.h"
@@ -143,6 +146,7 @@ static const char *const RunNames[ModelRunner::kNumRuns] = {
     "Hannk",
     "HannkExternalDelegate",
     "HannkInternalDelegate",
+    "HannkPrepared",
 };
 
 }  // namespace
@@ -299,6 +303,9 @@ void ModelRunner::set_seed(int seed) {
 void ModelRunner::status() {
     std::cout << "Using random seed: " << seed_tracker_.next_seed() << "\n";
     std::cout << "Using threads: " << threads << "\n";
+    std::cout << "Using max concurrent ops: " << max_concurrent_ops << "\n";
+    std::cout << "Using fused ops: " << (fuse_ops ? "yes" : "no") << "\n";
+    std::cout << "Using batch size: " << batch_size << "\n";
 
     {
         std::string tf_ver = TfLiteVersion();
@@ -311,7 +318,7 @@ void ModelRunner::status() {
     }
 }
 
-ModelRunner::RunResult ModelRunner::run_in_hannk(const std::vector<char> &buffer) {
+ModelRunner::RunResult ModelRunner::run_in_hannk(const std::vector<char> &buffer, bool use_prepared_model) {
     RunResult result;
 
     std::unique_ptr<OpGroup> model = parse_tflite_model_from_buffer(buffer.data());
@@ -319,7 +326,23 @@ ModelRunner::RunResult ModelRunner::run_in_hannk(const std::vector<char> &buffer
         model->dump(std::cout);
     }
 
-    Interpreter interpreter(std::move(model));
+    InterpreterOptions options;
+    options.max_concurrent_ops = max_concurrent_ops;
+    options.fuse_ops = fuse_ops;
+    std::unique_ptr<Interpreter> prepared(new Interpreter(std::move(model), options));
+    if (use_prepared_model) {
+        // Save the prepared model, and execute the one loaded back from the
+        // file instead. The file stays mapped after it is removed.
+        const char *tmpdir = getenv("TMPDIR");
+        std::string filename = std::string(tmpdir && *tmpdir ? tmpdir : "/tmp") + "/hannk_XXXXXX";
+        int fd = mkstemp(&filename[0]);
+        HCHECK(fd >= 0) << "Unable to create a temporary file: " << filename;
+        close(fd);
+        prepared->save(filename);
+        prepared = Interpreter::load(filename, options);
+        unlink(filename.c_str());
+    }
+    Interpreter &interpreter = *prepared;
 
     // Fill in the inputs with pseudorandom data (save the seeds for later).
     for (TensorPtr t : interpreter.inputs()) {
@@ -414,6 +437,66 @@ bool ModelRunner::compare_results(const std::string &msg, const RunResult &a, co
     return all_matched;
 };
 
+bool ModelRunner::compare_batched_results(const std::vector<char> &buffer) {
+    InterpreterOptions options;
+    options.max_concurrent_ops = max_concurrent_ops;
+    options.fuse_ops = fuse_ops;
+    Interpreter unbatched(parse_tflite_model_from_buffer(buffer.data()), options);
+    Interpreter batched(parse_tflite_model_from_buffer(buffer.data(), batch_size), options);
+    RequestBatcher batcher(&batched, std::chrono::milliseconds(1));
+
+    // Make enough requests to fill some batches, and leave one partially
+    // filled. Each request gets its own pseudorandom inputs.
+    const int requests = 2 * batch_size + 1;
+    std::vector<std::vector<HalideBuffer<const void>>> inputs(requests);
+    std::vector<std::vector<HalideBuffer<void>>> outputs(requests);
+    std::vector<RunResult> expected(requests);
+    for (int r = 0; r < requests; r++) {
+        const std::vector<TensorPtr> &unbatched_inputs = unbatched.inputs();
+        for (size_t i = 0; i < unbatched_inputs.size(); i++) {
+            TensorPtr t = unbatched_inputs[i];
+            if (!t->is_constant()) {
+                const int seed_here = seed_tracker_.seed_for_name(t->name() + ", request " + std::to_string(r));
+                auto input_buf = t->buffer();
+                dynamic_type_dispatch<FillWithRandom>(input_buf.type(), input_buf, seed_here);
+            }
+            inputs[r].emplace_back(t->buffer().copy());
+        }
+        unbatched.execute();
+        for (TensorPtr t : unbatched.outputs()) {
+            expected[r].outputs.emplace_back(t->buffer().copy());
+        }
+        for (const TensorPtr &t : batched.outputs()) {
+            const int batch_dim = t->rank() - 1;
+            outputs[r].push_back(HalideBuffer<void>::make_with_shape_of(t->buffer().cropped(batch_dim, 0, 1)));
+        }
+    }
+
+    // Execute all the requests at once, so they get batched together.
+    std::vector<std::thread> threads;
+    for (int r = 0; r < requests; r++) {
+        threads.emplace_back([&, r]() {
+            batcher.run(inputs[r], outputs[r]);
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    bool all_matched = true;
+    for (int r = 0; r < requests; r++) {
+        RunResult actual;
+        actual.outputs.assign(outputs[r].begin(), outputs[r].end());
+        std::ostringstream msg;
+        msg << "Comparing " << RunNames[kHannk] << " vs " << RunNames[kHannk] << " with batch size "
+            << batch_size << ", request " << r << ":";
+        if (!compare_results(msg.str(), expected[r], actual)) {
+            all_matched = false;
+        }
+    }
+    return all_matched;
+}
+
 void ModelRunner::run(const std::string &filename) {
     std::cout << "Processing " << filename << " ...\n";
 
@@ -434,6 +517,9 @@ void ModelRunner::run(const std::string &filename) {
     const auto exec_hannk = [this, &buffer]() {
         return run_in_hannk(buffer);
     };
+    const auto exec_hannk_prepared = [this, &buffer]() {
+        return run_in_hannk(buffer, /* use_prepared_model */ true);
+    };
     const auto exec_hannk_external_delegate = [this, &buffer]() {
         DelegatePtr delegate_ptr;
         HCHECK(delegate_ptr.init(external_delegate_path, verbosity));
@@ -452,6 +538,7 @@ void ModelRunner::run(const std::string &filename) {
         {kHannk, exec_hannk},
         {kExternalDelegate, exec_hannk_external_delegate},
         {kInternalDelegate, exec_hannk_internal_delegate},
+        {kHannkPrepared, exec_hannk_prepared},
     };
 
     std::cout << '\n';
@@ -499,11 +586,29 @@ void ModelRunner::run(const std::string &filename) {
             }
         }
 
+        if (do_run[kHannk] && do_run[kHannkPrepared]) {
+            // A prepared model should compute the same thing as the model
+            // it was saved from.
+            std::ostringstream msg;
+            msg << "Comparing " << RunNames[kHannk] << " vs " << RunNames[kHannkPrepared] << ":";
+            if (!compare_results(msg.str(), results[kHannk], results[kHannkPrepared])) {
+                all_matched = false;
+            }
+        }
+
         if (!all_matched) {
             std::cerr << "Some runs exceeded the error threshold!\n";
             exit(1);
         }
     }
+
+    if (do_compare_results && batch_size > 1) {
+        std::cout << '\n';
+        if (!compare_batched_results(buffer)) {
+            std::cerr << "Some batched requests exceeded the error threshold!\n";
+            exit(1);
+        }
+    }
 }
 
 }  // namespace hannk
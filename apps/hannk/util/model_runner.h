@@ -66,11 +66,18 @@ struct ModelRunner {
         kHannk,
         kExternalDelegate,
         kInternalDelegate,
+        kHannkPrepared,
 
         kNumRuns  // keep last
     };
 
     int threads = 1;
+    int max_concurrent_ops = 1;
+    bool fuse_ops = false;
+    // If greater than 1, also check that a model with this batch size,
+    // executing requests through a RequestBatcher, computes the same
+    // outputs as the model executing the requests one at a time.
+    int batch_size = 1;
     int verbosity = 0;
     bool do_run[kNumRuns];  // no way to default-init everything to anything but zero, alas
     bool do_benchmark = true;
@@ -97,9 +104,10 @@ private:
         std::vector<HalideBuffer<const void>> outputs;
         std::chrono::duration<double> time{0};
     };
-    RunResult run_in_hannk(const std::vector<char> &buffer);
+    RunResult run_in_hannk(const std::vector<char> &buffer, bool use_prepared_model = false);
     RunResult run_in_tflite(const std::vector<char> &buffer, TfLiteDelegate *delegate = nullptr);
     bool compare_results(const std::string &msg, const RunResult &a, const RunResult &b);
+    bool compare_batched_results(const std::vector<char> &buffer);
 };
 
 }  // namespace hannk
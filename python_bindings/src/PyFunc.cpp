@@ -203,11 +203,16 @@ void define_func(py::module &m) {
             .def("store_at", (Func & (Func::*)(const Func &, const RVar &)) & Func::store_at, py::arg("f"), py::arg("var"))
             .def("store_at", (Func & (Func::*)(LoopLevel)) & Func::store_at, py::arg("loop_level"))
 
+            .def("hoist_storage", (Func & (Func::*)(const Func &, const Var &)) & Func::hoist_storage, py::arg("f"), py::arg("var"))
+            .def("hoist_storage", (Func & (Func::*)(const Func &, const RVar &)) & Func::hoist_storage, py::arg("f"), py::arg("var"))
+            .def("hoist_storage", (Func & (Func::*)(LoopLevel)) & Func::hoist_storage, py::arg("loop_level"))
+
             .def("async_", &Func::async)
             .def("memoize", &Func::memoize)
             .def("compute_inline", &Func::compute_inline)
             .def("compute_root", &Func::compute_root)
             .def("store_root", &Func::store_root)
+            .def("hoist_storage_root", &Func::hoist_storage_root)
 
             .def("store_in", &Func::store_in, py::arg("memory_type"))
 
@@ -145,6 +145,117 @@ public:
     }
 };
 
+// Move the Realize nodes of a Func out to its hoist_storage_level, so
+// that one allocation is reused by every realization of the Func
+// within that loop. The hoisted bounds are the bounds of the
+// realizations over the loops and lets between the two sites.
+class HoistStorage : public IRMutator {
+    using IRMutator::mutate;
+    using IRMutator::visit;
+
+    const Function &func;
+    const LoopLevel &hoist_storage_at;
+
+    // The ranges of the loop variables and lets between the hoisted
+    // site and the current one.
+    Scope<Interval> scope;
+    bool in_hoisted_loop = false;
+
+    // The union of the bounds of the realizations found within the
+    // current hoisted loop.
+    const Realize *found = nullptr;
+    Box box;
+
+    Stmt wrap_in_realize(const Stmt &body) {
+        if (!found) {
+            return body;
+        }
+        Region bounds;
+        for (const Interval &i : box.bounds) {
+            bounds.emplace_back(simplify(i.min), simplify(i.max - i.min + 1));
+        }
+        Stmt stmt = Realize::make(func.name(), found->types, found->memory_type, bounds, const_true(), body);
+        found = nullptr;
+        box = Box();
+        return stmt;
+    }
+
+    // Realize nodes can't be inside Exprs.
+    Expr mutate(const Expr &e) override {
+        return e;
+    }
+
+    Stmt visit(const For *op) override {
+        if (in_hoisted_loop) {
+            Interval min = bounds_of_expr_in_scope(op->min, scope);
+            Interval max = bounds_of_expr_in_scope(op->min + op->extent - 1, scope);
+            ScopedBinding<Interval> bind(scope, op->name, Interval(min.min, max.max));
+            return IRMutator::visit(op);
+        } else if (hoist_storage_at.match(op->name)) {
+            in_hoisted_loop = true;
+            Stmt body = mutate(op->body);
+            in_hoisted_loop = false;
+            body = wrap_in_realize(body);
+            return For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+        } else {
+            return IRMutator::visit(op);
+        }
+    }
+
+    Stmt visit(const LetStmt *op) override {
+        if (!in_hoisted_loop) {
+            return IRMutator::visit(op);
+        }
+        ScopedBinding<Interval> bind(scope, op->name, bounds_of_expr_in_scope(op->value, scope));
+        return IRMutator::visit(op);
+    }
+
+    Stmt visit(const Realize *op) override {
+        if (op->name != func.name()) {
+            return IRMutator::visit(op);
+        }
+        internal_assert(in_hoisted_loop)
+            << "Realization of " << func.name() << " is not within " << hoist_storage_at.to_string() << "\n";
+
+        Box b;
+        for (size_t i = 0; i < op->bounds.size(); i++) {
+            const Range &r = op->bounds[i];
+            Interval min = bounds_of_expr_in_scope(r.min, scope);
+            Interval max = bounds_of_expr_in_scope(r.min + r.extent - 1, scope);
+            if (!min.has_lower_bound() || !max.has_upper_bound()) {
+                user_error << "Can't hoist the storage of " << func.name()
+                           << " to " << hoist_storage_at.to_string()
+                           << ", because its size in dimension " << func.args()[i]
+                           << " is unbounded there.\n";
+            }
+            b.push_back(Interval(min.min, max.max));
+        }
+        if (found) {
+            merge_boxes(box, b);
+        } else {
+            found = op;
+            box = b;
+        }
+        return mutate(op->body);
+    }
+
+public:
+    HoistStorage(const Function &f)
+        : func(f), hoist_storage_at(f.schedule().hoist_storage_level()) {
+    }
+
+    Stmt hoist(const Stmt &s) {
+        if (hoist_storage_at.is_root()) {
+            in_hoisted_loop = true;
+            Stmt stmt = mutate(s);
+            in_hoisted_loop = false;
+            return wrap_in_realize(stmt);
+        } else {
+            return mutate(s);
+        }
+    }
+};
+
 // We can strip box_touched declarations here. We're done with
 // them. Reconsider this decision if we want to use
 // box_touched on extern stages later in lowering. Storage
@@ -168,6 +279,12 @@ Stmt allocation_bounds_inference(Stmt s,
                                  const map<string, Function> &env,
                                  const FuncValueBounds &fb) {
     s = AllocationInference(env, fb).mutate(s);
+    for (const auto &p : env) {
+        const FuncSchedule &sched = p.second.schedule();
+        if (!(sched.hoist_storage_level() == sched.store_level())) {
+            s = HoistStorage(p.second).hoist(s);
+        }
+    }
     s = StripDeclareBoxTouched().mutate(s);
     return s;
 }
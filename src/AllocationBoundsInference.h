@@ -17,7 +17,9 @@ namespace Internal {
 class Function;
 
 /** Take a partially statement with Realize nodes in terms of
- * variables, and define values for those variables. */
+ * variables, and define values for those variables. Realize nodes of
+ * Funcs with a hoist_storage_level are then moved out to it, with
+ * bounds large enough for every realization within it. */
 Stmt allocation_bounds_inference(Stmt s,
                                  const std::map<std::string, Function> &env,
                                  const std::map<std::pair<std::string, int>, Interval> &func_bounds);
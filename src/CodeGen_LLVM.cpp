@@ -1055,6 +1055,75 @@ llvm::Type *CodeGen_LLVM::llvm_type_of(const Type &t) const {
     return Internal::llvm_type_of(context, t);
 }
 
+namespace {
+
+#if LLVM_VERSION >= 120
+// Records the cost of each LLVM optimization pass with a
+// CompilerLogger. Passes that run other passes (pass managers and
+// adaptors) are billed only for the time not spent in the passes they
+// run, so the times of all the passes add up to the total.
+class LLVMPassTimer {
+    struct RunningPass {
+        std::chrono::high_resolution_clock::time_point start;
+        double nested_duration;
+        int64_t ir_size_before;
+    };
+    std::vector<RunningPass> running;
+    CompilerLogger *logger;
+
+    // The number of instructions in the unit of IR a pass runs on. For
+    // loop passes, it's the size of the enclosing function.
+    static int64_t ir_size(const Any &ir) {
+        if (any_isa<const llvm::Module *>(ir)) {
+            return any_cast<const llvm::Module *>(ir)->getInstructionCount();
+        } else if (any_isa<const llvm::Function *>(ir)) {
+            return any_cast<const llvm::Function *>(ir)->getInstructionCount();
+        } else if (any_isa<const LazyCallGraph::SCC *>(ir)) {
+            int64_t size = 0;
+            for (const LazyCallGraph::Node &n : *any_cast<const LazyCallGraph::SCC *>(ir)) {
+                size += n.getFunction().getInstructionCount();
+            }
+            return size;
+        } else if (any_isa<const Loop *>(ir)) {
+            return any_cast<const Loop *>(ir)->getHeader()->getParent()->getInstructionCount();
+        }
+        return 0;
+    }
+
+    void finish(StringRef pass, int64_t ir_size_after) {
+        internal_assert(!running.empty());
+        RunningPass p = running.back();
+        running.pop_back();
+        std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - p.start;
+        if (!running.empty()) {
+            running.back().nested_duration += duration.count();
+        }
+        logger->record_compilation_pass(CompilerLogger::Phase::LLVM, pass.str(), duration.count() - p.nested_duration,
+                                        p.ir_size_before, ir_size_after, get_peak_memory_usage());
+    }
+
+public:
+    LLVMPassTimer(CompilerLogger *logger)
+        : logger(logger) {
+    }
+
+    void register_callbacks(PassInstrumentationCallbacks &pic) {
+        pic.registerBeforeNonSkippedPassCallback([this](StringRef, Any ir) {
+            running.push_back({std::chrono::high_resolution_clock::now(), 0.0, ir_size(ir)});
+        });
+        pic.registerAfterPassCallback([this](StringRef pass, Any ir, const PreservedAnalyses &) {
+            finish(pass, ir_size(ir));
+        });
+        pic.registerAfterPassInvalidatedCallback([this](StringRef pass, const PreservedAnalyses &) {
+            // The unit of IR the pass ran on no longer exists.
+            finish(pass, 0);
+        });
+    }
+};
+#endif
+
+}  // namespace
+
 void CodeGen_LLVM::optimize_module() {
     debug(3) << "Optimizing module\n";
 
@@ -1087,10 +1156,22 @@ void CodeGen_LLVM::optimize_module() {
     // 21.04 -> 14.78 using current ToT release build. (See also https://reviews.llvm.org/rL358304)
     pto.ForgetAllSCEVInLoopUnroll = true;
 
+#if LLVM_VERSION >= 120
+    // If there's an active CompilerLogger, record the cost of each pass.
+    PassInstrumentationCallbacks pic;
+    PassInstrumentationCallbacks *pic_ptr = nullptr;
+    std::unique_ptr<LLVMPassTimer> pass_timer;
+    if (auto *logger = get_compiler_logger()) {
+        pass_timer = std::make_unique<LLVMPassTimer>(logger);
+        pass_timer->register_callbacks(pic);
+        pic_ptr = &pic;
+    }
+#endif
+
 #if LLVM_VERSION >= 130
-    llvm::PassBuilder pb(tm.get(), pto);
+    llvm::PassBuilder pb(tm.get(), pto, llvm::None, pic_ptr);
 #elif LLVM_VERSION >= 120
-    llvm::PassBuilder pb(/*DebugLogging*/ false, tm.get(), pto);
+    llvm::PassBuilder pb(/*DebugLogging*/ false, tm.get(), pto, llvm::None, pic_ptr);
 #else
     llvm::PassBuilder pb(tm.get(), pto);
 #endif
@@ -3745,6 +3826,8 @@ void CodeGen_LLVM::do_parallel_tasks(const vector<ParallelTask> &tasks) {
         llvm::Value *task_ptr = builder->CreatePointerCast(function, fn_type->getPointerTo());
 
         function->addParamAttr(closure_arg_idx, Attribute::NoAlias);
+        // Lets compile_llvm_module_to_objects find the task bodies.
+        function->addFnAttr("halide-parallel-task");
 
         set_function_attributes_for_target(function, target);
 
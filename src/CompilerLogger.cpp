@@ -102,24 +102,52 @@ JSONCompilerLogger::JSONCompilerLogger(
 }
 
 void JSONCompilerLogger::record_matched_simplifier_rule(const std::string &rulename, Expr expr) {
+    std::lock_guard<std::mutex> lock(mutex);
     matched_simplifier_rules[rulename].emplace_back(std::move(expr));
 }
 
 void JSONCompilerLogger::record_non_monotonic_loop_var(const std::string &loop_var, Expr expr) {
+    std::lock_guard<std::mutex> lock(mutex);
     non_monotonic_loop_vars[loop_var].emplace_back(std::move(expr));
 }
 void JSONCompilerLogger::record_failed_to_prove(Expr failed_to_prove, Expr original_expr) {
+    std::lock_guard<std::mutex> lock(mutex);
     failed_to_prove_exprs.emplace_back(failed_to_prove, original_expr);
 }
 
 void JSONCompilerLogger::record_object_code_size(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
     object_code_size += bytes;
 }
 
 void JSONCompilerLogger::record_compilation_time(Phase phase, double duration) {
+    std::lock_guard<std::mutex> lock(mutex);
     compilation_time[phase] += duration;
 }
 
+void JSONCompilerLogger::record_compilation_pass(Phase phase, const std::string &pass_name, double duration,
+                                                 int64_t ir_size_before, int64_t ir_size_after, uint64_t peak_memory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    PassStats *stats;
+    if (phase == Phase::HalideLowering) {
+        lowering_passes.emplace_back();
+        stats = &lowering_passes.back();
+    } else {
+        auto it = llvm_pass_index.find(pass_name);
+        if (it == llvm_pass_index.end()) {
+            it = llvm_pass_index.emplace(pass_name, llvm_passes.size()).first;
+            llvm_passes.emplace_back();
+        }
+        stats = &llvm_passes[it->second];
+    }
+    stats->name = pass_name;
+    stats->invocations++;
+    stats->duration += duration;
+    stats->ir_size_before += ir_size_before;
+    stats->ir_size_after += ir_size_after;
+    stats->peak_memory = std::max(stats->peak_memory, peak_memory);
+}
+
 void JSONCompilerLogger::obfuscate() {
     {
         std::map<std::string, std::vector<Expr>> n;
@@ -244,6 +272,41 @@ std::string expr_to_string(const Expr &e) {
     return s.str();
 }
 
+template<typename T>
+std::ostream &emit_pass_stats(std::ostream &o, int indent, const std::string &key, const std::vector<T> &passes, bool comma = true) {
+    std::string spaces(indent, ' ');
+    std::string spaces_in(indent + 1, ' ');
+
+    emit_key(o, indent, key);
+    o << "[\n";
+    int commas_to_emit = (int)passes.size() - 1;
+    for (const auto &it : passes) {
+        o << spaces_in << "{";
+        emit_key(o, 0, "name");
+        emit_value(o, it.name);
+        o << ", ";
+        emit_key(o, 0, "invocations");
+        emit_value(o, it.invocations);
+        o << ", ";
+        emit_key(o, 0, "time");
+        emit_value(o, it.duration);
+        o << ", ";
+        emit_key(o, 0, "ir_size_before");
+        emit_value(o, it.ir_size_before);
+        o << ", ";
+        emit_key(o, 0, "ir_size_after");
+        emit_value(o, it.ir_size_after);
+        o << ", ";
+        emit_key(o, 0, "peak_memory");
+        emit_value(o, it.peak_memory);
+        o << "}";
+        emit_eol(o, commas_to_emit-- > 0);
+    }
+    o << spaces << "]";
+    emit_eol(o, comma);
+    return o;
+}
+
 std::set<std::string> exprs_to_strings(const std::vector<Expr> &exprs) {
     std::set<std::string> strings;
     for (const auto &e : exprs) {
@@ -255,6 +318,7 @@ std::set<std::string> exprs_to_strings(const std::vector<Expr> &exprs) {
 }  // namespace
 
 std::ostream &JSONCompilerLogger::emit_to_stream(std::ostream &o) {
+    std::lock_guard<std::mutex> lock(mutex);
     if (obfuscate_exprs) {
         obfuscate();
     }
@@ -282,6 +346,18 @@ std::ostream &JSONCompilerLogger::emit_to_stream(std::ostream &o) {
         emit_key_value(o, indent, "compilation_time_llvm", compilation_time[Phase::LLVM]);
     }
 
+    if (!lowering_passes.empty()) {
+        emit_pass_stats(o, indent, "compilation_passes_halide_lowering", lowering_passes);
+    }
+    if (!llvm_passes.empty()) {
+        // List the most expensive LLVM passes first.
+        std::vector<PassStats> sorted = llvm_passes;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const PassStats &a, const PassStats &b) {
+            return a.duration > b.duration;
+        });
+        emit_pass_stats(o, indent, "compilation_passes_llvm", sorted);
+    }
+
     if (!matched_simplifier_rules.empty()) {
         emit_object_key_open(o, indent, "matched_simplifier_rules");
 
@@ -13,8 +13,10 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Expr.h"
 #include "Target.h"
@@ -53,6 +55,19 @@ public:
      */
     virtual void record_compilation_time(Phase phase, double duration) = 0;
 
+    /** Record the cost of a single pass of the given phase of compilation:
+     * the time (in seconds) it took, the size of the IR before and after
+     * it ran, and the peak memory usage (in bytes) of the process once it
+     * had finished. For HalideLowering the IR size is the number of
+     * distinct IR nodes in the Stmt being lowered; for LLVM it is the
+     * number of instructions in the function or module the pass ran on.
+     * The same pass may be recorded many times. The default
+     * implementation ignores it, so existing loggers need not change.
+     */
+    virtual void record_compilation_pass(Phase phase, const std::string &pass_name, double duration,
+                                         int64_t ir_size_before, int64_t ir_size_after, uint64_t peak_memory) {
+    }
+
     /**
      * Emit all the gathered data to the given stream. This may be called multiple times.
      */
@@ -61,7 +76,10 @@ public:
 
 /** Set the active CompilerLogger object, replacing any existing one.
  * It is legal to pass in a nullptr (which means "don't do any compiler logging").
- * Returns the previous CompilerLogger (if any). */
+ * Returns the previous CompilerLogger (if any). The outputs of a Module
+ * may be compiled on several threads at once (see HL_COMPILE_THREADS),
+ * so the record_*() methods of the logger must be safe to call
+ * concurrently. */
 std::unique_ptr<CompilerLogger> set_compiler_logger(std::unique_ptr<CompilerLogger> compiler_logger);
 
 /** Return the currently active CompilerLogger object. If set_compiler_logger()
@@ -90,6 +108,8 @@ public:
     void record_failed_to_prove(Expr failed_to_prove, Expr original_expr) override;
     void record_object_code_size(uint64_t bytes) override;
     void record_compilation_time(Phase phase, double duration) override;
+    void record_compilation_pass(Phase phase, const std::string &pass_name, double duration,
+                                 int64_t ir_size_before, int64_t ir_size_after, uint64_t peak_memory) override;
 
     std::ostream &emit_to_stream(std::ostream &o) override;
 
@@ -116,6 +136,26 @@ protected:
     // Map of the time take for each phase of compilation.
     std::map<Phase, double> compilation_time;
 
+    struct PassStats {
+        std::string name;
+        int64_t invocations{0};
+        double duration{0};
+        int64_t ir_size_before{0}, ir_size_after{0};
+        uint64_t peak_memory{0};
+    };
+
+    // The lowering passes, in the order they ran.
+    std::vector<PassStats> lowering_passes;
+
+    // The LLVM passes, which run many times (e.g. once per function),
+    // combined by name.
+    std::vector<PassStats> llvm_passes;
+    std::map<std::string, size_t> llvm_pass_index;
+
+    // Data may be recorded from several threads at once, when
+    // independent parts of a Module are compiled concurrently.
+    std::mutex mutex;
+
     void obfuscate();
     void emit();
 };
@@ -7,6 +7,8 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
 
 namespace Halide {
@@ -49,15 +51,29 @@ std::ostream &operator<<(std::ostream &, const LoweredFunc &);
 class debug {
     const bool logging;
 
+    // Everything streamed into one debug object is written out
+    // together when it is destroyed, so that messages from compile
+    // jobs running on other threads don't interleave with it.
+    std::unique_ptr<std::ostringstream> buffer;
+
 public:
     debug(int verbosity)
         : logging(verbosity <= debug_level()) {
     }
 
+    ~debug() {
+        if (buffer) {
+            std::cerr << buffer->str();
+        }
+    }
+
     template<typename T>
     debug &operator<<(T &&x) {
         if (logging) {
-            std::cerr << std::forward<T>(x);
+            if (!buffer) {
+                buffer = std::make_unique<std::ostringstream>();
+            }
+            *buffer << std::forward<T>(x);
         }
         return *this;
     }
@@ -2356,6 +2356,63 @@ public:
      * outside the outermost loop. */
     Func &store_root();
 
+    /** Hoist the storage of this Func out to the loop over a dimension
+     * of another Func, without moving its compute or its store_at
+     * site. The allocation is made once per iteration of that loop,
+     * large enough for every realization of this Func within it, and
+     * each realization reuses it instead of allocating its own. This
+     * is useful when this Func is computed within a loop and its size
+     * depends on the loop variables, so its storage would otherwise
+     * be allocated on the heap and freed on every iteration. Consider
+     * the pipeline from \ref Func::compute_at scheduled like so:
+     *
+     \code
+     Var xo, xi;
+     f.split(x, xo, xi, 16, TailStrategy::GuardWithIf);
+     g.compute_at(f, xo).hoist_storage(f, y);
+     \endcode
+     *
+     * The storage of g is allocated outside the loop over xo, with
+     * room for the largest tile of g that any iteration needs:
+     *
+     \code
+     int f[height][width];
+     for (int y = 0; y < height; y++) {
+         int g[2][17];
+         for (int xo = 0; xo < (width + 15)/16; xo++) {
+             int tile = min(16, width - xo*16);
+             for (int yy = y; yy < y + 2; yy++) {
+                 for (int xx = xo*16; xx < xo*16 + tile + 1; xx++) {
+                     g[yy - y][xx - xo*16] = xx*yy;
+                 }
+             }
+             for (int xi = 0; xi < tile; xi++) {
+                 int x = xo*16 + xi;
+                 f[y][x] = g[0][xi] + g[1][xi] + g[0][xi+1] + g[1][xi+1];
+             }
+         }
+     }
+     \endcode
+     *
+     * Unlike store_at, this does not trigger the sliding window
+     * optimization; g is recomputed in full by each iteration. The
+     * loops between the hoisted site and the store_at site must be
+     * serial, and the size of the Func must be bounded over them. */
+    Func &hoist_storage(const Func &f, const Var &var);
+
+    /** Equivalent to the version of hoist_storage that takes a Var,
+     * but hoists storage to the loop over a dimension of a reduction
+     * domain */
+    Func &hoist_storage(const Func &f, const RVar &var);
+
+    /** Equivalent to the version of hoist_storage that takes a Var,
+     * but hoists storage to a given LoopLevel. */
+    Func &hoist_storage(LoopLevel loop_level);
+
+    /** Equivalent to \ref Func::hoist_storage, but hoists storage
+     * outside the outermost loop. */
+    Func &hoist_storage_root();
+
     /** Aggressively inline all uses of this function. This is the
      * default schedule, so you're unlikely to need to call this. For
      * a Func with an update definition, that means it gets computed
@@ -951,6 +951,12 @@ void Function::lock_loop_levels() {
     if (schedule.store_level().is_inlined()) {
         schedule.store_level() = schedule.compute_level();
     }
+    schedule.hoist_storage_level().lock();
+    // Likewise, if hoist_storage_level is inlined, allocate at the
+    // store_level.
+    if (schedule.hoist_storage_level().is_inlined()) {
+        schedule.hoist_storage_level() = schedule.store_level();
+    }
     if (contents->init_def.defined()) {
         contents->init_def.schedule().fuse_level().level.lock();
     }
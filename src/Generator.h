@@ -2256,6 +2256,8 @@ public:
     HALIDE_FORWARD_METHOD(Func, gpu_tile)
     HALIDE_FORWARD_METHOD_CONST(Func, has_update_definition)
     HALIDE_FORWARD_METHOD(Func, hexagon)
+    HALIDE_FORWARD_METHOD(Func, hoist_storage)
+    HALIDE_FORWARD_METHOD(Func, hoist_storage_root)
     HALIDE_FORWARD_METHOD(Func, in)
     HALIDE_FORWARD_METHOD(Func, memoize)
     HALIDE_FORWARD_METHOD_CONST(Func, num_update_definitions)
@@ -2649,9 +2649,185 @@ HALIDE_ALWAYS_INLINE bool evaluate_predicate(Pattern p, MatcherState &state) {
 // correctness_simplify with this on.
 #define HALIDE_FUZZ_TEST_RULES 0
 
+// The IR node types that a pattern could match at its root, as a
+// bitmask indexed by IRNodeType. Unlike min_node_type and
+// max_node_type, which are only used to check that rules are
+// canonical, this is exact, so it can be used to skip rules that can't
+// possibly match. Patterns not listed here could match anything.
+constexpr uint64_t node_type_bit(IRNodeType t) {
+    return (uint64_t)1 << (int)t;
+}
+
+constexpr uint64_t broadcast_or_const_node_types =
+    (node_type_bit(IRNodeType::IntImm) |
+     node_type_bit(IRNodeType::UIntImm) |
+     node_type_bit(IRNodeType::FloatImm) |
+     node_type_bit(IRNodeType::Broadcast));
+
+template<typename T>
+struct root_node_types {
+    constexpr static uint64_t mask = ~(uint64_t)0;
+};
+
+template<int i>
+struct root_node_types<WildConstInt<i>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::IntImm) | node_type_bit(IRNodeType::Broadcast);
+};
+
+template<int i>
+struct root_node_types<WildConstUInt<i>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::UIntImm) | node_type_bit(IRNodeType::Broadcast);
+};
+
+template<int i>
+struct root_node_types<WildConstFloat<i>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::FloatImm) | node_type_bit(IRNodeType::Broadcast);
+};
+
+template<int i>
+struct root_node_types<WildConst<i>> {
+    constexpr static uint64_t mask = broadcast_or_const_node_types;
+};
+
+template<>
+struct root_node_types<IntLiteral> {
+    constexpr static uint64_t mask = broadcast_or_const_node_types;
+};
+
+template<typename Op, typename A, typename B>
+struct root_node_types<BinOp<Op, A, B>> {
+    constexpr static uint64_t mask = node_type_bit(Op::_node_type);
+};
+
+template<typename Op, typename A, typename B>
+struct root_node_types<CmpOp<Op, A, B>> {
+    constexpr static uint64_t mask = node_type_bit(Op::_node_type);
+};
+
+template<typename... Args>
+struct root_node_types<Intrin<Args...>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::Call);
+};
+
+template<typename A>
+struct root_node_types<NotOp<A>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::Not);
+};
+
+template<typename C, typename T, typename F>
+struct root_node_types<SelectOp<C, T, F>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::Select);
+};
+
+template<typename A, typename B>
+struct root_node_types<BroadcastOp<A, B>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::Broadcast);
+};
+
+template<typename A, typename B, typename C>
+struct root_node_types<RampOp<A, B, C>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::Ramp);
+};
+
+template<typename A, typename B, VectorReduce::Operator reduce_op>
+struct root_node_types<VectorReduceOp<A, B, reduce_op>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::VectorReduce);
+};
+
+template<typename A>
+struct root_node_types<NegateOp<A>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::Sub);
+};
+
+template<typename A>
+struct root_node_types<CastOp<A>> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::Cast);
+};
+
+template<>
+struct root_node_types<Overflow> {
+    constexpr static uint64_t mask = node_type_bit(IRNodeType::Call);
+};
+
+// The node types of the operands of the instance a Rewriter was
+// constructed with. These are computed once, and then each rule first
+// checks the root node types of its operands against them with a
+// bitwise and, so the common case of a rule that fails on the type of
+// one of the operands is rejected without walking the instance. This
+// is done for the instances the simplifier uses most, which are binary
+// ops, comparisons, and selects of concrete Exprs. For other instances
+// every rule is tried.
+template<typename Instance>
+struct OperandTypes {
+    HALIDE_ALWAYS_INLINE
+    explicit OperandTypes(const Instance &) {
+    }
+
+    template<typename Before>
+    HALIDE_ALWAYS_INLINE bool may_match(const Before &) const noexcept {
+        return true;
+    }
+};
+
+template<template<typename, typename, typename> class Pattern, typename Op>
+struct BinaryOperandTypes {
+    uint64_t a, b;
+
+    HALIDE_ALWAYS_INLINE
+    explicit BinaryOperandTypes(const Pattern<Op, SpecificExpr, SpecificExpr> &instance)
+        : a(node_type_bit(instance.a.expr.node_type)),
+          b(node_type_bit(instance.b.expr.node_type)) {
+    }
+
+    template<typename Before>
+    HALIDE_ALWAYS_INLINE bool may_match(const Before &) const noexcept {
+        return true;
+    }
+
+    template<typename A, typename B>
+    HALIDE_ALWAYS_INLINE bool may_match(const Pattern<Op, A, B> &) const noexcept {
+        return (root_node_types<A>::mask & a) && (root_node_types<B>::mask & b);
+    }
+};
+
+template<typename Op>
+struct OperandTypes<BinOp<Op, SpecificExpr, SpecificExpr>> : BinaryOperandTypes<BinOp, Op> {
+    using BinaryOperandTypes<BinOp, Op>::BinaryOperandTypes;
+};
+
+template<typename Op>
+struct OperandTypes<CmpOp<Op, SpecificExpr, SpecificExpr>> : BinaryOperandTypes<CmpOp, Op> {
+    using BinaryOperandTypes<CmpOp, Op>::BinaryOperandTypes;
+};
+
+template<>
+struct OperandTypes<SelectOp<SpecificExpr, SpecificExpr, SpecificExpr>> {
+    uint64_t c, t, f;
+
+    HALIDE_ALWAYS_INLINE
+    explicit OperandTypes(const SelectOp<SpecificExpr, SpecificExpr, SpecificExpr> &instance)
+        : c(node_type_bit(instance.c.expr.node_type)),
+          t(node_type_bit(instance.t.expr.node_type)),
+          f(node_type_bit(instance.f.expr.node_type)) {
+    }
+
+    template<typename Before>
+    HALIDE_ALWAYS_INLINE bool may_match(const Before &) const noexcept {
+        return true;
+    }
+
+    template<typename C, typename T, typename F>
+    HALIDE_ALWAYS_INLINE bool may_match(const SelectOp<C, T, F> &) const noexcept {
+        return ((root_node_types<C>::mask & c) &&
+                (root_node_types<T>::mask & t) &&
+                (root_node_types<F>::mask & f));
+    }
+};
+
 template<typename Instance>
 struct Rewriter {
     Instance instance;
+    OperandTypes<Instance> operand_types;
     Expr result;
     MatcherState state;
     halide_type_t output_type, wildcard_type;
@@ -2659,7 +2835,7 @@ struct Rewriter {
 
     HALIDE_ALWAYS_INLINE
     Rewriter(Instance instance, halide_type_t ot, halide_type_t wt)
-        : instance(std::move(instance)), output_type(ot), wildcard_type(wt) {
+        : instance(std::move(instance)), operand_types(this->instance), output_type(ot), wildcard_type(wt) {
     }
 
     template<typename After>
@@ -2678,7 +2854,8 @@ struct Rewriter {
 #if HALIDE_FUZZ_TEST_RULES
         fuzz_test_rule(before, after, true, wildcard_type, output_type);
 #endif
-        if (before.template match<0>(unwrap(instance), state)) {
+        if (operand_types.may_match(before) &&
+            before.template match<0>(unwrap(instance), state)) {
 #if HALIDE_DEBUG_MATCHED_RULES
             debug(0) << instance << " -> " << result << " via " << before << " -> " << after << "\n";
 #endif
@@ -2696,7 +2873,8 @@ struct Rewriter {
              typename = typename enable_if_pattern<Before>::type>
     HALIDE_ALWAYS_INLINE bool operator()(Before before, const Expr &after) noexcept {
         static_assert(Before::canonical, "LHS of rewrite rule should be in canonical form");
-        if (before.template match<0>(unwrap(instance), state)) {
+        if (operand_types.may_match(before) &&
+            before.template match<0>(unwrap(instance), state)) {
             result = after;
 #if HALIDE_DEBUG_MATCHED_RULES
             debug(0) << instance << " -> " << result << " via " << before << " -> " << after << "\n";
@@ -2717,7 +2895,8 @@ struct Rewriter {
 #if HALIDE_FUZZ_TEST_RULES
         fuzz_test_rule(before, IntLiteral(after), true, wildcard_type, output_type);
 #endif
-        if (before.template match<0>(unwrap(instance), state)) {
+        if (operand_types.may_match(before) &&
+            before.template match<0>(unwrap(instance), state)) {
             result = make_const(output_type, after);
 #if HALIDE_DEBUG_MATCHED_RULES
             debug(0) << instance << " -> " << result << " via " << before << " -> " << after << "\n";
@@ -2747,7 +2926,8 @@ struct Rewriter {
 #if HALIDE_FUZZ_TEST_RULES
         fuzz_test_rule(before, after, pred, wildcard_type, output_type);
 #endif
-        if (before.template match<0>(unwrap(instance), state) &&
+        if (operand_types.may_match(before) &&
+            before.template match<0>(unwrap(instance), state) &&
             evaluate_predicate(pred, state)) {
 #if HALIDE_DEBUG_MATCHED_RULES
             debug(0) << instance << " -> " << result << " via " << before << " -> " << after << " when " << pred << "\n";
@@ -2770,7 +2950,8 @@ struct Rewriter {
         static_assert(Predicate::foldable, "Predicates must consist only of operations that can constant-fold");
         static_assert(Before::canonical, "LHS of rewrite rule should be in canonical form");
 
-        if (before.template match<0>(unwrap(instance), state) &&
+        if (operand_types.may_match(before) &&
+            before.template match<0>(unwrap(instance), state) &&
             evaluate_predicate(pred, state)) {
             result = after;
 #if HALIDE_DEBUG_MATCHED_RULES
@@ -2795,7 +2976,8 @@ struct Rewriter {
 #if HALIDE_FUZZ_TEST_RULES
         fuzz_test_rule(before, IntLiteral(after), pred, wildcard_type, output_type);
 #endif
-        if (before.template match<0>(unwrap(instance), state) &&
+        if (operand_types.may_match(before) &&
+            before.template match<0>(unwrap(instance), state) &&
             evaluate_predicate(pred, state)) {
             result = make_const(output_type, after);
 #if HALIDE_DEBUG_MATCHED_RULES
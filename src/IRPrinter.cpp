@@ -8,6 +8,7 @@
 #include "IROperator.h"
 #include "Module.h"
 #include "Target.h"
+#include "Util.h"
 
 namespace Halide {
 
@@ -222,6 +223,17 @@ void IRPrinter::test() {
                        << "Actual output:\n"
                        << source.str();
     }
+
+    // IRPrinter rounds these constants to the same text, but
+    // ExactIRPrinter must tell them apart.
+    Expr c1 = Variable::make(Float(32), "v") * 1.0000001f;
+    Expr c2 = Variable::make(Float(32), "v") * 1.0000002f;
+    ostringstream exact1, exact2;
+    ExactIRPrinter(exact1).print(c1);
+    ExactIRPrinter(exact2).print(c2);
+    internal_assert(exact1.str() != exact2.str())
+        << "ExactIRPrinter printed " << exact1.str() << " and " << exact2.str() << "\n";
+
     std::cout << "IRPrinter test passed\n";
 }
 
@@ -1035,5 +1047,30 @@ void IRPrinter::visit(const Atomic *op) {
     stream << get_indent() << "}\n";
 }
 
+ExactIRPrinter::ExactIRPrinter(ostream &s)
+    : IRPrinter(s) {
+}
+
+void ExactIRPrinter::visit(const FloatImm *op) {
+    // Print the bits of the double that holds the value, which
+    // represents narrower types exactly too.
+    stream << "(" << op->type << ")bits" << reinterpret_bits<uint64_t>(op->value);
+}
+
+void ExactIRPrinter::visit(const Load *op) {
+    IRPrinter::visit(op);
+    stream << "aligned(" << op->alignment.modulus << ", " << op->alignment.remainder << ")";
+}
+
+void ExactIRPrinter::visit(const Call *op) {
+    stream << "call" << (int)op->call_type << "." << op->value_index << ":";
+    IRPrinter::visit(op);
+}
+
+void ExactIRPrinter::visit(const Store *op) {
+    stream << get_indent() << "aligned(" << op->alignment.modulus << ", " << op->alignment.remainder << ")\n";
+    IRPrinter::visit(op);
+}
+
 }  // namespace Internal
 }  // namespace Halide
@@ -194,6 +194,24 @@ protected:
     void visit(const Atomic *) override;
 };
 
+/** An IRPrinter that also prints the details that IRPrinter leaves out
+ * for readability, such as call types and the alignment of every load
+ * and store, and that prints floating-point constants exactly. Two
+ * Exprs or Stmts print the same only if they generate the same code,
+ * so the output can be used as the key of a cache of compiled code. */
+class ExactIRPrinter : public IRPrinter {
+public:
+    explicit ExactIRPrinter(std::ostream &);
+
+protected:
+    using IRPrinter::visit;
+
+    void visit(const FloatImm *) override;
+    void visit(const Load *) override;
+    void visit(const Call *) override;
+    void visit(const Store *) override;
+};
+
 }  // namespace Internal
 }  // namespace Halide
 
@@ -1,6 +1,9 @@
+#include <array>
 #include <cstdint>
+#include <iomanip>
 #include <mutex>
 #include <set>
+#include <sstream>
 #include <string>
 
 #ifdef _WIN32
@@ -16,6 +19,7 @@
 #include "CodeGen_Internal.h"
 #include "CodeGen_LLVM.h"
 #include "Debug.h"
+#include "IRPrinter.h"
 #include "JITModule.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Output.h"
@@ -158,7 +162,9 @@ namespace {
 JITModule::Symbol compile_and_get_function(ExecutionEngine &ee, const string &name) {
     debug(2) << "JIT Compiling " << name << "\n";
     llvm::Function *fn = ee.FindFunctionNamed(name);
-    internal_assert(fn->getName() == name);
+    // The function may be missing from the IR if the machine code
+    // came from an object cache.
+    internal_assert(!fn || fn->getName() == name);
     void *f = (void *)ee.getFunctionAddress(name);
     if (!f) {
         internal_error << "Compiling " << name << " returned nullptr\n";
@@ -224,6 +230,152 @@ public:
     }
 };
 
+// An on-disk cache of JIT-compiled machine code, enabled by setting
+// HL_JIT_CACHE_DIR. Entries are keyed on a hash of the lowered Halide
+// module, the target, and the Halide and LLVM versions. Each entry is a
+// pair of files: the object code, and a small bitcode stub holding the
+// triple, data layout, and target options of the llvm::Module it was
+// compiled from. On a hit, the stub stands in for the real module, so we
+// skip both LLVM IR generation and LLVM optimization and codegen.
+class JITDiskCache : public llvm::ObjectCache {
+    string object_path, stub_path;
+    bool hit = false;
+
+    // Print everything about a module that can change its machine
+    // code. The module printer of IRPrinter would round floating-point
+    // constants and leave out argument types, among other things.
+    static void print_module(std::ostream &key, const Module &m) {
+        for (const Module &sub : m.submodules()) {
+            print_module(key, sub);
+        }
+        key << "module " << m.name() << " " << m.target().to_string() << "\n";
+        for (const Buffer<> &b : m.buffers()) {
+            key << "buffer " << b.name() << " " << b.type();
+            for (int i = 0; i < b.dimensions(); i++) {
+                key << " [" << b.dim(i).min() << ", " << b.dim(i).extent() << ", " << b.dim(i).stride() << "]";
+            }
+            key << "\n";
+            if (b.data()) {
+                key << b.size_in_bytes() << " bytes\n";
+                key.write((const char *)b.data(), b.size_in_bytes());
+            }
+        }
+        for (const ExternalCode &code : m.external_code()) {
+            key << "external code " << code.name() << " " << code.contents().size() << " bytes\n";
+            key.write((const char *)code.contents().data(), code.contents().size());
+        }
+        for (const LoweredFunc &f : m.functions()) {
+            key << f.linkage << " " << f.name_mangling << " func " << f.name << " (";
+            for (const LoweredArgument &arg : f.args) {
+                key << arg.name << " " << (int)arg.kind << " " << (int)arg.dimensions << " " << arg.type << ", ";
+            }
+            key << ") {\n";
+            ExactIRPrinter(key).print(f.body);
+            key << "}\n";
+        }
+    }
+
+    static string compute_key(const Module &m, const LoweredFunc &fn) {
+        std::ostringstream key;
+        key << "halide_jit_cache_v2\n"
+#ifdef HALIDE_VERSION_MAJOR
+            << "halide " << HALIDE_VERSION_MAJOR << "." << HALIDE_VERSION_MINOR << "." << HALIDE_VERSION_PATCH << "\n"
+#endif
+            << "llvm " << LLVM_VERSION << "\n"
+            << "entrypoint " << fn.name << "\n";
+        print_module(key, m);
+        string str = key.str();
+        std::array<uint8_t, 20> hash = llvm::SHA1::hash(llvm::arrayRefFromStringRef(str));
+        std::ostringstream hex;
+        for (uint8_t c : hash) {
+            hex << std::hex << std::setw(2) << std::setfill('0') << (int)c;
+        }
+        return hex.str();
+    }
+
+    static bool write_atomically(const string &path, llvm::StringRef data) {
+        // Write to a temporary file and rename it into place, so that
+        // concurrent processes never see a partially-written entry.
+        llvm::SmallString<128> temp_path;
+        int fd;
+        if (llvm::sys::fs::createUniqueFile(path + ".tmp%%%%%%", fd, temp_path)) {
+            return false;
+        }
+        {
+            llvm::raw_fd_ostream out(fd, /* shouldClose */ true);
+            out << data;
+            out.close();
+            if (out.has_error()) {
+                out.clear_error();
+                llvm::sys::fs::remove(temp_path);
+                return false;
+            }
+        }
+        if (llvm::sys::fs::rename(temp_path, path)) {
+            llvm::sys::fs::remove(temp_path);
+            return false;
+        }
+        return true;
+    }
+
+public:
+    JITDiskCache(const string &dir, const Module &m, const LoweredFunc &fn) {
+        string key = compute_key(m, fn);
+        object_path = dir + "/" + key + ".o";
+        stub_path = dir + "/" + key + ".bc";
+    }
+
+    /** Returns the stub module if this entry is in the cache, or nullptr. */
+    std::unique_ptr<llvm::Module> load_stub(llvm::LLVMContext &context) {
+        if (!file_exists(object_path) || !file_exists(stub_path)) {
+            return nullptr;
+        }
+        auto buf = llvm::MemoryBuffer::getFile(stub_path);
+        if (!buf) {
+            return nullptr;
+        }
+        auto stub = llvm::parseBitcodeFile((*buf)->getMemBufferRef(), context);
+        if (!stub) {
+            llvm::consumeError(stub.takeError());
+            return nullptr;
+        }
+        debug(1) << "JIT cache hit: " << object_path << "\n";
+        hit = true;
+        return std::move(*stub);
+    }
+
+    void notifyObjectCompiled(const llvm::Module *m, llvm::MemoryBufferRef obj) override {
+        if (hit) {
+            return;
+        }
+        llvm::Module stub(m->getModuleIdentifier(), m->getContext());
+        stub.setDataLayout(m->getDataLayout());
+        clone_target_options(*m, stub);
+        std::string bitcode;
+        llvm::raw_string_ostream bitcode_stream(bitcode);
+        llvm::WriteBitcodeToFile(stub, bitcode_stream);
+        bitcode_stream.flush();
+
+        // Write the object first, so that a visible stub implies a
+        // complete object.
+        if (write_atomically(object_path, obj.getBuffer()) &&
+            write_atomically(stub_path, bitcode)) {
+            debug(1) << "JIT cache wrote: " << object_path << "\n";
+        } else {
+            debug(1) << "JIT cache failed to write: " << object_path << "\n";
+        }
+    }
+
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *) override {
+        if (!hit) {
+            return nullptr;
+        }
+        auto buf = llvm::MemoryBuffer::getFile(object_path);
+        internal_assert(buf) << "JIT cache entry disappeared: " << object_path << "\n";
+        return std::move(*buf);
+    }
+};
+
 }  // namespace
 
 JITModule::JITModule() {
@@ -233,18 +385,34 @@ JITModule::JITModule() {
 JITModule::JITModule(const Module &m, const LoweredFunc &fn,
                      const std::vector<JITModule> &dependencies) {
     jit_module = new JITModuleContents();
-    std::unique_ptr<llvm::Module> llvm_module(compile_module_to_llvm_module(m, jit_module->context));
+
+    std::unique_ptr<llvm::Module> llvm_module;
+    std::unique_ptr<JITDiskCache> disk_cache;
+    string cache_dir = get_env_variable("HL_JIT_CACHE_DIR");
+    if (!cache_dir.empty()) {
+        if (llvm::sys::fs::create_directories(cache_dir)) {
+            debug(1) << "Could not create JIT cache directory " << cache_dir << "\n";
+        } else {
+            disk_cache = std::make_unique<JITDiskCache>(cache_dir, m, fn);
+            llvm_module = disk_cache->load_stub(jit_module->context);
+        }
+    }
+    if (!llvm_module) {
+        llvm_module = compile_module_to_llvm_module(m, jit_module->context);
+    }
+
     std::vector<JITModule> deps_with_runtime = dependencies;
     std::vector<JITModule> shared_runtime = JITSharedRuntime::get(llvm_module.get(), m.target());
     deps_with_runtime.insert(deps_with_runtime.end(), shared_runtime.begin(), shared_runtime.end());
-    compile_module(std::move(llvm_module), fn.name, m.target(), deps_with_runtime);
+    compile_module(std::move(llvm_module), fn.name, m.target(), deps_with_runtime, {}, disk_cache.get());
     // If -time-passes is in HL_LLVM_ARGS, this will print llvm passes time statstics otherwise its no-op.
     llvm::reportAndResetTimings();
 }
 
 void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &function_name, const Target &target,
                                const std::vector<JITModule> &dependencies,
-                               const std::vector<std::string> &requested_exports) {
+                               const std::vector<std::string> &requested_exports,
+                               llvm::ObjectCache *object_cache) {
 
     // Ensure that LLVM is initialized
     CodeGen_LLVM::initialize_llvm();
@@ -310,6 +478,14 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
     debug(1) << "JIT compiling " << module_name
              << " for " << target.to_string() << "\n";
 
+    if (object_cache) {
+        // Generate (or load) all the code up front. A stub module
+        // from the cache has no IR for the functions we are about to
+        // look up, so they would not trigger compilation.
+        ee->setObjectCache(object_cache);
+        ee->finalizeObject();
+    }
+
     std::map<std::string, Symbol> exports;
 
     Symbol entrypoint;
@@ -327,6 +503,9 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
 
     debug(2) << "Finalizing object\n";
     ee->finalizeObject();
+    if (object_cache) {
+        ee->setObjectCache(nullptr);
+    }
     // Do any target-specific post-compilation module meddling
     for (size_t i = 0; i < listeners.size(); i++) {
         ee->UnregisterJITEventListener(listeners[i]);
@@ -457,6 +636,22 @@ void JITModule::memoization_cache_evict(uint64_t eviction_key) const {
     }
 }
 
+void JITModule::memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_set_eviction_policy");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(halide_memoization_cache_eviction_policy_t)>(f->second.address))(policy);
+    }
+}
+
+void JITModule::memoization_cache_get_stats(halide_memoization_cache_stats_t *stats) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_get_stats");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(halide_memoization_cache_stats_t *)>(f->second.address))(stats);
+    }
+}
+
 void JITModule::reuse_device_allocations(bool b) const {
     std::map<std::string, Symbol>::const_iterator f =
         exports().find("halide_reuse_device_allocations");
@@ -465,6 +660,14 @@ void JITModule::reuse_device_allocations(bool b) const {
     }
 }
 
+void JITModule::reuse_host_allocations(bool b) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_reuse_host_allocations");
+    if (f != exports().end()) {
+        (reinterpret_bits<int (*)(void *, bool)>(f->second.address))(nullptr, b);
+    }
+}
+
 bool JITModule::compiled() const {
     return jit_module->execution_engine != nullptr;
 }
@@ -475,6 +678,7 @@ JITHandlers runtime_internal_handlers;
 JITHandlers default_handlers;
 JITHandlers active_handlers;
 int64_t default_cache_size;
+halide_memoization_cache_eviction_policy_t default_eviction_policy = halide_memoization_cache_evict_lru;
 
 void merge_handlers(JITHandlers &base, const JITHandlers &addins) {
     if (addins.custom_print) {
@@ -798,6 +1002,9 @@ JITModule &make_module(llvm::Module *for_module, Target target,
             if (default_cache_size != 0) {
                 runtime.memoization_cache_set_size(default_cache_size);
             }
+            if (default_eviction_policy != halide_memoization_cache_evict_lru) {
+                runtime.memoization_cache_set_eviction_policy(default_eviction_policy);
+            }
 
             runtime.jit_module->name = "MainShared";
         } else {
@@ -927,10 +1134,31 @@ void JITSharedRuntime::memoization_cache_evict(uint64_t eviction_key) {
     shared_runtimes(MainShared).memoization_cache_evict(eviction_key);
 }
 
+void JITSharedRuntime::memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+
+    if (policy != default_eviction_policy) {
+        default_eviction_policy = policy;
+        shared_runtimes(MainShared).memoization_cache_set_eviction_policy(policy);
+    }
+}
+
+halide_memoization_cache_stats_t JITSharedRuntime::memoization_cache_get_stats() {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    halide_memoization_cache_stats_t stats = {};
+    shared_runtimes(MainShared).memoization_cache_get_stats(&stats);
+    return stats;
+}
+
 void JITSharedRuntime::reuse_device_allocations(bool b) {
     std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
     shared_runtimes(MainShared).reuse_device_allocations(b);
 }
 
+void JITSharedRuntime::reuse_host_allocations(bool b) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    shared_runtimes(MainShared).reuse_host_allocations(b);
+}
+
 }  // namespace Internal
 }  // namespace Halide
@@ -15,6 +15,7 @@
 
 namespace llvm {
 class Module;
+class ObjectCache;
 }
 
 namespace Halide {
@@ -118,11 +119,14 @@ struct JITModule {
     Symbol find_symbol_by_name(const std::string &) const;
 
     /** Take an llvm module and compile it. The requested exports will
-        be available via the exports method. */
+        be available via the exports method. If an object cache is
+        given, the machine code may come from it instead of from
+        compiling the module. */
     void compile_module(std::unique_ptr<llvm::Module> mod,
                         const std::string &function_name, const Target &target,
                         const std::vector<JITModule> &dependencies = std::vector<JITModule>(),
-                        const std::vector<std::string> &requested_exports = std::vector<std::string>());
+                        const std::vector<std::string> &requested_exports = std::vector<std::string>(),
+                        llvm::ObjectCache *object_cache = nullptr);
 
     /** See JITSharedRuntime::memoization_cache_set_size */
     void memoization_cache_set_size(int64_t size) const;
@@ -130,9 +134,18 @@ struct JITModule {
     /** See JITSharedRuntime::memoization_cache_evict */
     void memoization_cache_evict(uint64_t eviction_key) const;
 
+    /** See JITSharedRuntime::memoization_cache_set_eviction_policy */
+    void memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy) const;
+
+    /** See JITSharedRuntime::memoization_cache_get_stats */
+    void memoization_cache_get_stats(halide_memoization_cache_stats_t *stats) const;
+
     /** See JITSharedRuntime::reuse_device_allocations */
     void reuse_device_allocations(bool) const;
 
+    /** See JITSharedRuntime::reuse_host_allocations */
+    void reuse_host_allocations(bool) const;
+
     /** Return true if compile_module has been called on this module. */
     bool compiled() const;
 };
@@ -177,6 +190,18 @@ public:
      */
     static void memoization_cache_evict(uint64_t eviction_key);
 
+    /** Select how the memoization cache chooses entries to evict. If
+     * you are compiling statically, you should include HalideRuntime.h
+     * and call halide_memoization_cache_set_eviction_policy()
+     * instead. */
+    static void memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy);
+
+    /** Get the hit, miss and eviction counts and the current size of
+     * the memoization cache. If you are compiling statically, you
+     * should include HalideRuntime.h and call
+     * halide_memoization_cache_get_stats() instead. */
+    static halide_memoization_cache_stats_t memoization_cache_get_stats();
+
     /** Set whether or not Halide may hold onto and reuse device
      * allocations to avoid calling expensive device API allocation
      * functions. If you are compiling statically, you should include
@@ -184,6 +209,13 @@ public:
      * instead. */
     static void reuse_device_allocations(bool);
 
+    /** Set whether or not Halide's default host allocator may hold
+     * onto and reuse freed allocations instead of returning them to
+     * the system allocator. If you are compiling statically, you
+     * should include HalideRuntime.h and call
+     * halide_reuse_host_allocations instead. */
+    static void reuse_host_allocations(bool);
+
     static void release_all();
 };
 
@@ -6,8 +6,10 @@
 #include "LLVM_Headers.h"
 #include "LLVM_Runtime_Linker.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
 
 #ifdef _WIN32
 #ifndef NOMINMAX
@@ -382,6 +384,8 @@ void emit_file(const llvm::Module &module_in, Internal::LLVMOStream &out,
     // Ask the target to add backend passes as necessary.
     target_machine->addPassesToEmitFile(pass_manager, out, nullptr, file_type);
 
+    auto codegen_start = std::chrono::high_resolution_clock::now();
+    const int64_t ir_size = module->getInstructionCount();
     pass_manager.run(*module);
 
     auto *logger = Internal::get_compiler_logger();
@@ -389,6 +393,11 @@ void emit_file(const llvm::Module &module_in, Internal::LLVMOStream &out,
         auto time_end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> diff = time_end - time_start;
         logger->record_compilation_time(Internal::CompilerLogger::Phase::LLVM, diff.count());
+        // The backend passes run by the legacy pass manager aren't
+        // instrumented individually, so record them as a whole.
+        std::chrono::duration<double> codegen_diff = time_end - codegen_start;
+        logger->record_compilation_pass(Internal::CompilerLogger::Phase::LLVM, "CodeGen", codegen_diff.count(),
+                                        ir_size, ir_size, Internal::get_peak_memory_usage());
     }
 
     // If -time-passes is in HL_LLVM_ARGS, this will print llvm passes time statstics otherwise its no-op.
@@ -415,6 +424,131 @@ void compile_llvm_module_to_llvm_assembly(llvm::Module &module, Internal::LLVMOS
     module.print(out, nullptr);
 }
 
+namespace {
+
+// Make the local symbols of a module external and hidden, so that
+// partitions of it can refer to each other's symbols. Each is renamed
+// with the name of the module as a prefix. Module names are the names
+// of the exported pipeline functions, so the new names can't collide
+// with the symbols of another module in the same link.
+void externalize_local_symbols(llvm::Module &module) {
+    const std::string prefix = module.getModuleIdentifier() + ".";
+    int unnamed = 0;
+    for (llvm::GlobalValue &gv : module.global_values()) {
+        if (!gv.hasLocalLinkage() || gv.getName().startswith("llvm.")) {
+            continue;
+        }
+        if (gv.hasName()) {
+            gv.setName(prefix + gv.getName().str());
+        } else {
+            gv.setName(prefix + "unnamed." + std::to_string(unnamed++));
+        }
+        gv.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        gv.setVisibility(llvm::GlobalValue::HiddenVisibility);
+    }
+}
+
+}  // namespace
+
+void compile_llvm_module_to_objects(llvm::Module &module, const std::vector<std::string> &filenames) {
+    internal_assert(!filenames.empty());
+    const size_t n = filenames.size();
+
+    std::unique_ptr<llvm::Module> clone = clone_module(module);
+
+    // Local symbols referenced from module-level inline asm can't be
+    // renamed, local symbols in a comdat can't be made external, and
+    // aliases must stay with their aliasees, so modules with any of
+    // these aren't split.
+    bool splittable = n > 1 && clone->getModuleInlineAsm().empty() &&
+                      clone->alias_empty() && clone->ifunc_empty();
+    for (const llvm::GlobalValue &gv : clone->global_values()) {
+        splittable = splittable && !(gv.hasLocalLinkage() && gv.hasComdat());
+    }
+
+    // Move the bodies of parallel tasks (marked by CodeGen_LLVM) into
+    // the partitions, largest first, each into the partition with the
+    // least code so far. Everything else stays in the first partition,
+    // including the entry points, the runtime, and the global
+    // constructors and destructors. The first partition refers to every
+    // task, so a link that uses the first object keeps all the others.
+    std::map<std::string, size_t> partition_of;
+    if (splittable) {
+        externalize_local_symbols(*clone);
+        std::vector<std::pair<unsigned, std::string>> tasks;
+        std::vector<uint64_t> sizes(n, 0);
+        for (const llvm::Function &f : *clone) {
+            if (f.isDeclaration()) {
+                continue;
+            } else if (f.hasFnAttribute("halide-parallel-task")) {
+                tasks.emplace_back(f.getInstructionCount(), f.getName().str());
+            } else {
+                sizes[0] += f.getInstructionCount();
+            }
+        }
+        std::stable_sort(tasks.begin(), tasks.end(),
+                         [](const std::pair<unsigned, std::string> &a,
+                            const std::pair<unsigned, std::string> &b) {
+                             return a.first > b.first;
+                         });
+        for (const auto &task : tasks) {
+            size_t p = std::min_element(sizes.begin(), sizes.end()) - sizes.begin();
+            sizes[p] += task.first;
+            partition_of[task.second] = p;
+        }
+        Internal::debug(1) << "Splitting " << tasks.size() << " parallel tasks of "
+                           << module.getModuleIdentifier() << " across " << n << " objects\n";
+    }
+
+    // LLVM contexts can only be used on one thread at a time, so each
+    // compile job parses the module from bitcode into a context of its
+    // own, and then deletes the definitions that belong to other
+    // partitions. (As in clone_module, this avoids llvm::CloneModule.)
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream stream(bitcode);
+    WriteBitcodeToFile(*clone, stream);
+    clone.reset();
+
+    Internal::run_compile_jobs(n, [&](size_t i) {
+        llvm::LLVMContext context;
+        llvm::MemoryBufferRef buffer(llvm::StringRef(bitcode.data(), bitcode.size()), filenames[i]);
+        auto parsed = llvm::parseBitcodeFile(buffer, context);
+        internal_assert(parsed) << "Could not parse partition " << i << " of " << module.getModuleIdentifier() << "\n";
+        llvm::Module &part = **parsed;
+
+        auto belongs_here = [&](const llvm::GlobalValue &gv) {
+            auto it = partition_of.find(gv.getName().str());
+            return (it == partition_of.end() ? 0 : it->second) == i;
+        };
+        for (llvm::Function &f : part) {
+            if (!f.isDeclaration() && !belongs_here(f)) {
+                f.deleteBody();
+                f.setComdat(nullptr);
+            }
+        }
+        std::vector<llvm::GlobalVariable *> dead;
+        for (llvm::GlobalVariable &g : part.globals()) {
+            if (g.isDeclaration() || belongs_here(g)) {
+                continue;
+            } else if (g.hasAppendingLinkage()) {
+                // e.g. llvm.global_ctors, which only the first
+                // partition defines.
+                dead.push_back(&g);
+            } else {
+                g.setInitializer(nullptr);
+                g.setLinkage(llvm::GlobalValue::ExternalLinkage);
+                g.setComdat(nullptr);
+            }
+        }
+        for (llvm::GlobalVariable *g : dead) {
+            g->eraseFromParent();
+        }
+
+        auto out = make_raw_fd_ostream(filenames[i]);
+        compile_llvm_module_to_object(part, *out);
+    });
+}
+
 // Note that the utilities for get/set working directory are deliberately *not* in Util.h;
 // generally speaking, you shouldn't ever need or want to do this, and doing so is asking for
 // trouble. This exists solely to work around an issue with LLVM, hence its restricted
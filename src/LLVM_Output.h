@@ -39,6 +39,16 @@ void compile_llvm_module_to_object(llvm::Module &module, Internal::LLVMOStream &
 void compile_llvm_module_to_assembly(llvm::Module &module, Internal::LLVMOStream &out);
 // @}
 
+/** Compile an LLVM module to several objects, one per filename, which
+ * are compiled concurrently as compile jobs (see
+ * Internal::run_compile_jobs). The bodies of the module's parallel
+ * tasks are spread across the objects; everything else goes in the
+ * first one, which refers to all the others. Together, the objects
+ * define the same symbols as the object of the whole module, except
+ * that its local symbols become hidden symbols, named with the
+ * module's name as a prefix. */
+void compile_llvm_module_to_objects(llvm::Module &module, const std::vector<std::string> &filenames);
+
 /** Compile an LLVM module to LLVM targets (bitcode, LLVM assembly). */
 // @{
 void compile_llvm_module_to_llvm_bitcode(llvm::Module &module, Internal::LLVMOStream &out);
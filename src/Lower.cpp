@@ -83,11 +83,63 @@ using std::vector;
 
 namespace {
 
+// Count the distinct IR nodes in a Stmt.
+class CountIRNodes : public IRGraphVisitor {
+    using IRGraphVisitor::visit;
+
+    void include(const Expr &e) override {
+        if (nodes.insert(e.get()).second) {
+            e.accept(this);
+        }
+    }
+
+    void include(const Stmt &s) override {
+        if (nodes.insert(s.get()).second) {
+            s.accept(this);
+        }
+    }
+
+public:
+    std::set<const IRNode *> nodes;
+};
+
+int64_t count_ir_nodes(const Stmt &s) {
+    CountIRNodes counter;
+    if (s.defined()) {
+        counter.nodes.insert(s.get());
+        s.accept(&counter);
+    }
+    return (int64_t)counter.nodes.size();
+}
+
 class LoweringLogger {
     Stmt last_written;
 
+    // If there is an active CompilerLogger, the cost of each pass is
+    // recorded with it. A pass is everything that ran since the
+    // previous pass was recorded.
+    CompilerLogger *compiler_logger;
+    std::chrono::high_resolution_clock::time_point last_time;
+    int64_t last_ir_size = 0;
+
 public:
+    LoweringLogger()
+        : compiler_logger(get_compiler_logger()),
+          last_time(std::chrono::high_resolution_clock::now()) {
+    }
+
     void operator()(const string &message, const Stmt &s) {
+        // Messages are of the form "Lowering after <pass>:"
+        string pass_name = message;
+        const string prefix = "Lowering after ";
+        if (starts_with(pass_name, prefix)) {
+            pass_name = pass_name.substr(prefix.size());
+        }
+        if (ends_with(pass_name, ":")) {
+            pass_name.pop_back();
+        }
+        record_pass(pass_name, s);
+
         if (!s.same_as(last_written)) {
             debug(2) << message << "\n"
                      << s << "\n";
@@ -96,6 +148,19 @@ public:
             debug(2) << message << " (unchanged)\n\n";
         }
     }
+
+    void record_pass(const string &pass_name, const Stmt &s) {
+        if (!compiler_logger) {
+            return;
+        }
+        std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - last_time;
+        int64_t ir_size = count_ir_nodes(s);
+        compiler_logger->record_compilation_pass(CompilerLogger::Phase::HalideLowering, pass_name, duration.count(),
+                                                 last_ir_size, ir_size, get_peak_memory_usage());
+        last_ir_size = ir_size;
+        // Don't bill the time spent counting nodes to the next pass.
+        last_time = std::chrono::high_resolution_clock::now();
+    }
 };
 
 void lower_impl(const vector<Function> &output_funcs,
@@ -341,6 +406,7 @@ void lower_impl(const vector<Function> &output_funcs,
 
     debug(1) << "Rebasing loops to zero...\n";
     s = rebase_loops_to_zero(s);
+    log.record_pass("rebasing loops to zero", s);
     debug(2) << "Lowering after rebasing loops to zero:\n"
              << s << "\n\n";
 
@@ -368,7 +434,7 @@ void lower_impl(const vector<Function> &output_funcs,
 
     if (t.has_feature(Target::Profile)) {
         debug(1) << "Injecting profiling...\n";
-        s = inject_profiling(s, pipeline_name);
+        s = inject_profiling(s, pipeline_name, t.has_feature(Target::ProfileCounters));
         log("Lowering after injecting profiling:", s);
     }
 
@@ -380,6 +446,7 @@ void lower_impl(const vector<Function> &output_funcs,
 
     debug(1) << "Simplifying...\n";
     s = common_subexpression_elimination(s);
+    log.record_pass("common subexpression elimination", s);
 
     debug(1) << "Lowering unsafe promises...\n";
     s = lower_unsafe_promises(s, t);
@@ -407,6 +474,7 @@ void lower_impl(const vector<Function> &output_funcs,
         for (size_t i = 0; i < custom_passes.size(); i++) {
             debug(1) << "Running custom lowering pass " << i << "...\n";
             s = custom_passes[i]->mutate(s);
+            log.record_pass("custom pass " + std::to_string(i), s);
             debug(1) << "Lowering after custom pass " << i << ":\n"
                      << s << "\n\n";
         }
@@ -415,6 +483,7 @@ void lower_impl(const vector<Function> &output_funcs,
     if (t.arch != Target::Hexagon && t.has_feature(Target::HVX)) {
         debug(1) << "Splitting off Hexagon offload...\n";
         s = inject_hexagon_rpc(s, t, result_module);
+        log.record_pass("splitting off Hexagon offload", s);
         debug(2) << "Lowering after splitting off Hexagon offload:\n"
                  << s << "\n";
     } else {
@@ -424,6 +493,7 @@ void lower_impl(const vector<Function> &output_funcs,
     if (t.has_gpu_feature()) {
         debug(1) << "Offloading GPU loops...\n";
         s = inject_gpu_offload(s, t);
+        log.record_pass("splitting off GPU loops", s);
         debug(2) << "Lowering after splitting off GPU loops:\n"
                  << s << "\n\n";
     } else {
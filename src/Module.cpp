@@ -581,84 +581,123 @@ void Module::compile(const std::map<Output, std::string> &output_files) const {
         return;
     }
 
+    // With HL_LLVM_PARTITIONS=n for n > 1, the code in a static library
+    // is split into n objects, which are compiled concurrently once the
+    // other outputs are done.
+    const int partitions = std::max(1, atoi(get_env_variable("HL_LLVM_PARTITIONS").c_str()));
+
+    // The LLVM-based outputs and the C-family outputs are generated
+    // independently of each other, so they can be compiled concurrently.
+    std::vector<std::function<void()>> jobs;
     auto *logger = get_compiler_logger();
+    llvm::LLVMContext context;
+    std::unique_ptr<llvm::Module> llvm_module;
     if (contains(output_files, Output::object) || contains(output_files, Output::assembly) ||
         contains(output_files, Output::bitcode) || contains(output_files, Output::llvm_assembly) ||
         contains(output_files, Output::static_library)) {
-        llvm::LLVMContext context;
-        std::unique_ptr<llvm::Module> llvm_module(compile_module_to_llvm_module(*this, context));
-
-        if (contains(output_files, Output::object)) {
-            const auto &f = output_files.at(Output::object);
-            debug(1) << "Module.compile(): object " << f << "\n";
-            auto out = make_raw_fd_ostream(f);
-            compile_llvm_module_to_object(*llvm_module, *out);
-            if (logger) {
-                out->flush();
-                logger->record_object_code_size(file_stat(f).file_size);
-            }
-        }
-        if (contains(output_files, Output::static_library)) {
-            // To simplify the code, we always create a temporary object output
-            // here, even if output_files.at(Output::object) was also set: in practice,
-            // no real-world code ever sets both object and static_library
-            // at the same time, so there is no meaningful performance advantage
-            // to be had.
-            TemporaryObjectFileDir temp_dir;
-            {
-                std::string object = temp_dir.add_temp_object_file(output_files.at(Output::static_library), "", target());
-                debug(1) << "Module.compile(): temporary object " << object << "\n";
-                auto out = make_raw_fd_ostream(object);
+        jobs.emplace_back([&]() {
+            llvm_module = compile_module_to_llvm_module(*this, context);
+
+            if (contains(output_files, Output::object)) {
+                const auto &f = output_files.at(Output::object);
+                debug(1) << "Module.compile(): object " << f << "\n";
+                auto out = make_raw_fd_ostream(f);
                 compile_llvm_module_to_object(*llvm_module, *out);
-                out->flush();  // create_static_library() is happier if we do this
-                if (logger && !contains(output_files, Output::object)) {
-                    // Don't double-record object-code size if we already recorded it for object
-                    logger->record_object_code_size(file_stat(object).file_size);
+                if (logger) {
+                    out->flush();
+                    logger->record_object_code_size(file_stat(f).file_size);
                 }
             }
-            debug(1) << "Module.compile(): static_library " << output_files.at(Output::static_library) << "\n";
-            Target base_target(target().os, target().arch, target().bits);
-            create_static_library(temp_dir.files(), base_target, output_files.at(Output::static_library));
-        }
-        if (contains(output_files, Output::assembly)) {
-            debug(1) << "Module.compile(): assembly " << output_files.at(Output::assembly) << "\n";
-            auto out = make_raw_fd_ostream(output_files.at(Output::assembly));
-            compile_llvm_module_to_assembly(*llvm_module, *out);
-        }
-        if (contains(output_files, Output::bitcode)) {
-            debug(1) << "Module.compile(): bitcode " << output_files.at(Output::bitcode) << "\n";
-            auto out = make_raw_fd_ostream(output_files.at(Output::bitcode));
-            compile_llvm_module_to_llvm_bitcode(*llvm_module, *out);
-        }
-        if (contains(output_files, Output::llvm_assembly)) {
-            debug(1) << "Module.compile(): llvm_assembly " << output_files.at(Output::llvm_assembly) << "\n";
-            auto out = make_raw_fd_ostream(output_files.at(Output::llvm_assembly));
-            compile_llvm_module_to_llvm_assembly(*llvm_module, *out);
-        }
+            if (contains(output_files, Output::static_library) && partitions == 1) {
+                // To simplify the code, we always create a temporary object output
+                // here, even if output_files.at(Output::object) was also set: in practice,
+                // no real-world code ever sets both object and static_library
+                // at the same time, so there is no meaningful performance advantage
+                // to be had.
+                TemporaryObjectFileDir temp_dir;
+                {
+                    std::string object = temp_dir.add_temp_object_file(output_files.at(Output::static_library), "", target());
+                    debug(1) << "Module.compile(): temporary object " << object << "\n";
+                    auto out = make_raw_fd_ostream(object);
+                    compile_llvm_module_to_object(*llvm_module, *out);
+                    out->flush();  // create_static_library() is happier if we do this
+                    if (logger && !contains(output_files, Output::object)) {
+                        // Don't double-record object-code size if we already recorded it for object
+                        logger->record_object_code_size(file_stat(object).file_size);
+                    }
+                }
+                debug(1) << "Module.compile(): static_library " << output_files.at(Output::static_library) << "\n";
+                Target base_target(target().os, target().arch, target().bits);
+                create_static_library(temp_dir.files(), base_target, output_files.at(Output::static_library));
+            }
+            if (contains(output_files, Output::assembly)) {
+                debug(1) << "Module.compile(): assembly " << output_files.at(Output::assembly) << "\n";
+                auto out = make_raw_fd_ostream(output_files.at(Output::assembly));
+                compile_llvm_module_to_assembly(*llvm_module, *out);
+            }
+            if (contains(output_files, Output::bitcode)) {
+                debug(1) << "Module.compile(): bitcode " << output_files.at(Output::bitcode) << "\n";
+                auto out = make_raw_fd_ostream(output_files.at(Output::bitcode));
+                compile_llvm_module_to_llvm_bitcode(*llvm_module, *out);
+            }
+            if (contains(output_files, Output::llvm_assembly)) {
+                debug(1) << "Module.compile(): llvm_assembly " << output_files.at(Output::llvm_assembly) << "\n";
+                auto out = make_raw_fd_ostream(output_files.at(Output::llvm_assembly));
+                compile_llvm_module_to_llvm_assembly(*llvm_module, *out);
+            }
+        });
     }
     if (contains(output_files, Output::c_header)) {
-        debug(1) << "Module.compile(): c_header " << output_files.at(Output::c_header) << "\n";
-        std::ofstream file(output_files.at(Output::c_header));
-        Internal::CodeGen_C cg(file,
-                               target(),
-                               target().has_feature(Target::CPlusPlusMangling) ? Internal::CodeGen_C::CPlusPlusHeader : Internal::CodeGen_C::CHeader,
-                               output_files.at(Output::c_header));
-        cg.compile(*this);
+        jobs.emplace_back([&]() {
+            debug(1) << "Module.compile(): c_header " << output_files.at(Output::c_header) << "\n";
+            std::ofstream file(output_files.at(Output::c_header));
+            Internal::CodeGen_C cg(file,
+                                   target(),
+                                   target().has_feature(Target::CPlusPlusMangling) ? Internal::CodeGen_C::CPlusPlusHeader : Internal::CodeGen_C::CHeader,
+                                   output_files.at(Output::c_header));
+            cg.compile(*this);
+        });
     }
     if (contains(output_files, Output::c_source)) {
-        debug(1) << "Module.compile(): c_source " << output_files.at(Output::c_source) << "\n";
-        std::ofstream file(output_files.at(Output::c_source));
-        Internal::CodeGen_C cg(file,
-                               target(),
-                               target().has_feature(Target::CPlusPlusMangling) ? Internal::CodeGen_C::CPlusPlusImplementation : Internal::CodeGen_C::CImplementation);
-        cg.compile(*this);
+        jobs.emplace_back([&]() {
+            debug(1) << "Module.compile(): c_source " << output_files.at(Output::c_source) << "\n";
+            std::ofstream file(output_files.at(Output::c_source));
+            Internal::CodeGen_C cg(file,
+                                   target(),
+                                   target().has_feature(Target::CPlusPlusMangling) ? Internal::CodeGen_C::CPlusPlusImplementation : Internal::CodeGen_C::CImplementation);
+            cg.compile(*this);
+        });
     }
     if (contains(output_files, Output::python_extension)) {
-        debug(1) << "Module.compile(): python_extension " << output_files.at(Output::python_extension) << "\n";
-        std::ofstream file(output_files.at(Output::python_extension));
-        Internal::PythonExtensionGen python_extension_gen(file);
-        python_extension_gen.compile(*this);
+        jobs.emplace_back([&]() {
+            debug(1) << "Module.compile(): python_extension " << output_files.at(Output::python_extension) << "\n";
+            std::ofstream file(output_files.at(Output::python_extension));
+            Internal::PythonExtensionGen python_extension_gen(file);
+            python_extension_gen.compile(*this);
+        });
+    }
+    run_compile_jobs(jobs.size(), [&](size_t i) { jobs[i](); });
+
+    if (contains(output_files, Output::static_library) && partitions > 1) {
+        TemporaryObjectFileDir temp_dir;
+        std::vector<std::string> objects;
+        for (int i = 0; i < partitions; i++) {
+            objects.push_back(temp_dir.add_temp_object_file(output_files.at(Output::static_library), "_" + std::to_string(i), target()));
+        }
+        debug(1) << "Module.compile(): " << partitions << " temporary objects " << objects.front() << "...\n";
+        compile_llvm_module_to_objects(*llvm_module, objects);
+        if (logger && !contains(output_files, Output::object)) {
+            uint64_t size = 0;
+            for (const auto &object : objects) {
+                size += file_stat(object).file_size;
+            }
+            logger->record_object_code_size(size);
+        }
+        debug(1) << "Module.compile(): static_library " << output_files.at(Output::static_library) << "\n";
+        Target base_target(target().os, target().arch, target().bits);
+        create_static_library(temp_dir.files(), base_target, output_files.at(Output::static_library));
     }
+
     if (contains(output_files, Output::schedule)) {
         debug(1) << "Module.compile(): schedule " << output_files.at(Output::schedule) << "\n";
         std::ofstream file(output_files.at(Output::schedule));
@@ -825,6 +864,13 @@ void compile_multitarget(const std::string &fn_name,
     uint64_t runtime_features[kFeaturesWordCount] = {(uint64_t)-1LL};
 
     TemporaryObjectFileDir temp_obj_dir, temp_compiler_log_dir;
+    // Compiling the sub-modules, the runtime, and the wrapper are
+    // independent of each other, so they are collected here and run
+    // concurrently once all the sub-modules have been lowered. The
+    // active CompilerLogger is global, so the sub-modules are instead
+    // compiled one at a time while their own logger is active if there
+    // is one.
+    std::vector<std::function<void()>> compile_jobs;
     std::vector<Expr> wrapper_args;
     std::vector<LoweredArgument> base_target_args;
     std::vector<AutoSchedulerResults> auto_scheduler_results;
@@ -886,8 +932,15 @@ void compile_multitarget(const std::string &fn_name,
             if (contains(sub_out, Output::compiler_log)) {
                 sub_out[Output::compiler_log] = temp_compiler_log_dir.add_temp_file(output_files.at(Output::compiler_log), suffix, target);
             }
-            debug(1) << "compile_multitarget: compile_sub_target " << sub_out[Output::object] << "\n";
-            sub_module.compile(sub_out);
+            if (compiler_logger_factory) {
+                debug(1) << "compile_multitarget: compile_sub_target " << sub_out[Output::object] << "\n";
+                sub_module.compile(sub_out);
+            } else {
+                compile_jobs.emplace_back([=]() {
+                    debug(1) << "compile_multitarget: compile_sub_target " << sub_out.at(Output::object) << "\n";
+                    sub_module.compile(sub_out);
+                });
+            }
             const auto *r = sub_module.get_auto_scheduler_results();
             auto_scheduler_results.push_back(r ? *r : AutoSchedulerResults());
         }
@@ -942,8 +995,10 @@ void compile_multitarget(const std::string &fn_name,
 
         std::map<Output, std::string> runtime_out =
             {{Output::object, runtime_path}};
-        debug(1) << "compile_multitarget: compile_standalone_runtime " << runtime_out.at(Output::object) << "\n";
-        compile_standalone_runtime(runtime_out, runtime_target);
+        compile_jobs.emplace_back([=]() {
+            debug(1) << "compile_multitarget: compile_standalone_runtime " << runtime_out.at(Output::object) << "\n";
+            compile_standalone_runtime(runtime_out, runtime_target);
+        });
     }
 
     if (needs_wrapper) {
@@ -978,10 +1033,14 @@ void compile_multitarget(const std::string &fn_name,
                                        add_suffix(output_files.at(Output::object), "_wrapper");
 
         std::map<Output, std::string> wrapper_out = {{Output::object, wrapper_path}};
-        debug(1) << "compile_multitarget: wrapper " << wrapper_out.at(Output::object) << "\n";
-        wrapper_module.compile(wrapper_out);
+        compile_jobs.emplace_back([=]() {
+            debug(1) << "compile_multitarget: wrapper " << wrapper_out.at(Output::object) << "\n";
+            wrapper_module.compile(wrapper_out);
+        });
     }
 
+    run_compile_jobs(compile_jobs.size(), [&](size_t i) { compile_jobs[i](); });
+
     if (contains(output_files, Output::c_header)) {
         Module header_module(fn_name, base_target);
         header_module.append(LoweredFunc(fn_name, base_target_args, {}, LinkageType::ExternalPlusMetadata));
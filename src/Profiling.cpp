@@ -320,7 +320,7 @@ private:
 
 }  // namespace
 
-Stmt inject_profiling(Stmt s, const string &pipeline_name) {
+Stmt inject_profiling(Stmt s, const string &pipeline_name, bool hardware_counters) {
     InjectProfiling profiling(pipeline_name);
     s = profiling.mutate(s);
 
@@ -367,6 +367,14 @@ Stmt inject_profiling(Stmt s, const string &pipeline_name) {
     s = Block::make(AssertStmt::make(profiler_token >= 0, profiler_token), s);
     s = LetStmt::make("profiler_token", start_profiler, s);
 
+    if (hardware_counters) {
+        // Ask for hardware counters before the profiler starts. If they
+        // are unavailable the profiler carries on without them, so the
+        // result is ignored.
+        Expr enable_counters = Call::make(Int(32), "halide_profiler_enable_hardware_counters", {}, Call::Extern);
+        s = Block::make(Evaluate::make(enable_counters), s);
+    }
+
     if (!no_stack_alloc) {
         for (int i = num_funcs - 1; i >= 0; --i) {
             s = Block::make(Store::make("profiling_func_stack_peak_buf",
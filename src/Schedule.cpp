@@ -213,7 +213,7 @@ typedef std::map<FunctionPtr, FunctionPtr> DeepCopyMap;
 struct FuncScheduleContents {
     mutable RefCount ref_count;
 
-    LoopLevel store_level, compute_level;
+    LoopLevel store_level, compute_level, hoist_storage_level;
     std::vector<StorageDim> storage_dims;
     std::vector<Bound> bounds;
     std::vector<Bound> estimates;
@@ -224,7 +224,8 @@ struct FuncScheduleContents {
     Expr memoize_eviction_key;
 
     FuncScheduleContents()
-        : store_level(LoopLevel::inlined()), compute_level(LoopLevel::inlined()) {
+        : store_level(LoopLevel::inlined()), compute_level(LoopLevel::inlined()),
+          hoist_storage_level(LoopLevel::inlined()) {
     }
 
     // Pass an IRMutator through to all Exprs referenced in the FuncScheduleContents
@@ -334,6 +335,7 @@ FuncSchedule FuncSchedule::deep_copy(
     FuncSchedule copy;
     copy.contents->store_level = contents->store_level;
     copy.contents->compute_level = contents->compute_level;
+    copy.contents->hoist_storage_level = contents->hoist_storage_level;
     copy.contents->storage_dims = contents->storage_dims;
     copy.contents->bounds = contents->bounds;
     copy.contents->estimates = contents->estimates;
@@ -437,6 +439,10 @@ LoopLevel &FuncSchedule::compute_level() {
     return contents->compute_level;
 }
 
+LoopLevel &FuncSchedule::hoist_storage_level() {
+    return contents->hoist_storage_level;
+}
+
 const LoopLevel &FuncSchedule::store_level() const {
     return contents->store_level;
 }
@@ -445,6 +451,10 @@ const LoopLevel &FuncSchedule::compute_level() const {
     return contents->compute_level;
 }
 
+const LoopLevel &FuncSchedule::hoist_storage_level() const {
+    return contents->hoist_storage_level;
+}
+
 void FuncSchedule::accept(IRVisitor *visitor) const {
     for (const Bound &b : bounds()) {
         if (b.min.defined()) {
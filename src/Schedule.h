@@ -605,6 +605,17 @@ public:
     LoopLevel &compute_level();
     // @}
 
+    /** At what site should we inject the allocation of this function,
+     * if it is outside the store_level? The allocation is made large
+     * enough for every realization of the function within it, and
+     * reused by all of them. If the hoist_storage_level is inlined,
+     * the allocation is at the store_level. See \ref
+     * Func::hoist_storage */
+    // @{
+    const LoopLevel &hoist_storage_level() const;
+    LoopLevel &hoist_storage_level();
+    // @}
+
     /** Pass an IRVisitor through to all Exprs referenced in the
      * Schedule. */
     void accept(IRVisitor *) const;
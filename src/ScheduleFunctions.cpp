@@ -2053,11 +2053,12 @@ bool validate_schedule(Function f, const Stmt &s, const Target &target, bool is_
 
     LoopLevel store_at = f.schedule().store_level();
     LoopLevel compute_at = f.schedule().compute_level();
+    LoopLevel hoist_storage_at = f.schedule().hoist_storage_level();
 
     // Outputs must be compute_root and store_root. They're really
     // store_in_user_code, but store_root is close enough.
     if (is_output) {
-        if (store_at.is_root() && compute_at.is_root()) {
+        if (store_at.is_root() && compute_at.is_root() && hoist_storage_at.is_root()) {
             return true;
         } else {
             user_error << "Func " << f.name() << " is an output, so must"
@@ -2080,6 +2081,9 @@ bool validate_schedule(Function f, const Stmt &s, const Target &target, bool is_
     // will get lowered into compute_at innermost and thus can be treated
     // similarly as a non-inlined Func.
     if (store_at.is_inlined() && compute_at.is_inlined()) {
+        user_assert(hoist_storage_at.is_inlined())
+            << "Func \"" << f.name() << "\" is computed inline, so its storage can't be hoisted to "
+            << hoist_storage_at.to_string() << ".\n";
         if (f.is_pure()) {
             validate_schedule_inlined_function(f);
         }
@@ -2129,6 +2133,40 @@ bool validate_schedule(Function f, const Stmt &s, const Target &target, bool is_
         user_error << err.str();
     }
 
+    // The storage can be hoisted to any site at or outside the store_at
+    // site, as long as there isn't a parallel loop in between.
+    if (!(hoist_storage_at == store_at)) {
+        bool hoist_storage_at_ok = false;
+        size_t hoist_storage_idx = 0;
+        for (size_t i = 0; i <= store_idx; i++) {
+            if (sites[i].loop_level.match(hoist_storage_at)) {
+                hoist_storage_at_ok = true;
+                hoist_storage_idx = i;
+            }
+        }
+        if (hoist_storage_at_ok) {
+            for (size_t i = hoist_storage_idx + 1; i <= store_idx; i++) {
+                if (sites[i].is_parallel) {
+                    err << "Func \"" << f.name()
+                        << "\" has its storage hoisted outside the parallel loop over "
+                        << sites[i].loop_level.to_string()
+                        << " but is stored within it. This is a potential race condition.\n";
+                    hoist_storage_at_ok = false;
+                }
+            }
+        }
+        if (!hoist_storage_at_ok) {
+            err << "Func \"" << f.name() << "\" has its storage hoisted to the invalid location "
+                << hoist_storage_at.to_string() << ".\n"
+                << "It is stored at " << store_at.to_string()
+                << ", so the legal locations to hoist its storage to are:\n";
+            for (size_t i = 0; i <= store_idx; i++) {
+                err << "  " << sites[i].loop_level.to_string() << "\n";
+            }
+            user_error << err.str();
+        }
+    }
+
     return true;
 }
 
@@ -383,6 +383,7 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"llvm_large_code_model", Target::LLVMLargeCodeModel},
     {"rvv", Target::RVV},
     {"armv81a", Target::ARMv81a},
+    {"profile_counters", Target::ProfileCounters},
     // NOTE: When adding features to this map, be sure to update PyEnums.cpp as well.
 };
 
@@ -129,6 +129,7 @@ struct Target {
         LLVMLargeCodeModel = halide_llvm_large_code_model,
         RVV = halide_target_feature_rvv,
         ARMv81a = halide_target_feature_armv81a,
+        ProfileCounters = halide_target_feature_profile_counters,
         FeatureEnd = halide_target_feature_end
     };
     Target() = default;
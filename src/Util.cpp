@@ -2,14 +2,17 @@
 #include "Debug.h"
 #include "Error.h"
 #include "Introspection.h"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <map>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #ifdef _MSC_VER
 #include <io.h>
@@ -31,8 +34,11 @@
 #include <Objbase.h>  // needed for CoCreateGuid
 #include <Shlobj.h>   // needed for SHGetFolderPath
 #include <windows.h>
+// Must come after windows.h
+#include <psapi.h>  // needed for GetProcessMemoryInfo
 #else
 #include <dlfcn.h>
+#include <sys/resource.h>
 #endif
 #ifdef __APPLE__
 #define CAN_GET_RUNNING_PROGRAM_NAME
@@ -146,10 +152,20 @@ const int num_unique_name_counters = (1 << 14);
 // this is a global, which is always zero-initialized.
 std::atomic<int> unique_name_counters[num_unique_name_counters] = {};
 
+// While a compile job is running on a thread (see run_compile_jobs),
+// names generated on that thread are counted here instead, starting
+// from a copy of the global counters.
+thread_local std::vector<int> *job_unique_name_counters = nullptr;
+
 int unique_count(size_t h) {
     h = h & (num_unique_name_counters - 1);
+    if (job_unique_name_counters) {
+        return (*job_unique_name_counters)[h]++;
+    }
     return unique_name_counters[h]++;
 }
+
+std::atomic<int> compile_thread_count{0};
 }  // namespace
 
 // There are three possible families of names returned by the methods below:
@@ -353,6 +369,28 @@ FileStat file_stat(const std::string &name) {
             static_cast<uint32_t>(a.st_mode)};
 }
 
+uint64_t get_peak_memory_usage() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    // In bytes on macOS...
+    return usage.ru_maxrss;
+#else
+    // ...but in kilobytes elsewhere.
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
 #ifdef _WIN32
 namespace {
 
@@ -654,6 +692,100 @@ void run_with_large_stack(const std::function<void()> &action) {
     action();
 }
 
+int get_compile_thread_count() {
+    int n = compile_thread_count;
+    if (n == 0) {
+        std::string env = get_env_variable("HL_COMPILE_THREADS");
+        n = env.empty() ? 1 : std::atoi(env.c_str());
+        if (n <= 0) {
+            n = (int)std::max(1u, std::thread::hardware_concurrency());
+        }
+        compile_thread_count = n;
+    }
+    return n;
+}
+
+void set_compile_thread_count(int n) {
+    if (n <= 0) {
+        n = (int)std::max(1u, std::thread::hardware_concurrency());
+    }
+    compile_thread_count = n;
+}
+
+void run_compile_jobs(size_t n, const std::function<void(size_t)> &job) {
+    if (job_unique_name_counters) {
+        // Nested jobs run serially, sharing the counters of the
+        // enclosing job.
+        for (size_t i = 0; i < n; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    std::vector<int> initial_counters(num_unique_name_counters);
+    for (int h = 0; h < num_unique_name_counters; h++) {
+        initial_counters[h] = unique_name_counters[h];
+    }
+    std::vector<std::vector<int>> counters(n, initial_counters);
+
+#ifdef HALIDE_WITH_EXCEPTIONS
+    std::vector<std::exception_ptr> exceptions(n);
+#endif
+    auto run_job = [&](size_t i) {
+        job_unique_name_counters = &counters[i];
+#ifdef HALIDE_WITH_EXCEPTIONS
+        try {
+            run_with_large_stack([&]() { job(i); });
+        } catch (...) {
+            exceptions[i] = std::current_exception();
+        }
+#else
+        run_with_large_stack([&]() { job(i); });
+#endif
+        job_unique_name_counters = nullptr;
+    };
+
+    size_t num_threads = std::min((size_t)get_compile_thread_count(), n);
+    if (num_threads <= 1) {
+        for (size_t i = 0; i < n; i++) {
+            run_job(i);
+        }
+    } else {
+        debug(1) << "Running " << n << " compile jobs on " << num_threads << " threads\n";
+        std::atomic<size_t> next_job{0};
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; t++) {
+            threads.emplace_back([&]() {
+                for (size_t i = next_job++; i < n; i = next_job++) {
+                    run_job(i);
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+    }
+
+    // Names generated after the jobs must not collide with any name a
+    // job generated, so advance the global counters past all of them.
+    for (const auto &c : counters) {
+        for (int h = 0; h < num_unique_name_counters; h++) {
+            int old_count = unique_name_counters[h];
+            while (old_count < c[h] &&
+                   !unique_name_counters[h].compare_exchange_weak(old_count, c[h])) {
+            }
+        }
+    }
+
+#ifdef HALIDE_WITH_EXCEPTIONS
+    for (const auto &e : exceptions) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+#endif
+}
+
 }  // namespace Internal
 
 void load_plugin(const std::string &lib_name) {
@@ -264,6 +264,10 @@ void dir_rmdir(const std::string &name);
 /** Wrapper for stat(). Asserts upon error. */
 FileStat file_stat(const std::string &name);
 
+/** Return the peak resident memory usage of this process so far, in
+ * bytes, or zero if it cannot be determined on this platform. */
+uint64_t get_peak_memory_usage();
+
 /** Read the entire contents of a file into a vector<char>. The file
  * is read in binary mode. Errors trigger an assertion failure. */
 std::vector<char> read_entire_file(const std::string &pathname);
@@ -470,6 +474,31 @@ int get_llvm_version();
  * a Fiber. */
 void run_with_large_stack(const std::function<void()> &action);
 
+/** Get or set the number of threads the compiler may use to run
+ * independent compile jobs (see run_compile_jobs). Defaults to the
+ * value of the HL_COMPILE_THREADS environment variable, or 1 if it is
+ * unset. Zero or a negative value, set either way, means one thread per
+ * core. The output of the compiler does not depend on this setting,
+ * except that the Adams2019 autoscheduler searches differently with one
+ * thread than with several, and so may pick a different schedule. */
+// @{
+int get_compile_thread_count();
+void set_compile_thread_count(int n);
+// @}
+
+/** Call job(0) through job(n - 1) using up to get_compile_thread_count()
+ * threads, and return once they have all finished. The jobs must not
+ * depend on each other. Each job draws unique_name suffixes from its
+ * own copy of the name counters, taken before any of the jobs start, so
+ * the names a job generates are the same no matter how many threads
+ * there are or how the jobs are scheduled. Names generated by different
+ * jobs may therefore coincide, so each job should produce a separate
+ * compilation unit. Afterwards, the counters are advanced past the ones
+ * used by every job. Jobs started from within a job run serially. If any
+ * job throws, the exception from the first such job is rethrown after
+ * all of them have finished. */
+void run_compile_jobs(size_t n, const std::function<void(size_t)> &job);
+
 }  // namespace Internal
 }  // namespace Halide
 
@@ -0,0 +1,162 @@
+#include "Arena.h"
+#include "Errors.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace Halide {
+namespace Internal {
+namespace Autoscheduler {
+
+namespace {
+
+size_t round_up(size_t x, size_t m) {
+    return (x + m - 1) / m * m;
+}
+
+// Every allocation is preceded by a pointer to its Block, padded to
+// keep the allocation aligned.
+const size_t allocation_header_size = 16;
+
+}  // namespace
+
+struct Arena::Block {
+    Arena *arena = nullptr;
+
+    // The number of live allocations from this block, plus one while
+    // a thread is still allocating from it.
+    std::atomic<int64_t> live{0};
+
+    size_t capacity = 0, used = 0;
+
+    static size_t header_size() {
+        return round_up(sizeof(Block), 16);
+    }
+
+    char *data() {
+        return (char *)this + header_size();
+    }
+
+    void *claim(size_t bytes) {
+        char *p = data() + used;
+        used += bytes;
+        *(Block **)p = this;
+        return p + allocation_header_size;
+    }
+
+    void release_one() {
+        if (live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            arena->recycle(this);
+        }
+    }
+};
+
+namespace {
+
+// The block the current thread is allocating from.
+struct CurrentBlock {
+    Arena::Block *block = nullptr;
+
+    ~CurrentBlock() {
+        if (block) {
+            block->release_one();
+        }
+    }
+};
+
+thread_local CurrentBlock current_block;
+
+}  // namespace
+
+Arena::Arena(size_t block_size)
+    : block_size(block_size) {
+}
+
+Arena::~Arena() {
+    trim();
+}
+
+Arena::Block *Arena::make_block(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Block *b;
+    if (capacity == block_size && !spare_blocks.empty()) {
+        b = spare_blocks.back();
+        spare_blocks.pop_back();
+    } else {
+        const size_t bytes = Block::header_size() + capacity;
+        void *mem = malloc(bytes);
+        internal_assert(mem) << "Out of memory allocating " << bytes << " bytes for the autoscheduler\n";
+        b = new (mem) Block;
+        b->arena = this;
+        b->capacity = capacity;
+        reserved += bytes;
+        if (reserved > peak_reserved) {
+            peak_reserved.store(reserved);
+        }
+    }
+    b->used = 0;
+    b->live = 1;
+    return b;
+}
+
+void Arena::free_block(Block *b) {
+    reserved -= Block::header_size() + b->capacity;
+    b->~Block();
+    free(b);
+}
+
+void Arena::recycle(Block *b) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (b->capacity == block_size) {
+        spare_blocks.push_back(b);
+    } else {
+        free_block(b);
+    }
+}
+
+void *Arena::allocate(size_t bytes) {
+    bytes = round_up(bytes + allocation_header_size, 16);
+
+    if (bytes > block_size / 4) {
+        // Big allocations get a block of their own, which is freed along
+        // with the allocation.
+        return make_block(bytes)->claim(bytes);
+    }
+
+    Block *&b = current_block.block;
+    if (b && (b->arena != this || b->used + bytes > b->capacity)) {
+        b->release_one();
+        b = nullptr;
+    }
+    if (!b) {
+        b = make_block(block_size);
+    }
+    b->live.fetch_add(1, std::memory_order_relaxed);
+    return b->claim(bytes);
+}
+
+void Arena::release(void *p) {
+    if (p) {
+        Block *b = *(Block **)((char *)p - allocation_header_size);
+        b->release_one();
+    }
+}
+
+void Arena::trim() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Block *b : spare_blocks) {
+        free_block(b);
+    }
+    spare_blocks.clear();
+}
+
+Arena &search_arena() {
+    // Never destroyed, as blocks may still be released by other
+    // threads as they exit.
+    static Arena *arena = new Arena;
+    return *arena;
+}
+
+}  // namespace Autoscheduler
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,124 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace Halide {
+namespace Internal {
+namespace Autoscheduler {
+
+/*
+  Beam search creates and discards huge numbers of LoopNests and States,
+  and of the PerfectHashMaps inside them. Rather than going through the
+  general-purpose allocator for each one, we bump-allocate them from
+  large blocks of memory, so that the objects making up a candidate
+  schedule end up close together, and freeing one is just a decrement
+  of its block's count of live objects.
+
+  Each thread allocates from a block of its own. Once a thread has moved
+  on from a block and everything allocated from it has been freed, the
+  block is set aside to be reused. The blocks set aside are returned to
+  the system in bulk by trim(), which the autoscheduler calls at the end
+  of each pass of beam search. Objects that outlive a pass, such as the
+  best State found so far, just keep their block alive.
+
+  Memory is only reclaimed a whole block at a time, so one live object
+  keeps its entire block reserved. The cost of this is bounded by the
+  block size times the number of blocks holding survivors, which is at
+  most the number of objects that outlive a pass. Those are the States
+  on the path to the best one and the memoized tilings, so in practice
+  this is a small number of blocks, but a pass that keeps one object out
+  of every block alive would hold on to all of them. Run with
+  HL_DEBUG_AUTOSCHEDULE=1 to see the memory held after each pass, and
+  the peak.
+
+  Allocating and releasing memory is thread-safe, and memory may be
+  released on a different thread to the one that allocated it.
+*/
+class Arena {
+public:
+    struct Block;
+
+    explicit Arena(size_t block_size = 256 * 1024);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Allocate memory aligned to 16 bytes.
+    void *allocate(size_t bytes);
+
+    // Release memory allocated by any Arena.
+    static void release(void *p);
+
+    // Return the blocks no longer in use to the system.
+    void trim();
+
+    // The memory held by this Arena, and the most it has held at once.
+    size_t bytes_reserved() const {
+        return reserved;
+    }
+    size_t peak_bytes_reserved() const {
+        return peak_reserved;
+    }
+    void reset_peak_bytes_reserved() {
+        peak_reserved.store(reserved);
+    }
+
+private:
+    Block *make_block(size_t capacity);
+    void free_block(Block *b);
+    void recycle(Block *b);
+
+    const size_t block_size;
+
+    // Guards the spare blocks
+    std::mutex mutex;
+    std::vector<Block *> spare_blocks;
+
+    std::atomic<size_t> reserved{0}, peak_reserved{0};
+};
+
+// The Arena used for everything allocated during beam search.
+Arena &search_arena();
+
+// A std allocator that allocates from the search arena, for the
+// containers in LoopNests and States.
+template<typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    static_assert(alignof(T) <= 16, "ArenaAllocator only provides 16-byte alignment");
+
+    ArenaAllocator() = default;
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> &) {
+    }
+
+    T *allocate(size_t n) {
+        return (T *)search_arena().allocate(n * sizeof(T));
+    }
+
+    void deallocate(T *p, size_t) {
+        Arena::release(p);
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U> &) const {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U> &) const {
+        return false;
+    }
+};
+
+}  // namespace Autoscheduler
+}  // namespace Internal
+}  // namespace Halide
+
+#endif  // ARENA_H
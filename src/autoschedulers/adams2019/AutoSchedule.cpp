@@ -69,6 +69,15 @@
   If set, then tiling sizes are not cached across passes.
   (see Cache.h for more information)
 
+  HL_SCHEDULE_CACHE_DIR
+  If set, schedules are cached in this directory across runs, keyed by the pipeline, its estimates, the target, the machine params, the cost model weights and the search settings. On a hit, the cached schedule is applied without searching. If only the estimates, machine params, weights or search settings changed, the search is warm-started from the cached schedule instead. (see ScheduleCache.h for more information)
+
+  HL_COMPILE_THREADS
+  The number of threads used to expand the states in the beam, shared with the rest of the compiler. Defaults to 1. Set it to 0 to use one thread per core. With more than one thread, the expansions in each step of the search see the caches from before that step, so the schedule found is the same for any thread count above one, but may differ from the single-threaded one.
+
+  HL_COST_MODEL_BATCH_SIZE
+  The most states evaluated together by one call to the cost model. Defaults to 1024. Larger batches amortize the cost of each call, and give it more parallelism.
+
   TODO: expose these settings by adding some means to pass args to
   generator plugins instead of environment vars.
 */
@@ -86,6 +95,7 @@
 #include <unordered_set>
 
 #include "ASLog.h"
+#include "Arena.h"
 #include "AutoSchedule.h"
 #include "Cache.h"
 #include "CostModel.h"
@@ -97,6 +107,7 @@
 #include "LoopNest.h"
 #include "NetworkSize.h"
 #include "PerfectHashMap.h"
+#include "ScheduleCache.h"
 #include "State.h"
 #include "Timer.h"
 
@@ -169,7 +180,9 @@ uint32_t get_dropout_threshold() {
 // randomly exploring the search tree for autotuning and to generate
 // training data.
 bool random_dropout(std::mt19937 &rng, size_t num_decisions) {
-    static double random_dropout_threshold = get_dropout_threshold();
+    // Not cached, as a process may autoschedule several times with
+    // different settings (see autotune.cpp).
+    double random_dropout_threshold = get_dropout_threshold();
     if (random_dropout_threshold >= 100) {
         return false;
     }
@@ -251,6 +264,43 @@ public:
     }
 };
 
+// A cost model that holds on to the schedules enqueued while expanding
+// a single beam state, so that they can be passed on to the real cost
+// model in a fixed order once all the states being expanded in
+// parallel are done. That keeps the batches the real cost model
+// evaluates, and hence the costs, independent of thread scheduling.
+class DeferredCostModel : public CostModel {
+    std::vector<std::pair<StageMapOfScheduleFeatures, double *>> queue;
+
+public:
+    void set_pipeline_features(const FunctionDAG &dag,
+                               const MachineParams &params) override {
+        internal_error << "DeferredCostModel does not take pipeline features\n";
+    }
+
+    void enqueue(const FunctionDAG &dag,
+                 const StageMapOfScheduleFeatures &schedule_feats,
+                 double *cost_ptr) override {
+        queue.emplace_back(schedule_feats, cost_ptr);
+    }
+
+    void evaluate_costs() override {
+        internal_error << "DeferredCostModel cannot evaluate costs\n";
+    }
+
+    void reset() override {
+        queue.clear();
+    }
+
+    // Enqueue everything held here into another cost model.
+    void flush(const FunctionDAG &dag, CostModel *cost_model) {
+        for (const auto &q : queue) {
+            cost_model->enqueue(dag, q.first, q.second);
+        }
+        queue.clear();
+    }
+};
+
 // Configure a cost model to process a specific pipeline.
 void configure_pipeline_features(const FunctionDAG &dag,
                                  const MachineParams &params,
@@ -341,8 +391,10 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
             aslog(0) << "Warning: Huge number of states generated (" << pending.size() << ").\n";
         }
 
-        expanded = 0;
-        while (expanded < beam_size && !pending.empty()) {
+        // Pick the states to expand. This is cheap, and depends on the
+        // rng, so it's done serially.
+        vector<IntrusivePtr<State>> to_expand;
+        while ((int)to_expand.size() < beam_size && !pending.empty()) {
 
             IntrusivePtr<State> state{pending.pop()};
 
@@ -419,13 +471,49 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                 return best;
             }
 
-            state->generate_children(dag, params, cost_model, memory_limit, enqueue_new_children, cache);
-            expanded++;
+            to_expand.emplace_back(std::move(state));
         }
 
         // Drop the other states unconsidered.
         pending.clear();
 
+        // Generate and featurize the children of those states in
+        // parallel. Each expansion sees the caches as they were before
+        // any of them started, and holds on to its children, cache
+        // writes, and cost model queries, so that they can be applied
+        // below in the same order no matter how many threads there are.
+        // With a single thread, the states are instead expanded one
+        // after the other, each seeing the cache writes of the ones
+        // before it, exactly as the serial search always has.
+        const size_t num_to_expand = to_expand.size();
+        if (get_compile_thread_count() == 1) {
+            for (expanded = 0; expanded < (int)num_to_expand; expanded++) {
+                to_expand[expanded]->generate_children(dag, params, cost_model, memory_limit, enqueue_new_children, cache);
+            }
+        } else {
+            vector<vector<IntrusivePtr<State>>> children(num_to_expand);
+            vector<CacheWrites> cache_writes(num_to_expand);
+            vector<DeferredCostModel> deferred_cost_models(num_to_expand);
+            run_compile_jobs(num_to_expand, [&](size_t j) {
+                ScopedCacheWrites scoped_cache_writes(&cache_writes[j]);
+                std::function<void(IntrusivePtr<State> &&)> accept_child =
+                    [&](IntrusivePtr<State> &&s) {
+                        children[j].emplace_back(std::move(s));
+                    };
+                to_expand[j]->generate_children(dag, params, &deferred_cost_models[j], memory_limit, accept_child, cache);
+            });
+
+            for (expanded = 0; expanded < (int)num_to_expand; expanded++) {
+                cache->commit(cache_writes[expanded]);
+                if (cost_model) {
+                    deferred_cost_models[expanded].flush(dag, cost_model);
+                }
+                for (auto &child : children[expanded]) {
+                    enqueue_new_children(std::move(child));
+                }
+            }
+        }
+
         if (cost_model) {
             // Now evaluate all the costs and re-sort them in the priority queue
             cost_model->evaluate_costs();
@@ -469,7 +557,8 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
                                      std::mt19937 &rng,
                                      int beam_size,
                                      int64_t memory_limit,
-                                     const CachingOptions &options) {
+                                     const CachingOptions &options,
+                                     const std::unordered_set<uint64_t> &warm_start_hashes = {}) {
 
     IntrusivePtr<State> best;
 
@@ -494,7 +583,16 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
         num_passes = std::atoi(num_passes_str.c_str());
     }
 
-    for (int i = 0; i < num_passes; i++) {
+    // If we are warm-starting from the decisions that led to a
+    // previously found schedule, treat them as if they had been
+    // blessed by the first few passes, and skip those passes.
+    int first_pass = 0;
+    if (!warm_start_hashes.empty()) {
+        first_pass = std::max(0, std::min(schedule_cache_warm_start_passes, num_passes - 1));
+        permitted_hashes = warm_start_hashes;
+    }
+
+    for (int i = first_pass; i < num_passes; i++) {
         ProgressBar tick;
 
         Timer timer;
@@ -515,11 +613,17 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
             pass->dump();
         }
 
-        if (i == 0 || pass->cost < best->cost) {
+        if (!best.defined() || pass->cost < best->cost) {
             // Track which pass produced the lowest-cost state. It's
             // not necessarily the final one.
             best = pass;
         }
+
+        // The rest of the states explored by the pass are dead
+        // now, so release the memory they used in bulk.
+        search_arena().trim();
+        aslog(1) << "Memory held for search objects after pass " << i << " (MB): "
+                 << search_arena().bytes_reserved() / (1024 * 1024) << "\n";
     }
 
     aslog(0) << "Best cost: " << best->cost << "\n";
@@ -533,7 +637,7 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
 }
 
 // Keep track of how many times we evaluated a state.
-int State::cost_calculations = 0;
+std::atomic<int> State::cost_calculations{0};
 
 // The main entrypoint to generate a schedule for a pipeline.
 void generate_schedule(const std::vector<Function> &outputs,
@@ -546,6 +650,7 @@ void generate_schedule(const std::vector<Function> &outputs,
     HALIDE_TIC;
 
     State::cost_calculations = 0;
+    search_arena().reset_peak_bytes_reserved();
 
     // Get the seed for random dropout
     string seed_str = get_env_variable("HL_SEED");
@@ -583,21 +688,70 @@ void generate_schedule(const std::vector<Function> &outputs,
     // Construct a cost model to use to evaluate states. Currently we
     // just have the one, but it's an abstract interface, so others
     // can be slotted in for experimentation.
-    std::unique_ptr<CostModel> cost_model = make_default_cost_model(weights_in_path, weights_out_path, randomize_weights);
-    internal_assert(cost_model != nullptr);
+    std::unique_ptr<DefaultCostModel> default_cost_model = make_default_cost_model(weights_in_path, weights_out_path, randomize_weights);
+    internal_assert(default_cost_model != nullptr);
+    string batch_size_str = get_env_variable("HL_COST_MODEL_BATCH_SIZE");
+    if (!batch_size_str.empty()) {
+        int batch_size = atoi(batch_size_str.c_str());
+        user_assert(batch_size > 0)
+            << "HL_COST_MODEL_BATCH_SIZE must be a positive integer, but is \"" << batch_size_str << "\"\n";
+        default_cost_model->set_batch_size(batch_size);
+    }
 
     IntrusivePtr<State> optimal;
 
     // Options generated from environment variables, decide whether or not to cache features and/or tilings.
     CachingOptions cache_options = CachingOptions::MakeOptionsFromEnviron();
 
-    // Run beam search
-    optimal = optimal_schedule(dag, outputs, params, cost_model.get(), rng, beam_size, memory_limit, cache_options);
+    // Look for a schedule found by an earlier run.
+    std::unique_ptr<ScheduleCache> schedule_cache;
+    std::unordered_set<uint64_t> warm_start_hashes;
+    string schedule_cache_dir = get_env_variable("HL_SCHEDULE_CACHE_DIR");
+    if (!schedule_cache_dir.empty() && get_env_variable("HL_CYOS") != "1") {
+        // Everything other than the pipeline and target that the
+        // search depends on.
+        std::ostringstream search_settings;
+        search_settings << "machine params: " << params.to_string() << "\n"
+                        << "beam size: " << beam_size << "\n"
+                        << "passes: " << get_env_variable("HL_NUM_PASSES") << "\n"
+                        << "memory limit: " << memory_limit << "\n"
+                        << "no subtiling: " << get_env_variable("HL_NO_SUBTILING") << "\n"
+                        << "caching: " << cache_options.cache_blocks << cache_options.cache_features << "\n"
+                        // A serial search sees the cache writes of each
+                        // expansion in the next one, and a parallel one
+                        // doesn't, so they can find different schedules.
+                        << "search: " << (get_compile_thread_count() == 1 ? "serial" : "parallel") << "\n";
+        if (get_dropout_threshold() < 100) {
+            search_settings << "dropout: " << get_dropout_threshold() << " seed: " << seed << "\n";
+        }
+        search_settings << "weights: ";
+        default_cost_model->get_weights().save(search_settings);
+
+        schedule_cache.reset(new ScheduleCache(schedule_cache_dir, dag, target, search_settings.str()));
+        optimal = schedule_cache->lookup(dag, &warm_start_hashes);
+    }
+
+    std::unique_ptr<CostModel> cost_model = std::move(default_cost_model);
+
+    if (!optimal.defined()) {
+        // Run beam search
+        optimal = optimal_schedule(dag, outputs, params, cost_model.get(), rng, beam_size, memory_limit, cache_options, warm_start_hashes);
+
+        if (schedule_cache) {
+            schedule_cache->store(*optimal);
+        }
+    } else {
+        // The cost model is still used below.
+        configure_pipeline_features(dag, params, cost_model.get());
+    }
 
     HALIDE_TOC;
 
     aslog(1) << "Cost evaluated this many times: " << State::cost_calculations << "\n";
 
+    aslog(0) << "Peak memory (MB): " << get_peak_memory_usage() / (1024 * 1024)
+             << ", of which search objects: " << search_arena().peak_bytes_reserved() / (1024 * 1024) << "\n";
+
     // Dump the schedule found
     aslog(1) << "** Optimal schedule:\n";
 
@@ -1,3 +1,4 @@
+#include "Arena.h"
 #include "CostModel.h"
 #include "Featurization.h"
 #include "FunctionDAG.h"
@@ -9,7 +10,9 @@ namespace Halide {
 namespace Internal {
 namespace Autoscheduler {
 
-typedef PerfectHashMap<FunctionDAG::Node::Stage, ScheduleFeatures> StageMapOfScheduleFeatures;
+typedef PerfectHashMap<FunctionDAG::Node::Stage, ScheduleFeatures, 4, PerfectHashMapAsserter,
+                       ArenaAllocator<std::pair<const FunctionDAG::Node::Stage *, ScheduleFeatures>>>
+    StageMapOfScheduleFeatures;
 
 void find_and_apply_schedule(FunctionDAG &dag, const std::vector<Function> &outputs, const MachineParams &params,
                              CostModel *cost_model, int beam_size, StageMapOfScheduleFeatures *schedule_features);
@@ -14,6 +14,23 @@ bool is_memoize_blocks_enabled() {
     return get_env_variable("HL_DISABLE_MEMOIZED_BLOCKS") != "1";
 }
 
+namespace {
+thread_local CacheWrites *cache_writes_on_this_thread = nullptr;
+}  // namespace
+
+CacheWrites *current_cache_writes() {
+    return cache_writes_on_this_thread;
+}
+
+ScopedCacheWrites::ScopedCacheWrites(CacheWrites *writes)
+    : old_writes(cache_writes_on_this_thread) {
+    cache_writes_on_this_thread = writes;
+}
+
+ScopedCacheWrites::~ScopedCacheWrites() {
+    cache_writes_on_this_thread = old_writes;
+}
+
 bool Cache::add_memoized_blocks(const State *state,
                                 std::function<void(IntrusivePtr<State> &&)> &accept_child,
                                 const FunctionDAG::Node *node, int &num_children,
@@ -98,7 +115,11 @@ void Cache::memoize_blocks(const FunctionDAG::Node *node, LoopNest *new_root) {
 
     internal_assert(loop_nest_found) << "memoize_blocks did not find loop nest!\n";
 
-    auto &blocks = memoized_compute_root_blocks.get_or_create(node)[vector_dim];
+    // If we're expanding a beam state, hold on to the tilings until
+    // the expansion is committed.
+    CacheWrites *writes = current_cache_writes();
+    BlockCache &block_cache = writes ? writes->blocks : memoized_compute_root_blocks;
+    auto &blocks = block_cache.get_or_create(node)[vector_dim];
 
     for (auto &child : new_root->children) {
         if (child->node == node) {
@@ -112,6 +133,28 @@ void Cache::memoize_blocks(const FunctionDAG::Node *node, LoopNest *new_root) {
     }
 }
 
+void Cache::commit(CacheWrites &writes) {
+    for (auto &it : writes.features) {
+        it.first.first->features_cache[it.first.second] = std::move(it.second);
+    }
+    for (auto &it : writes.feature_intermediates) {
+        it.first.first->feature_intermediates_cache[it.first.second] = std::move(it.second);
+    }
+
+    // Only the first expansion to generate tilings for a given Func
+    // and vector dimension gets to memoize them.
+    for (auto it = writes.blocks.begin(); it != writes.blocks.end(); it++) {
+        auto &vector_dim_map = memoized_compute_root_blocks.get_or_create(it.key());
+        for (auto &b : it.value()) {
+            if (vector_dim_map.count(b.first) == 0) {
+                vector_dim_map[b.first] = std::move(b.second);
+            }
+        }
+    }
+
+    writes = CacheWrites();
+}
+
 }  // namespace Autoscheduler
 }  // namespace Internal
 }  // namespace Halide
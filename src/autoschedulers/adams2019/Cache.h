@@ -9,6 +9,11 @@
 #include "LoopNest.h"
 #include "PerfectHashMap.h"
 
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
+
 namespace Halide {
 namespace Internal {
 namespace Autoscheduler {
@@ -64,6 +69,13 @@ namespace Autoscheduler {
     Cache::add_memoized_blocks below (and in Cache.cpp).
     Additionally, if a tiling has not been cached, and it is not pruned, then the tiling will be
     cached using Cache::memoize_blocks (see below and in Cache.cpp).
+
+  Beam search expands several states at once on different threads (see optimal_schedule_pass in
+  AutoSchedule.cpp). To keep the search deterministic however those expansions are scheduled, none
+  of them writes to either cache directly. Each one instead collects its writes in a CacheWrites
+  object (see below), and sees the caches as they were before any of the expansions started, plus
+  its own writes. Once they have all finished, Cache::commit applies the writes of each expansion
+  in the order the states were taken off the beam.
 */
 
 struct State;
@@ -94,6 +106,40 @@ struct CachingOptions {
 // Node -> (vector_dim -> vector<tiled LoopNest>)
 using BlockCache = NodeMap<std::map<int, std::vector<IntrusivePtr<const LoopNest>>>>;
 
+// The cache writes made while expanding a single beam state.
+struct CacheWrites {
+    using Key = std::pair<const LoopNest *, uint64_t>;
+
+    // (LoopNest, hash of producers) -> updated entry of LoopNest::features_cache
+    std::map<Key, StageMap<ScheduleFeatures>> features;
+
+    // (LoopNest, hash of producers) -> updated entry of LoopNest::feature_intermediates_cache
+    std::map<Key, StageMap<StageMap<FeatureIntermediates>>> feature_intermediates;
+
+    // Keeps the LoopNests above alive until the writes are committed.
+    std::vector<IntrusivePtr<const LoopNest>> loop_nests;
+
+    // Tilings to memoize.
+    BlockCache blocks;
+};
+
+// The CacheWrites collecting the cache writes made on this thread, or
+// nullptr if the caches are being written directly.
+CacheWrites *current_cache_writes();
+
+// Collect the cache writes made on this thread into the given
+// CacheWrites for the lifetime of this object.
+class ScopedCacheWrites {
+    CacheWrites *old_writes;
+
+public:
+    explicit ScopedCacheWrites(CacheWrites *writes);
+    ~ScopedCacheWrites();
+
+    ScopedCacheWrites(const ScopedCacheWrites &) = delete;
+    ScopedCacheWrites &operator=(const ScopedCacheWrites &) = delete;
+};
+
 // Cache for memoizing possible tilings.
 // Tracks hit/miss statistics for both block caching
 // and for feature caching (self-contained by LoopNests).
@@ -101,8 +147,8 @@ struct Cache {
     CachingOptions options;
     BlockCache memoized_compute_root_blocks;
 
-    mutable size_t cache_hits = 0;
-    mutable size_t cache_misses = 0;
+    mutable std::atomic<size_t> cache_hits{0};
+    mutable std::atomic<size_t> cache_misses{0};
 
     Cache() = delete;
     Cache(const CachingOptions &_options, size_t nodes_size)
@@ -128,6 +174,10 @@ struct Cache {
 
     // Generate tilings for a specific vector dimension and memoize them.
     void memoize_blocks(const FunctionDAG::Node *node, LoopNest *new_root);
+
+    // Apply the writes collected while expanding a beam state to the
+    // block cache and to the feature caches of the LoopNests written.
+    void commit(CacheWrites &writes);
 };
 
 }  // namespace Autoscheduler
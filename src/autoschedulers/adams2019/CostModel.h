@@ -3,6 +3,7 @@
 
 #include <string>
 
+#include "Arena.h"
 #include "FunctionDAG.h"
 #include "HalideBuffer.h"
 #include "PerfectHashMap.h"
@@ -12,7 +13,9 @@ namespace Halide {
 
 namespace Internal {
 namespace Autoscheduler {
-typedef PerfectHashMap<FunctionDAG::Node::Stage, ScheduleFeatures> StageMapOfScheduleFeatures;
+typedef PerfectHashMap<FunctionDAG::Node::Stage, ScheduleFeatures, 4, PerfectHashMapAsserter,
+                       ArenaAllocator<std::pair<const FunctionDAG::Node::Stage *, ScheduleFeatures>>>
+    StageMapOfScheduleFeatures;
 }  // namespace Autoscheduler
 }  // namespace Internal
 
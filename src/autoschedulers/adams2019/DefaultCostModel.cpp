@@ -142,13 +142,12 @@ void DefaultCostModel::enqueue(int ns, Runtime::Buffer<float> *schedule_feats, d
         << "schedule features has more stages (" << num_stages
         << ") than pipeline features (" << max_num_stages << ")\n";
 
-    const int batch_size = 1024;
     if (!schedule_feat_queue.data() ||
+        schedule_feat_queue.dim(0).extent() != batch_size ||
         schedule_feat_queue.dim(2).extent() < max_num_stages) {
         internal_assert(cursor == 0);
         schedule_feat_queue = Runtime::Buffer<float>(batch_size, head2_w, max_num_stages);
-        if (!costs.data()) {
-            internal_assert(!cost_ptrs.data());
+        if (!costs.data() || costs.dim(0).extent() != batch_size) {
             costs = Runtime::Buffer<float>(batch_size);
             cost_ptrs = Runtime::Buffer<double *>(batch_size);
         }
@@ -374,6 +373,12 @@ void DefaultCostModel::save_weights() {
     }
 }
 
+void DefaultCostModel::set_batch_size(int n) {
+    user_assert(n > 0) << "Cost model batch size must be positive, but is " << n << "\n";
+    internal_assert(cursor == 0) << "Can't change the cost model batch size with schedules enqueued\n";
+    batch_size = n;
+}
+
 // Discard any enqueued but unevaluated schedules
 void DefaultCostModel::reset() {
     cursor = 0;
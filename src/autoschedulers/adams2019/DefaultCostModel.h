@@ -12,7 +12,8 @@ private:
     Internal::Weights weights;
     Runtime::Buffer<float> schedule_feat_queue, pipeline_feat_queue, costs;
     Runtime::Buffer<double *> cost_ptrs;
-    int cursor, num_stages, num_cores;
+    int cursor = 0, num_stages = 0, num_cores = 0;
+    int batch_size = 1024;
 
     const std::string weights_in_path, weights_out_path;
     const bool randomize_weights;
@@ -47,6 +48,11 @@ public:
                  double *cost_ptr) override;
     void enqueue(int ns, Runtime::Buffer<float> *schedule_feats, double *cost_ptr);
 
+    // Set the most schedules evaluated together by one call to the
+    // cost model. Larger batches amortize the overhead of the call and
+    // give it more parallelism. Must be called while the queue is empty.
+    void set_batch_size(int n);
+
     // Evaluate all schedules in the queue.
     void evaluate_costs() override;
 
@@ -59,6 +65,10 @@ public:
     // Save/Load the model weights to/from disk.
     void save_weights();
     void load_weights();
+
+    const Internal::Weights &get_weights() const {
+        return weights;
+    }
 };
 
 std::unique_ptr<DefaultCostModel> make_default_cost_model(const std::string &weights_in_dir = "",
@@ -306,25 +306,8 @@ public:
 }  // namespace
 
 void LoadJacobian::dump(const char *prefix) const {
-    if (count() > 1) {
-        aslog(0) << prefix << count() << " x\n";
-    }
-    for (size_t i = 0; i < producer_storage_dims(); i++) {
-        aslog(0) << prefix << "  [";
-
-        for (size_t j = 0; j < consumer_loop_dims(); j++) {
-            const auto &c = (*this)(i, j);
-            if (!c.exists) {
-                aslog(0) << " _  ";
-            } else if (c.denominator == 1) {
-                aslog(0) << " " << c.numerator << "  ";
-            } else {
-                aslog(0) << c.numerator << "/" << c.denominator << " ";
-            }
-        }
-        aslog(0) << "]\n";
-    }
-    aslog(0) << "\n";
+    auto os = aslog(0);
+    dump(os, prefix);
 }
 
 void BoundContents::validate() const {
@@ -375,6 +358,7 @@ void BoundContents::Layout::allocate_some_more() const {
 }
 
 BoundContents *BoundContents::Layout::make() const {
+    std::lock_guard<std::mutex> lock(mutex);
     if (pool.empty()) {
         allocate_some_more();
     }
@@ -387,6 +371,7 @@ BoundContents *BoundContents::Layout::make() const {
 void BoundContents::Layout::release(const BoundContents *b) const {
     internal_assert(b->layout == this) << "Releasing BoundContents onto the wrong pool!";
     b->~BoundContents();
+    std::lock_guard<std::mutex> lock(mutex);
     pool.push_back(const_cast<BoundContents *>(b));
     num_live--;
 }
@@ -1058,7 +1043,7 @@ void FunctionDAG::dump_internal(OS &os) const {
 
         os << "  Load Jacobians:\n";
         for (const auto &jac : e.load_jacobians) {
-            jac.dump("  ");
+            jac.dump(os, "  ");
         }
     }
 }
@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -205,6 +206,29 @@ public:
         return result;
     }
 
+    template<typename OS>
+    void dump(OS &os, const char *prefix) const {
+        if (count() > 1) {
+            os << prefix << count() << " x\n";
+        }
+        for (size_t i = 0; i < producer_storage_dims(); i++) {
+            os << prefix << "  [";
+
+            for (size_t j = 0; j < consumer_loop_dims(); j++) {
+                const auto &c = (*this)(i, j);
+                if (!c.exists) {
+                    os << " _  ";
+                } else if (c.denominator == 1) {
+                    os << " " << c.numerator << "  ";
+                } else {
+                    os << c.numerator << "/" << c.denominator << " ";
+                }
+            }
+            os << "]\n";
+        }
+        os << "\n";
+    }
+
     void dump(const char *prefix) const;
 };
 
@@ -317,9 +341,13 @@ struct BoundContents {
     // We're frequently going to need to make these concrete bounds
     // arrays.  It makes things more efficient if we figure out the
     // memory layout of those data structures once ahead of time, and
-    // make each individual instance just use that. Note that this is
-    // not thread-safe.
+    // make each individual instance just use that. Making and releasing
+    // BoundContents objects is thread-safe, as beam search states are
+    // expanded on multiple threads at once.
     class Layout {
+        // Guards the pool below
+        mutable std::mutex mutex;
+
         // A memory pool of free BoundContent objects with this layout
         mutable std::vector<BoundContents *> pool;
 
@@ -27,6 +27,54 @@ bool may_subtile() {
     return b;
 }
 
+namespace {
+
+// Helpers for the feature cache accessors below. 'writes' holds the
+// updated cache entries of all LoopNests, keyed by (LoopNest, hash of
+// producers); see CacheWrites in Cache.h.
+
+template<typename T>
+const T *find_in_cache(const LoopNest *n, uint64_t hash,
+                       const std::map<uint64_t, T> &cache,
+                       const std::map<CacheWrites::Key, T> *writes) {
+    if (writes) {
+        auto it = writes->find({n, hash});
+        if (it != writes->end()) {
+            return &(it->second);
+        }
+    }
+    auto it = cache.find(hash);
+    return it == cache.end() ? nullptr : &(it->second);
+}
+
+template<typename T>
+T &get_cache_write(const LoopNest *n, uint64_t hash,
+                   const std::map<uint64_t, T> &cache,
+                   std::map<CacheWrites::Key, T> &writes,
+                   CacheWrites *all_writes) {
+    auto it = writes.find({n, hash});
+    if (it == writes.end()) {
+        // Start from a copy of the existing entry, if any.
+        auto existing = cache.find(hash);
+        it = writes.emplace(CacheWrites::Key{n, hash},
+                            existing == cache.end() ? T() : existing->second)
+                 .first;
+        all_writes->loop_nests.emplace_back(n);
+    }
+    return it->second;
+}
+
+template<typename T>
+void copy_cache_writes(const LoopNest *n,
+                       const std::map<CacheWrites::Key, T> &writes,
+                       std::map<uint64_t, T> &cache) {
+    for (auto it = writes.lower_bound({n, 0}); it != writes.end() && it->first.first == n; it++) {
+        cache[it->first.second] = it->second;
+    }
+}
+
+}  // namespace
+
 // Given a multi-dimensional box of dimensionality d, generate a list
 // of candidate tile sizes for it, logarithmically spacing the sizes
 // using the given factor. If 'allow_splits' is false, every dimension
@@ -127,7 +175,10 @@ void LoopNest::copy_from(const LoopNest &n) {
     children = n.children;
     inlined = n.inlined;
     store_at = n.store_at;
-    bounds = n.bounds;
+    {
+        std::lock_guard<std::mutex> lock(n.bounds_mutex);
+        bounds = n.bounds;
+    }
     node = n.node;
     stage = n.stage;
     innermost = n.innermost;
@@ -330,10 +381,8 @@ void LoopNest::compute_features(const FunctionDAG &dag,
 
             if (use_cached_features) {
                 // Checks if the features cache has seen this state before, and use the cached features if so.
-                if (c->features_cache.count(hash_of_producers) > 0) {
-                    const auto &entry = c->features_cache.at(hash_of_producers);
-
-                    for (auto it = entry.begin(); it != entry.end(); it++) {
+                if (const auto *entry = c->find_cached_features(hash_of_producers)) {
+                    for (auto it = entry->begin(); it != entry->end(); it++) {
                         const auto *stage_ptr = it.key();
                         const auto &feat = it.value();
 
@@ -355,8 +404,9 @@ void LoopNest::compute_features(const FunctionDAG &dag,
 
             if (use_cached_features) {
                 // Cache these features for future reference.
-                c->features_cache[hash_of_producers].make_large(dag.nodes[0].stages[0].max_id);
-                c->memoize_features(c->features_cache[hash_of_producers], features);
+                auto &cached = c->cached_features(hash_of_producers);
+                cached.make_large(dag.nodes[0].stages[0].max_id);
+                c->memoize_features(cached, features);
             }
         }
 
@@ -439,8 +489,8 @@ void LoopNest::compute_features(const FunctionDAG &dag,
                 // may not have been computed when it is accessed as a memoized
                 // feature. We memoize 'points_computed_minimum' here to ensure
                 // its value is always available
-                if (c->features_cache.count(hash_of_producers) > 0) {
-                    c->memoize_points_computed_minimum(c->features_cache[hash_of_producers], features);
+                if (c->find_cached_features(hash_of_producers)) {
+                    c->memoize_points_computed_minimum(c->cached_features(hash_of_producers), features);
                 }
             }
             recompute_inlined_features(sites, features);
@@ -1016,7 +1066,7 @@ void LoopNest::compute_features(const FunctionDAG &dag,
         if (use_cached_features) {
             const auto &block = sites.get(stage).task;
             uint64_t hash_of_producers = sites.get(block->stage).hash_of_producers_stored_at_root;
-            auto &intermediate_map = block->feature_intermediates_cache[hash_of_producers].get_or_create(&(f->stages[0]));
+            auto &intermediate_map = block->cached_feature_intermediates(hash_of_producers).get_or_create(&(f->stages[0]));
             auto &intermediate = intermediate_map.get_or_create(stage);
 
             intermediate.inlined_calls = it.value() * subinstances;
@@ -1030,14 +1080,18 @@ void LoopNest::compute_features(const FunctionDAG &dag,
 // Get the region required of a Func at this site, from which we
 // know what region would be computed if it were scheduled here,
 // and what its loop nest would be.
-const Bound &LoopNest::get_bounds(const FunctionDAG::Node *f) const {
-    if (bounds.contains(f)) {
-        const Bound &b = bounds.get(f);
-        // Expensive validation for debugging
-        // b->validate();
-        return b;
+Bound LoopNest::get_bounds(const FunctionDAG::Node *f) const {
+    {
+        std::lock_guard<std::mutex> lock(bounds_mutex);
+        if (bounds.contains(f)) {
+            const Bound &b = bounds.get(f);
+            // Expensive validation for debugging
+            // b->validate();
+            return b;
+        }
     }
     auto *bound = f->make_bound();
+    Bound result(bound);
 
     // Compute the region required
     if (f->is_output && is_root()) {
@@ -1087,10 +1141,16 @@ const Bound &LoopNest::get_bounds(const FunctionDAG::Node *f) const {
         f->loop_nest_for_region(i, &(bound->region_computed(0)), &(bound->loops(i, 0)));
     }
 
-    const Bound &b = set_bounds(f, bound);
     // Validation is expensive, turn if off by default.
-    // b->validate();
-    return b;
+    // result->validate();
+
+    // Another thread may have computed the same bounds while we were
+    // doing so. They're identical, so keep whichever got there first.
+    std::lock_guard<std::mutex> lock(bounds_mutex);
+    if (bounds.contains(f)) {
+        return bounds.get(f);
+    }
+    return bounds.emplace(f, std::move(result));
 }
 
 // Recursively print a loop nest representation to stderr
@@ -1381,7 +1441,10 @@ IntrusivePtr<const LoopNest> LoopNest::parallelize_in_tiles(const MachineParams
     inner->innermost = innermost;
     inner->children = children;
     inner->inlined = inlined;
-    inner->bounds = bounds;
+    {
+        std::lock_guard<std::mutex> lock(bounds_mutex);
+        inner->bounds = bounds;
+    }
     inner->store_at = store_at;
 
     auto *b = inner->get_bounds(node)->make_copy();
@@ -1551,7 +1614,10 @@ vector<IntrusivePtr<const LoopNest>> LoopNest::compute_in_tiles(const FunctionDA
             inner->innermost = innermost;
             inner->children = children;
             inner->inlined = inlined;
-            inner->bounds = bounds;
+            {
+                std::lock_guard<std::mutex> lock(bounds_mutex);
+                inner->bounds = bounds;
+            }
             inner->store_at = store_at;
 
             {
@@ -1963,7 +2029,10 @@ void LoopNest::copy_from_including_features(const LoopNest &n) {
     children = n.children;
     inlined = n.inlined;
     store_at = n.store_at;
-    bounds = n.bounds;
+    {
+        std::lock_guard<std::mutex> lock(n.bounds_mutex);
+        bounds = n.bounds;
+    }
     node = n.node;
     stage = n.stage;
     innermost = n.innermost;
@@ -1973,6 +2042,36 @@ void LoopNest::copy_from_including_features(const LoopNest &n) {
     vectorized_loop_index = n.vectorized_loop_index;
     features_cache = n.features_cache;
     feature_intermediates_cache = n.feature_intermediates_cache;
+    if (const CacheWrites *writes = current_cache_writes()) {
+        copy_cache_writes(&n, writes->features, features_cache);
+        copy_cache_writes(&n, writes->feature_intermediates, feature_intermediates_cache);
+    }
+}
+
+const StageMap<ScheduleFeatures> *LoopNest::find_cached_features(uint64_t hash_of_producers) const {
+    const CacheWrites *writes = current_cache_writes();
+    return find_in_cache(this, hash_of_producers, features_cache, writes ? &writes->features : nullptr);
+}
+
+const StageMap<StageMap<FeatureIntermediates>> *LoopNest::find_cached_feature_intermediates(uint64_t hash_of_producers) const {
+    const CacheWrites *writes = current_cache_writes();
+    return find_in_cache(this, hash_of_producers, feature_intermediates_cache, writes ? &writes->feature_intermediates : nullptr);
+}
+
+StageMap<ScheduleFeatures> &LoopNest::cached_features(uint64_t hash_of_producers) const {
+    CacheWrites *writes = current_cache_writes();
+    if (!writes) {
+        return features_cache[hash_of_producers];
+    }
+    return get_cache_write(this, hash_of_producers, features_cache, writes->features, writes);
+}
+
+StageMap<StageMap<FeatureIntermediates>> &LoopNest::cached_feature_intermediates(uint64_t hash_of_producers) const {
+    CacheWrites *writes = current_cache_writes();
+    if (!writes) {
+        return feature_intermediates_cache[hash_of_producers];
+    }
+    return get_cache_write(this, hash_of_producers, feature_intermediates_cache, writes->feature_intermediates, writes);
 }
 
 void LoopNest::memoize_points_computed_minimum(StageMap<ScheduleFeatures> &memoized_features, const StageMap<ScheduleFeatures> *features) const {
@@ -2046,9 +2145,10 @@ void LoopNest::recompute_inlined_features(const StageMap<Sites> &sites, StageMap
         internal_assert(sites.contains(block->stage));
         uint64_t hash_of_producers = sites.get(block->stage).hash_of_producers_stored_at_root;
 
-        internal_assert(block->feature_intermediates_cache.count(hash_of_producers) > 0);
-        auto &intermediate_map = block->feature_intermediates_cache[hash_of_producers].get(&(f->stages[0]));
-        auto &intermediate = intermediate_map.get(stage);
+        const auto *cached_intermediates = block->find_cached_feature_intermediates(hash_of_producers);
+        internal_assert(cached_intermediates);
+        const auto &intermediate_map = cached_intermediates->get(&(f->stages[0]));
+        const auto &intermediate = intermediate_map.get(stage);
 
         auto &inlined_feat = features->get(&(f->stages[0]));
         inlined_feat.inlined_calls += intermediate.inlined_calls;
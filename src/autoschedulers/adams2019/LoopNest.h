@@ -6,9 +6,11 @@
 #ifndef LOOP_NEST_H
 #define LOOP_NEST_H
 
+#include "Arena.h"
 #include "FunctionDAG.h"
 #include "PerfectHashMap.h"
 #include <map>
+#include <mutex>
 #include <set>
 #include <utility>
 #include <vector>
@@ -17,11 +19,14 @@ namespace Halide {
 namespace Internal {
 namespace Autoscheduler {
 
+// The storage of these maps is allocated from the search arena (see Arena.h).
 template<typename T>
-using NodeMap = PerfectHashMap<FunctionDAG::Node, T>;
+using NodeMap = PerfectHashMap<FunctionDAG::Node, T, 4, PerfectHashMapAsserter,
+                               ArenaAllocator<std::pair<const FunctionDAG::Node *, T>>>;
 
 template<typename T>
-using StageMap = PerfectHashMap<FunctionDAG::Node::Stage, T>;
+using StageMap = PerfectHashMap<FunctionDAG::Node::Stage, T, 4, PerfectHashMapAsserter,
+                                ArenaAllocator<std::pair<const FunctionDAG::Node::Stage *, T>>>;
 
 bool may_subtile();
 
@@ -36,6 +41,14 @@ std::vector<std::vector<int64_t>> generate_tilings(const vector<int64_t> &s, int
 struct LoopNest {
     mutable RefCount ref_count;
 
+    // LoopNests are allocated from the search arena.
+    static void *operator new(size_t bytes) {
+        return search_arena().allocate(bytes);
+    }
+    static void operator delete(void *p) {
+        Arena::release(p);
+    }
+
     // The extents of this loop. Put another way, the number of tiles,
     // not the size of each tile.
     std::vector<int64_t> size;
@@ -55,6 +68,10 @@ struct LoopNest {
     // little boxes to the left of the loop nest tree figures.
     mutable NodeMap<Bound> bounds;
 
+    // Guards 'bounds', which get_bounds fills in lazily, possibly while
+    // other threads are reading it.
+    mutable std::mutex bounds_mutex;
+
     // The Func this loop nest belongs to
     const FunctionDAG::Node *node = nullptr;
 
@@ -147,14 +164,15 @@ struct LoopNest {
     }
 
     // Set the region required of a Func at this site.
-    const Bound &set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
-        return bounds.emplace(f, b);
+    void set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
+        std::lock_guard<std::mutex> lock(bounds_mutex);
+        bounds.emplace(f, b);
     }
 
     // Get the region required of a Func at this site, from which we
     // know what region would be computed if it were scheduled here,
     // and what its loop nest would be.
-    const Bound &get_bounds(const FunctionDAG::Node *f) const;
+    Bound get_bounds(const FunctionDAG::Node *f) const;
 
     // Recursively print a loop nest representation to stderr
     void dump(string prefix, const LoopNest *parent) const;
@@ -268,6 +286,19 @@ struct LoopNest {
     // hash of producers -> StageMap
     mutable std::map<uint64_t, StageMap<ScheduleFeatures>> features_cache;
 
+    // Look up an entry in one of the feature caches, returning nullptr
+    // if there isn't one. While a beam state is being expanded, this
+    // also sees the entries written by that expansion so far (see
+    // CacheWrites in Cache.h).
+    const StageMap<ScheduleFeatures> *find_cached_features(uint64_t hash_of_producers) const;
+    const StageMap<StageMap<FeatureIntermediates>> *find_cached_feature_intermediates(uint64_t hash_of_producers) const;
+
+    // Get an entry in one of the feature caches to update, creating it
+    // if necessary. While a beam state is being expanded, the update is
+    // made to a copy of the entry held by that expansion's CacheWrites.
+    StageMap<ScheduleFeatures> &cached_features(uint64_t hash_of_producers) const;
+    StageMap<StageMap<FeatureIntermediates>> &cached_feature_intermediates(uint64_t hash_of_producers) const;
+
     // Same as copy_from (above) but also copies the two caches.
     void copy_from_including_features(const LoopNest &n);
 
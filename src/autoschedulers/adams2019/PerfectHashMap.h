@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 // Avoid a dependence on libHalide by defining a local variant we can use
@@ -34,10 +35,11 @@ struct PerfectHashMapAsserter {
 // think that might be happening, uncomment the assertions below for
 // some extra checking.
 
-template<typename K, typename T, int max_small_size = 4, typename phm_assert = PerfectHashMapAsserter>
+template<typename K, typename T, int max_small_size = 4, typename phm_assert = PerfectHashMapAsserter,
+         typename Allocator = std::allocator<std::pair<const K *, T>>>
 class PerfectHashMap {
 
-    using storage_type = std::vector<std::pair<const K *, T>>;
+    using storage_type = std::vector<std::pair<const K *, T>, Allocator>;
 
     storage_type storage;
 
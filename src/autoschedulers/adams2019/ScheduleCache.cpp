@@ -0,0 +1,375 @@
+#include "ScheduleCache.h"
+#include "ASLog.h"
+#include "LoopNest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace Halide {
+namespace Internal {
+namespace Autoscheduler {
+
+namespace {
+
+// Bump this when the meaning of the stored data changes.
+const int schedule_cache_version = 1;
+
+// A hash that is stable across runs and platforms (64-bit FNV-1a).
+uint64_t stable_hash(const std::string &s) {
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : s) {
+        h ^= (uint8_t)c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Print an Expr without losing anything that distinguishes it from
+// another Expr, such as the low bits of float constants.
+void print_exact(std::ostream &os, const Expr &e) {
+    if (e.defined()) {
+        ExactIRPrinter(os).print(e);
+    } else {
+        os << "(undefined)";
+    }
+}
+
+void dump_definition(std::ostream &os, const Definition &def) {
+    os << "  (";
+    for (const Expr &a : def.args()) {
+        print_exact(os, a);
+        os << ", ";
+    }
+    os << ") = (";
+    for (const Expr &v : def.values()) {
+        print_exact(os, v);
+        os << ", ";
+    }
+    os << ")\n";
+    if (def.predicate().defined()) {
+        os << "  if ";
+        print_exact(os, def.predicate());
+        os << "\n";
+    }
+    for (const ReductionVariable &rv : def.schedule().rvars()) {
+        os << "  " << rv.var << " in [";
+        print_exact(os, rv.min);
+        os << ", ";
+        print_exact(os, rv.extent);
+        os << "]\n";
+    }
+}
+
+// Everything about the algorithm and target that affects the schedule,
+// but not the estimates.
+std::string describe_pipeline(const FunctionDAG &dag, const Target &target) {
+    std::ostringstream os;
+    os << "version: " << schedule_cache_version << "\n"
+       << "target: " << target.to_string() << "\n";
+    for (const auto &n : dag.nodes) {
+        os << "Func: " << n.func.name() << "\n";
+        for (const auto &arg : n.func.args()) {
+            os << "  arg " << arg << "\n";
+        }
+        if (n.func.has_pure_definition()) {
+            dump_definition(os, n.func.definition());
+            for (const Definition &def : n.func.updates()) {
+                dump_definition(os, def);
+            }
+        }
+        if (n.is_output && !n.func.output_buffers().empty()) {
+            const Parameter &output = n.func.output_buffers()[0];
+            for (int i = 0; i < output.dimensions(); i++) {
+                os << "  stride " << i << ": ";
+                print_exact(os, output.stride_constraint(i));
+                os << "\n";
+            }
+        }
+    }
+    return os.str();
+}
+
+void save_loop_nest(std::ostream &os, const LoopNest &n) {
+    os << "loop_nest "
+       << (n.node ? n.node->id : -1) << " "
+       << (n.stage ? n.stage->index : -1) << " "
+       << n.innermost << " "
+       << n.tileable << " "
+       << n.parallel << " "
+       << n.vector_dim << " "
+       << n.vectorized_loop_index << "\n";
+
+    os << n.size.size();
+    for (int64_t s : n.size) {
+        os << " " << s;
+    }
+    os << "\n";
+
+    os << n.inlined.size();
+    for (auto it = n.inlined.begin(); it != n.inlined.end(); it++) {
+        os << " " << it.key()->id << " " << it.value();
+    }
+    os << "\n";
+
+    os << n.store_at.size();
+    for (const auto *f : n.store_at) {
+        os << " " << f->id;
+    }
+    os << "\n";
+
+    std::lock_guard<std::mutex> lock(n.bounds_mutex);
+    os << n.bounds.size() << "\n";
+    for (auto it = n.bounds.begin(); it != n.bounds.end(); it++) {
+        const Bound &b = it.value();
+        os << it.key()->id;
+        for (int i = 0; i < b->layout->total_size; i++) {
+            const Span &s = b->data()[i];
+            os << " " << s.min() << " " << s.max() << " " << s.constant_extent();
+        }
+        os << "\n";
+    }
+
+    os << n.children.size() << "\n";
+    for (const auto &c : n.children) {
+        save_loop_nest(os, *c);
+    }
+}
+
+// Read a count of things that can't be more numerous than 'limit'.
+bool load_count(std::istream &is, size_t limit, size_t *count) {
+    return (bool)(is >> *count) && *count <= limit;
+}
+
+bool load_node(std::istream &is, const FunctionDAG &dag, const FunctionDAG::Node **node) {
+    int id;
+    if (!(is >> id) || id < 0 || id >= (int)dag.nodes.size()) {
+        return false;
+    }
+    *node = &dag.nodes[id];
+    return true;
+}
+
+// Returns nullptr if the stream doesn't hold a valid loop nest for the dag.
+LoopNest *load_loop_nest(std::istream &is, const FunctionDAG &dag) {
+    std::string tag;
+    int node_id, stage_index;
+    if (!(is >> tag) || tag != "loop_nest" || !(is >> node_id >> stage_index)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<LoopNest> n(new LoopNest);
+    if (node_id >= 0) {
+        if (node_id >= (int)dag.nodes.size() ||
+            stage_index < 0 ||
+            stage_index >= (int)dag.nodes[node_id].stages.size()) {
+            return nullptr;
+        }
+        n->node = &dag.nodes[node_id];
+        n->stage = &dag.nodes[node_id].stages[stage_index];
+    }
+    if (!(is >> n->innermost >> n->tileable >> n->parallel >> n->vector_dim >> n->vectorized_loop_index)) {
+        return nullptr;
+    }
+
+    // A loop nest has no more loops than the stage it computes.
+    size_t count;
+    if (!load_count(is, n->stage ? n->stage->loop.size() : 0, &count)) {
+        return nullptr;
+    }
+    n->size.resize(count);
+    for (auto &s : n->size) {
+        if (!(is >> s)) {
+            return nullptr;
+        }
+    }
+
+    if (!load_count(is, dag.nodes.size(), &count)) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const FunctionDAG::Node *f;
+        int64_t calls;
+        if (!load_node(is, dag, &f) || !(is >> calls)) {
+            return nullptr;
+        }
+        n->inlined.insert(f, calls);
+    }
+
+    if (!load_count(is, dag.nodes.size(), &count)) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const FunctionDAG::Node *f;
+        if (!load_node(is, dag, &f)) {
+            return nullptr;
+        }
+        n->store_at.insert(f);
+    }
+
+    if (!load_count(is, dag.nodes.size(), &count)) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const FunctionDAG::Node *f;
+        if (!load_node(is, dag, &f)) {
+            return nullptr;
+        }
+        Bound b(f->make_bound());
+        BoundContents *contents = const_cast<BoundContents *>(b.get());
+        for (int j = 0; j < contents->layout->total_size; j++) {
+            int64_t min, max;
+            bool constant_extent;
+            if (!(is >> min >> max >> constant_extent)) {
+                return nullptr;
+            }
+            contents->data()[j] = Span(min, max, constant_extent);
+        }
+        n->bounds.emplace(f, std::move(b));
+    }
+
+    // Every child computes a different stage.
+    size_t num_stages = 0;
+    for (const auto &f : dag.nodes) {
+        num_stages += f.stages.size();
+    }
+    if (!load_count(is, num_stages, &count)) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < count; i++) {
+        LoopNest *c = load_loop_nest(is, dag);
+        if (!c) {
+            return nullptr;
+        }
+        n->children.emplace_back(c);
+    }
+
+    return n.release();
+}
+
+}  // namespace
+
+ScheduleCache::ScheduleCache(const std::string &dir,
+                             const FunctionDAG &dag,
+                             const Target &target,
+                             const std::string &search_settings) {
+    const std::string pipeline = describe_pipeline(dag, target);
+
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << stable_hash(pipeline);
+    filename = dir + "/" + hex.str() + ".schedule_cache";
+
+    std::ostringstream everything;
+    everything << pipeline;
+    dag.dump(everything);
+    for (const auto &n : dag.nodes) {
+        for (const auto &s : n.estimated_region_required) {
+            everything << n.func.name() << " estimate: " << s.min() << ", " << s.max() << "\n";
+        }
+    }
+    everything << search_settings;
+    key = stable_hash(everything.str());
+}
+
+IntrusivePtr<State> ScheduleCache::lookup(const FunctionDAG &dag,
+                                          std::unordered_set<uint64_t> *warm_start_hashes) const {
+    std::ifstream f(filename);
+    if (!f.is_open()) {
+        aslog(1) << "No schedule cache entry in " << filename << "\n";
+        return IntrusivePtr<State>();
+    }
+
+    std::string tag;
+    int version;
+    uint64_t entry_key;
+    size_t num_hashes;
+    if (!(f >> tag >> version) || tag != "schedule_cache" || version != schedule_cache_version ||
+        !(f >> tag >> entry_key) || tag != "key" ||
+        !(f >> tag >> num_hashes) || tag != "hashes") {
+        aslog(0) << "Ignoring malformed schedule cache entry " << filename << "\n";
+        return IntrusivePtr<State>();
+    }
+    std::unordered_set<uint64_t> hashes;
+    for (size_t i = 0; i < num_hashes; i++) {
+        uint64_t h;
+        if (!(f >> h)) {
+            aslog(0) << "Ignoring malformed schedule cache entry " << filename << "\n";
+            return IntrusivePtr<State>();
+        }
+        hashes.insert(h);
+    }
+
+    if (entry_key != key) {
+        aslog(0) << "Warm-starting beam search from schedule cache entry " << filename << "\n";
+        warm_start_hashes->insert(hashes.begin(), hashes.end());
+        return IntrusivePtr<State>();
+    }
+
+    IntrusivePtr<State> state{new State};
+    LoopNest *root = nullptr;
+    if (!(f >> tag >> state->cost) || tag != "cost" ||
+        !(f >> tag >> state->num_decisions_made) || tag != "decisions" ||
+        !(root = load_loop_nest(f, dag)) ||
+        !root->is_root()) {
+        aslog(0) << "Ignoring malformed schedule cache entry " << filename << "\n";
+        delete root;
+        return IntrusivePtr<State>();
+    }
+    state->root = root;
+
+    aslog(0) << "Using schedule from schedule cache entry " << filename << "\n";
+    return state;
+}
+
+void ScheduleCache::store(const State &best) const {
+    std::unordered_set<uint64_t> hashes;
+    for (const State *s = &best; s; s = s->parent.get()) {
+        for (int pass_idx = 0; pass_idx < schedule_cache_warm_start_passes; pass_idx++) {
+            hashes.insert(s->structural_hash(pass_idx));
+        }
+    }
+
+    std::ostringstream os;
+    os << "schedule_cache " << schedule_cache_version << "\n"
+       << "key " << key << "\n"
+       << "hashes " << hashes.size();
+    for (uint64_t h : hashes) {
+        os << " " << h;
+    }
+    os << "\n"
+       << "cost " << std::setprecision(17) << best.cost << "\n"
+       << "decisions " << best.num_decisions_made << "\n";
+    save_loop_nest(os, *best.root);
+
+    // Several builds may share the cache, so write a temporary file and
+    // move it into place.
+    std::string tmp = filename + "." +
+                      std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+                      ".tmp";
+    {
+        std::ofstream f(tmp);
+        f << os.str();
+        f.close();
+        if (f.fail()) {
+            aslog(0) << "Failed to write schedule cache entry " << tmp << "\n";
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+        // Renaming over an existing file fails on some platforms.
+        std::remove(filename.c_str());
+        if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+            aslog(0) << "Failed to write schedule cache entry " << filename << "\n";
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+    aslog(1) << "Wrote schedule cache entry " << filename << "\n";
+}
+
+}  // namespace Autoscheduler
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,61 @@
+#ifndef SCHEDULE_CACHE_H
+#define SCHEDULE_CACHE_H
+
+#include "FunctionDAG.h"
+#include "Halide.h"
+#include "State.h"
+
+#include <string>
+#include <unordered_set>
+
+namespace Halide {
+namespace Internal {
+namespace Autoscheduler {
+
+/*
+  A persistent, on-disk cache of the schedules found by the autoscheduler, enabled by setting
+  HL_SCHEDULE_CACHE_DIR (see AutoSchedule.cpp). The directory holds one file per pipeline, named
+  after a hash of the algorithm and the target. Each file records the best State found for that
+  pipeline, together with a key that hashes everything else the search depends on: the
+  FunctionDAG (which includes the parameter estimates), the output estimates, the machine
+  params, the cost model weights, and the search settings.
+
+  If the key matches, the stored State is used as is, and no search takes place. Otherwise, if
+  there is an entry for the same pipeline, the search is warm-started from it: the structural
+  hashes of the decisions that led to the stored State are treated as permitted hashes, as if
+  the earlier coarse passes of the beam search had already been run and had blessed them (see
+  optimal_schedule in AutoSchedule.cpp), and those passes are skipped.
+*/
+class ScheduleCache {
+    std::string filename;
+    uint64_t key;
+
+public:
+    // 'search_settings' should describe everything other than the
+    // FunctionDAG and the target that affects the schedule found.
+    ScheduleCache(const std::string &dir,
+                  const FunctionDAG &dag,
+                  const Target &target,
+                  const std::string &search_settings);
+
+    // Look up the schedule for this pipeline. Returns the stored State on
+    // a hit, and an undefined pointer otherwise. On a miss where there is
+    // an entry for the same pipeline, adds the structural hashes of its
+    // decisions to 'warm_start_hashes'.
+    IntrusivePtr<State> lookup(const FunctionDAG &dag,
+                               std::unordered_set<uint64_t> *warm_start_hashes) const;
+
+    // Store the best State found for this pipeline, replacing any
+    // previous entry.
+    void store(const State &best) const;
+};
+
+// The structural hashes of the decisions that led to a State are stored
+// for the first this many passes of beam search.
+const int schedule_cache_warm_start_passes = 2;
+
+}  // namespace Autoscheduler
+}  // namespace Internal
+}  // namespace Halide
+
+#endif  // SCHEDULE_CACHE_H
@@ -2,6 +2,7 @@
 #define STATE_H
 
 #include "ASLog.h"
+#include "Arena.h"
 #include "Cache.h"
 #include "CostModel.h"
 #include "DefaultCostModel.h"
@@ -9,6 +10,7 @@
 #include "Halide.h"
 #include "LoopNest.h"
 #include "PerfectHashMap.h"
+#include <atomic>
 #include <map>
 #include <utility>
 
@@ -20,6 +22,15 @@ namespace Autoscheduler {
 // It represents a partial schedule for some pipeline.
 struct State {
     mutable RefCount ref_count;
+
+    // States are allocated from the search arena.
+    static void *operator new(size_t bytes) {
+        return search_arena().allocate(bytes);
+    }
+    static void operator delete(void *p) {
+        Arena::release(p);
+    }
+
     // The LoopNest this state corresponds to.
     IntrusivePtr<const LoopNest> root;
     // The parent that generated this state.
@@ -37,7 +48,7 @@ struct State {
 
     // The number of times a cost is enqueued into the cost model,
     // for all states.
-    static int cost_calculations;
+    static std::atomic<int> cost_calculations;
 
     State() = default;
     State(const State &) = delete;
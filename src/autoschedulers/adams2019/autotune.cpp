@@ -0,0 +1,562 @@
+// An in-process autotuning driver for the Adams2019 autoscheduler. It does
+// the same job as autotune_loop.sh, without running a separate generator,
+// compiler and benchmark process for each sample: link it with the
+// Generators to tune, and it will, for each batch,
+//
+//   - autoschedule a batch of randomly perturbed candidate schedules
+//     (using HL_RANDOM_DROPOUT), plus one found by the full beam search,
+//   - JIT-compile the candidates in parallel,
+//   - benchmark them one at a time on the requested cores,
+//   - write a .sample file for each one, and
+//   - retrain the cost model weights on all the samples so far, using
+//     retrain_cost_model, so that the next batch uses the new weights.
+//
+// Example:
+//   demo.autotune --generator=demo --plugin=bin/libautoschedule_adams2019.so
+//                 --weights=baseline.weights --samples=bin/samples
+//                 --retrain_cost_model=bin/retrain_cost_model --cores=0,1,2,3
+
+#include "Halide.h"
+#include "cmdline.h"
+#include "halide_benchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+using std::string;
+using std::vector;
+
+struct Flags {
+    string generator;
+    GeneratorParamsMap generator_args;
+    string plugin;
+    string weights_path;
+    string samples_dir;
+    string retrain_cost_model_path;
+    Target target;
+    string machine_params;
+    int pipeline_id = 0;
+    int num_batches = 1;
+    int batch_size = 32;
+    int random_dropout = 1;
+    int compile_threads = 0;
+    vector<int> cores;
+    Tools::BenchmarkConfig benchmark_config;
+    int benchmark_repeats = 3;
+    int cooldown_ms = 0;
+
+    Flags(int argc, char **argv) {
+        cmdline::parser a;
+
+        const char *kNoDesc = "";
+
+        constexpr bool kOptional = false;
+        a.add<string>("generator", '\0', "name of the Generator to autotune");
+        a.add<string>("generator_args", '\0', "space-separated GeneratorParam values, e.g. \"foo=1 bar=2\"", kOptional, "");
+        a.add<string>("plugin", '\0', "path to libautoschedule_adams2019");
+        a.add<string>("weights", '\0', "the cost model weights; updated in place after each batch");
+        a.add<string>("samples", '\0', "the directory to write samples to");
+        a.add<string>("retrain_cost_model", '\0', "path to retrain_cost_model; if empty, the weights are not retrained", kOptional, "");
+        a.add<string>("target", '\0', kNoDesc, kOptional, "host");
+        a.add<string>("machine_params", '\0', kNoDesc, kOptional, "32,24000000,40");
+        a.add<int>("pipeline_id", '\0', "distinguishes the samples of different generator_args", kOptional, 0);
+        a.add<int>("num_batches", '\0', kNoDesc, kOptional, 1);
+        a.add<int>("batch_size", '\0', kNoDesc, kOptional, 32);
+        a.add<int>("random_dropout", '\0', "HL_RANDOM_DROPOUT for all but the first sample of each batch", kOptional, 1);
+        a.add<int>("compile_threads", '\0', "threads used to compile the candidates; 0 means one per core", kOptional, 0);
+        a.add<string>("cores", '\0', "comma-separated cores to benchmark on; if empty, don't pin", kOptional, "");
+        a.add<double>("benchmark_min_time", '\0', kNoDesc, kOptional, 0.1);
+        a.add<double>("benchmark_accuracy", '\0', kNoDesc, kOptional, 0.03);
+        a.add<int>("benchmark_repeats", '\0', "times to benchmark each candidate, taking the fastest", kOptional, 3);
+        a.add<int>("cooldown_ms", '\0', "pause before each benchmark", kOptional, 0);
+
+        a.parse_check(argc, argv);  // exits if parsing fails
+
+        generator = a.get<string>("generator");
+        generator_args = parse_generator_args(a.get<string>("generator_args"));
+        plugin = a.get<string>("plugin");
+        weights_path = a.get<string>("weights");
+        samples_dir = a.get<string>("samples");
+        retrain_cost_model_path = a.get<string>("retrain_cost_model");
+        target = Target(a.get<string>("target"));
+        machine_params = a.get<string>("machine_params");
+        pipeline_id = a.get<int>("pipeline_id");
+        num_batches = a.get<int>("num_batches");
+        batch_size = a.get<int>("batch_size");
+        random_dropout = a.get<int>("random_dropout");
+        compile_threads = a.get<int>("compile_threads");
+        cores = parse_ints(a.get<string>("cores"));
+        benchmark_config.min_time = a.get<double>("benchmark_min_time");
+        benchmark_config.max_time = benchmark_config.min_time * 4;
+        benchmark_config.accuracy = a.get<double>("benchmark_accuracy");
+        benchmark_repeats = a.get<int>("benchmark_repeats");
+        cooldown_ms = a.get<int>("cooldown_ms");
+
+        if (num_batches <= 0 || batch_size <= 0 || benchmark_repeats <= 0) {
+            std::cerr << "--num_batches, --batch_size and --benchmark_repeats must be > 0.\n";
+            std::cerr << a.usage();
+            exit(1);
+        }
+    }
+
+    GeneratorParamsMap parse_generator_args(const string &s) {
+        GeneratorParamsMap result;
+        std::istringstream is(s);
+        string arg;
+        while (is >> arg) {
+            size_t eq = arg.find('=');
+            if (eq == string::npos) {
+                std::cerr << "Expected name=value in --generator_args, got: " << arg << "\n";
+                exit(1);
+            }
+            result[arg.substr(0, eq)] = arg.substr(eq + 1);
+        }
+        return result;
+    }
+
+    vector<int> parse_ints(const string &s) {
+        vector<int> v;
+        for (const string &i : split_string(s, ",")) {
+            if (!i.empty()) {
+                v.push_back(std::atoi(i.c_str()));
+            }
+        }
+        return v;
+    }
+};
+
+void set_env(const string &name, const string &value) {
+#ifdef _WIN32
+    _putenv_s(name.c_str(), value.c_str());
+#else
+    setenv(name.c_str(), value.c_str(), 1);
+#endif
+}
+
+void make_dir(const string &path) {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+void copy_file(const string &src, const string &dst) {
+    std::ifstream in(src, std::ios::binary);
+    std::ofstream out(dst, std::ios::binary);
+    out << in.rdbuf();
+    if (in.fail() || out.fail()) {
+        std::cerr << "Unable to copy " << src << " to " << dst << "\n";
+        exit(1);
+    }
+}
+
+// Restricts the calling thread to a set of cores while it is in
+// scope. Threads it creates in the meantime, such as the Halide
+// runtime's thread pool, stay on those cores.
+class ScopedAffinity {
+#ifdef __linux__
+    cpu_set_t old_cpus;
+#endif
+    bool pinned = false;
+
+public:
+    explicit ScopedAffinity(const vector<int> &cores) {
+        if (cores.empty()) {
+            return;
+        }
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int c : cores) {
+            CPU_SET(c, &cpus);
+        }
+        pinned = sched_getaffinity(0, sizeof(old_cpus), &old_cpus) == 0 &&
+                 sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#endif
+        if (!pinned) {
+            std::cerr << "Unable to pin benchmarks to the requested cores; continuing without pinning\n";
+        }
+    }
+
+    ~ScopedAffinity() {
+#ifdef __linux__
+        if (pinned) {
+            sched_setaffinity(0, sizeof(old_cpus), &old_cpus);
+        }
+#endif
+    }
+};
+
+int64_t get_const_int(const Expr &e, const string &what) {
+    const int64_t *i = e.defined() ? as_const_int(e) : nullptr;
+    if (!i) {
+        std::cerr << "Need a constant estimate for " << what << "\n";
+        exit(1);
+    }
+    return *i;
+}
+
+template<typename T>
+void fill_random(Buffer<> &buf, std::mt19937 &rng) {
+    Buffer<T> b(buf);
+    if (b.type().is_float()) {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        b.for_each_value([&](T &v) { v = (T)dist(rng); });
+    } else {
+        // Keep integer inputs small, so that they behave like
+        // indices or pixel values.
+        std::uniform_int_distribution<int> dist(0, b.type().is_bool() ? 1 : 127);
+        b.for_each_value([&](T &v) { v = (T)dist(rng); });
+    }
+}
+
+void fill_random(Buffer<> &buf, std::mt19937 &rng) {
+    const Type t = buf.type();
+    if (t == Float(32)) {
+        fill_random<float>(buf, rng);
+    } else if (t == Float(64)) {
+        fill_random<double>(buf, rng);
+    } else if (t == Bool()) {
+        fill_random<bool>(buf, rng);
+    } else if (t == Int(8)) {
+        fill_random<int8_t>(buf, rng);
+    } else if (t == Int(16)) {
+        fill_random<int16_t>(buf, rng);
+    } else if (t == Int(32)) {
+        fill_random<int32_t>(buf, rng);
+    } else if (t == Int(64)) {
+        fill_random<int64_t>(buf, rng);
+    } else if (t == UInt(8)) {
+        fill_random<uint8_t>(buf, rng);
+    } else if (t == UInt(16)) {
+        fill_random<uint16_t>(buf, rng);
+    } else if (t == UInt(32)) {
+        fill_random<uint32_t>(buf, rng);
+    } else if (t == UInt(64)) {
+        fill_random<uint64_t>(buf, rng);
+    } else {
+        std::cerr << "Leaving input of type " << t << " zero-filled\n";
+        memset(buf.data(), 0, buf.size_in_bytes());
+    }
+}
+
+halide_scalar_value_t scalar_from_estimate(const Type &t, const Expr &e, const string &name) {
+    halide_scalar_value_t v;
+    v.u.u64 = 0;
+    if (t.is_float()) {
+        const double *f = e.defined() ? as_const_float(e) : nullptr;
+        if (!f) {
+            std::cerr << "Need a constant estimate for " << name << "\n";
+            exit(1);
+        }
+        if (t.bits() == 64) {
+            v.u.f64 = *f;
+        } else {
+            v.u.f32 = (float)*f;
+        }
+        return v;
+    }
+    int64_t i;
+    if (const uint64_t *u = e.defined() ? as_const_uint(e) : nullptr) {
+        i = (int64_t)*u;
+    } else {
+        i = get_const_int(e, name);
+    }
+    switch (t.bits()) {
+    case 1:
+        v.u.b = i != 0;
+        break;
+    case 8:
+        v.u.i8 = (int8_t)i;
+        break;
+    case 16:
+        v.u.i16 = (int16_t)i;
+        break;
+    case 32:
+        v.u.i32 = (int32_t)i;
+        break;
+    default:
+        v.u.i64 = i;
+        break;
+    }
+    return v;
+}
+
+// One candidate schedule for the pipeline.
+struct Candidate {
+    std::unique_ptr<GeneratorBase> generator;
+    Pipeline pipeline;
+    AutoSchedulerResults results;
+    int32_t schedule_id = 0;
+    string dir, name;
+    bool compiled = false;
+    vector<Buffer<>> output_buffers;
+    double runtime = std::numeric_limits<double>::infinity();  // in seconds
+};
+
+// Bind the inputs of the pipeline to buffers and values matching their
+// estimates, as RunGen's --estimate_all does, and allocate outputs of the
+// estimated size.
+void bind_inputs_and_outputs(Candidate &c, std::mt19937 &rng) {
+    vector<Function> outputs;
+    for (const Func &f : c.pipeline.outputs()) {
+        outputs.push_back(f.function());
+    }
+    for (const InferredArgument &arg : infer_arguments(Stmt(), outputs)) {
+        Parameter p = arg.param;
+        if (!p.defined() || arg.buffer.defined()) {
+            continue;
+        }
+        if (p.is_buffer()) {
+            vector<int> mins, extents;
+            for (int i = 0; i < p.dimensions(); i++) {
+                const string what = p.name() + " dimension " + std::to_string(i);
+                mins.push_back((int)get_const_int(p.min_constraint_estimate(i), what));
+                extents.push_back((int)get_const_int(p.extent_constraint_estimate(i), what));
+            }
+            Buffer<> b(p.type(), extents, p.name());
+            b.set_min(mins);
+            fill_random(b, rng);
+            p.set_buffer(b);
+        } else if (p.estimate().defined()) {
+            p.set_scalar(p.type(), scalar_from_estimate(p.type(), p.estimate(), p.name()));
+        }
+    }
+
+    c.output_buffers.clear();
+    for (const Func &f : c.pipeline.outputs()) {
+        // Outputs have estimates, and perhaps bounds, on each dimension
+        // (see FunctionDAG.cpp).
+        vector<int> mins(f.dimensions()), extents(f.dimensions());
+        const auto &schedule = f.function().schedule();
+        for (const auto *bounds : {&schedule.estimates(), &schedule.bounds()}) {
+            for (const Bound &b : *bounds) {
+                for (int i = 0; i < f.dimensions(); i++) {
+                    if (f.args()[i].name() == b.var && b.min.defined() && b.extent.defined()) {
+                        const string what = f.name() + " dimension " + std::to_string(i);
+                        mins[i] = (int)get_const_int(b.min, what);
+                        extents[i] = (int)get_const_int(b.extent, what);
+                    }
+                }
+            }
+        }
+        for (const Type &t : f.output_types()) {
+            Buffer<> b(t, extents);
+            b.set_min(mins);
+            c.output_buffers.push_back(b);
+        }
+    }
+}
+
+void write_sample(const Candidate &c, int32_t pipeline_id) {
+    const string base = c.dir + "/" + c.name;
+    {
+        std::ofstream f(base + ".schedule.h");
+        f << c.results.schedule_source;
+        f.close();
+        if (f.fail()) {
+            std::cerr << "Unable to write " << base << ".schedule.h\n";
+        }
+    }
+
+    // A sample is the featurization followed by the runtime in
+    // milliseconds and the ids (see featurization_to_sample.cpp).
+    std::ofstream f(base + ".sample", std::ios::binary);
+    float r = (float)(c.runtime * 1000.0);
+    f.write((const char *)c.results.featurization.data(), c.results.featurization.size());
+    f.write((const char *)&r, 4);
+    f.write((const char *)&pipeline_id, 4);
+    f.write((const char *)&c.schedule_id, 4);
+    f.close();
+    if (f.fail()) {
+        std::cerr << "Unable to write " << base << ".sample\n";
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Flags flags(argc, argv);
+
+    load_plugin(flags.plugin);
+    Pipeline::set_default_autoscheduler_name("Adams2019");
+    set_compile_thread_count(flags.compile_threads);
+
+    const MachineParams machine_params(flags.machine_params);
+
+    // The Halide runtime thread pool is created on the first parallel
+    // benchmark, so size it to the cores we pin to, unless told otherwise.
+    if (!flags.cores.empty() && get_env_variable("HL_NUM_THREADS").empty()) {
+        set_env("HL_NUM_THREADS", std::to_string(flags.cores.size()));
+    }
+
+    // Every sample written, here or by earlier runs, is listed in this
+    // file, which retrain_cost_model reads the samples from.
+    make_dir(flags.samples_dir);
+    const string sample_list = flags.samples_dir + "/samples.txt";
+
+    // Don't clobber existing samples
+    int first_batch = 1;
+    auto batch_dir = [&](int batch_id) {
+        return flags.samples_dir + "/batch_" + std::to_string(batch_id) + "_" + std::to_string(flags.pipeline_id);
+    };
+    while (file_exists(batch_dir(first_batch))) {
+        first_batch++;
+    }
+
+    std::mt19937 rng(0);
+    for (int batch_id = first_batch; batch_id < first_batch + flags.num_batches; batch_id++) {
+        auto start = std::chrono::steady_clock::now();
+
+        const string dir = batch_dir(batch_id);
+        make_dir(dir);
+        // Keep the weights used, so that failures can be reproduced
+        copy_file(flags.weights_path, dir + "/used.weights");
+
+        // The autoscheduler reads its settings from the environment,
+        // so the candidates are autoscheduled one at a time. Each
+        // search still expands its beam on multiple threads.
+        std::cout << "Autoscheduling " << flags.batch_size << " samples" << std::flush;
+        vector<Candidate> candidates(flags.batch_size);
+        for (int i = 0; i < flags.batch_size; i++) {
+            Candidate &c = candidates[i];
+            c.schedule_id = batch_id * 10000 + i;
+            char name[256];
+            snprintf(name, sizeof(name), "%s_batch_%04d_sample_%04d", flags.generator.c_str(), batch_id, i);
+            c.name = name;
+            c.dir = dir + "/" + std::to_string(i);
+            make_dir(c.dir);
+
+            // The first sample is the one the full beam search would
+            // pick. The rest are random explorations around it.
+            set_env("HL_SEED", std::to_string(c.schedule_id));
+            set_env("HL_WEIGHTS_DIR", flags.weights_path);
+            set_env("HL_RANDOM_DROPOUT", i == 0 ? "100" : std::to_string(flags.random_dropout));
+            set_env("HL_BEAM_SIZE", i == 0 ? "32" : "1");
+
+            // build_module() autoschedules the Pipeline in place, so
+            // the Generator's Pipeline is the one to JIT-compile.
+            c.generator = GeneratorRegistry::create(flags.generator, GeneratorContext(flags.target, true, machine_params));
+            c.generator->set_generator_param_values(flags.generator_args);
+            Module m = c.generator->build_module(c.name);
+            c.results = *m.get_auto_scheduler_results();
+            c.pipeline = c.generator->get_pipeline();
+            std::cout << "." << std::flush;
+        }
+        std::cout << " done.\n";
+
+        // Compile the candidates in parallel
+        std::cout << "Compiling " << flags.batch_size << " samples\n";
+        run_compile_jobs(candidates.size(), [&](size_t i) {
+            Candidate &c = candidates[i];
+            try {
+                c.pipeline.compile_jit(flags.target);
+                c.compiled = true;
+            } catch (const Halide::Error &e) {
+                std::cerr << "Compilation failed for " << c.dir << ": " << e.what() << "\n";
+            }
+        });
+
+        // Benchmark them one at a time, round-robin, so that slow drift
+        // in the machine's speed affects all of them alike. Each
+        // candidate keeps its fastest time.
+        {
+            ScopedAffinity pin(flags.cores);
+            for (Candidate &c : candidates) {
+                if (!c.compiled) {
+                    continue;
+                }
+                try {
+                    bind_inputs_and_outputs(c, rng);
+                    Realization r(c.output_buffers);
+                    // Warm up, and check that it runs at all
+                    c.pipeline.realize(r, flags.target);
+                } catch (const Halide::Error &e) {
+                    std::cerr << "Benchmarking failed for " << c.dir << ": " << e.what() << "\n";
+                    c.compiled = false;
+                }
+            }
+            for (int repeat = 0; repeat < flags.benchmark_repeats; repeat++) {
+                for (Candidate &c : candidates) {
+                    if (!c.compiled) {
+                        continue;
+                    }
+                    if (flags.cooldown_ms > 0) {
+                        // Give CPU clocks a chance to spin back up if we're thermally throttling
+                        std::this_thread::sleep_for(std::chrono::milliseconds(flags.cooldown_ms));
+                    }
+                    Realization r(c.output_buffers);
+                    auto run = [&]() { c.pipeline.realize(r, flags.target); };
+                    Tools::BenchmarkResult result = Tools::benchmark(run, flags.benchmark_config);
+                    c.runtime = std::min(c.runtime, result.wall_time);
+                }
+            }
+        }
+
+        {
+            std::ofstream list(sample_list, std::ios_base::app);
+            for (const Candidate &c : candidates) {
+                if (!c.compiled) {
+                    continue;
+                }
+                std::cout << c.name << ": " << c.runtime * 1000 << " ms\n";
+                write_sample(c, flags.pipeline_id);
+                list << c.dir << "/" << c.name << ".sample\n";
+            }
+        }
+
+        // Free the compiled code and buffers before retraining
+        candidates.clear();
+
+        if (!flags.retrain_cost_model_path.empty()) {
+            // retrain model weights on all samples seen so far
+            std::cout << "Retraining model...\n";
+            std::ostringstream cmd;
+            cmd << "\"" << flags.retrain_cost_model_path << "\""
+                << " --epochs=" << flags.batch_size
+                << " --rates=0.0001"
+                << " --num_cores=" << machine_params.parallelism
+                << " --initial_weights=\"" << flags.weights_path << "\""
+                << " --weights_out=\"" << flags.weights_path << "\""
+                << " --best_benchmark=\"" << flags.samples_dir << "/best." << flags.generator << ".benchmark.txt\""
+                << " --best_schedule=\"" << flags.samples_dir << "/best." << flags.generator << ".schedule.h\""
+                << " < \"" << sample_list << "\"";
+            if (std::system(cmd.str().c_str()) != 0) {
+                std::cerr << "Retraining failed\n";
+                return 1;
+            }
+        }
+
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Batch " << batch_id << " took " << seconds << " seconds to compile, benchmark, and retrain\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Measures how many states per second the default cost model can
+// evaluate, across a range of batch sizes. The features are random,
+// so the predicted costs are meaningless, but the work done per state
+// is the same as during a real search.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "DefaultCostModel.h"
+#include "HalideBuffer.h"
+#include "NetworkSize.h"
+#include "halide_benchmark.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // The number of stages in the pipeline being scheduled, and the
+    // number of distinct states to cycle through.
+    const int num_stages = argc > 1 ? atoi(argv[1]) : 20;
+    const int num_states = 4096;
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> pipeline_dist(0.0f, 10.0f);
+    std::uniform_real_distribution<float> schedule_dist(0.0f, 1e6f);
+
+    Runtime::Buffer<float> pipeline_features(head1_w, head1_h, num_stages);
+    pipeline_features.for_each_value([&](float &f) { f = pipeline_dist(rng); });
+    Runtime::Buffer<float> schedule_features(head2_w, num_stages, num_states);
+    schedule_features.for_each_value([&](float &f) { f = schedule_dist(rng); });
+
+    auto cost_model = make_default_cost_model();
+    cost_model->set_pipeline_features(pipeline_features, 32);
+
+    std::vector<double> costs(num_states);
+
+    printf("%d stages\n", num_stages);
+    for (int batch_size : {1, 8, 32, 128, 1024, 4096}) {
+        cost_model->set_batch_size(batch_size);
+
+        int state = 0;
+        auto evaluate_batch = [&]() {
+            for (int i = 0; i < batch_size; i++) {
+                Runtime::Buffer<float> dst;
+                cost_model->enqueue(num_stages, &dst, &costs[state]);
+                dst.copy_from(schedule_features.sliced(2, state));
+                state = (state + 1) % num_states;
+            }
+            cost_model->evaluate_costs();
+        };
+
+        Tools::BenchmarkConfig config;
+        config.accuracy = 0.05;
+        double t = Tools::benchmark(evaluate_batch, config);
+
+        for (int i = 0; i < num_states; i++) {
+            if (!std::isfinite(costs[i])) {
+                printf("Cost model produced a non-finite cost for state %d: %f\n", i, costs[i]);
+                return -1;
+            }
+        }
+
+        printf("batch size %4d: %10.0f states/second\n", batch_size, batch_size / t);
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -3,6 +3,13 @@
 #include <iostream>  // std::cerr / std::endl
 #include <map>       // std::map
 #include <string>    // std::to_string
+#include <vector>    // std::vector
+
+#ifdef _MSC_VER
+#include <windows.h>  // FindFirstFileA
+#else
+#include <dirent.h>  // opendir
+#endif
 
 using namespace Halide;
 
@@ -14,6 +21,34 @@ void set_env_variable(const std::string &name, const std::string &value, int ove
 #endif
 }
 
+// Remove a directory and the files in it.
+void remove_dir(const std::string &dir) {
+    std::vector<std::string> files;
+#ifdef _MSC_VER
+    WIN32_FIND_DATAA entry;
+    HANDLE h = FindFirstFileA((dir + "\\*").c_str(), &entry);
+    if (h != INVALID_HANDLE_VALUE) {
+        do {
+            files.emplace_back(entry.cFileName);
+        } while (FindNextFileA(h, &entry));
+        FindClose(h);
+    }
+#else
+    if (DIR *d = opendir(dir.c_str())) {
+        while (dirent *entry = readdir(d)) {
+            files.emplace_back(entry->d_name);
+        }
+        closedir(d);
+    }
+#endif
+    for (const auto &f : files) {
+        if (f != "." && f != "..") {
+            Internal::file_unlink(dir + "/" + f);
+        }
+    }
+    Internal::dir_rmdir(dir);
+}
+
 bool test_caching(Pipeline &p1, Pipeline &p2, const Target &target, const MachineParams &params) {
     static const std::string seed_value = Internal::get_env_variable("HL_SEED");
     if (seed_value.empty()) {
@@ -53,6 +88,51 @@ bool test_caching(Pipeline &p1, Pipeline &p2, const Target &target, const Machin
     return true;
 }
 
+bool test_threads(Pipeline &p1, Pipeline &p2, const Target &target, const MachineParams &params) {
+    static const std::string seed_value = Internal::get_env_variable("HL_SEED");
+    if (seed_value.empty()) {
+        // If HL_SEED is not set, then set seed for both autoscheduling executions.
+        int seed = (int)time(nullptr);
+        set_env_variable("HL_SEED", std::to_string(seed), /* overwrite */ 0);
+    }
+
+    // Expand the states in the beam on two threads, and then on more.
+    // (A single thread takes a different path that updates the caches
+    // after every expansion.)
+    const int thread_count = Internal::get_compile_thread_count();
+    Internal::set_compile_thread_count(2);
+    auto results_fewer = p1.auto_schedule(target, params);
+    Internal::set_compile_thread_count(4);
+    auto results_more = p2.auto_schedule(target, params);
+    Internal::set_compile_thread_count(thread_count);
+
+    if (seed_value.empty()) {
+        // Re-empty seed.
+        set_env_variable("HL_SEED", "", /* overwrite */ 1);
+    }
+
+    // The search should have found the same schedule.
+    return results_fewer.schedule_source == results_more.schedule_source &&
+           results_fewer.featurization == results_more.featurization;
+}
+
+bool test_schedule_cache(Pipeline &p1, Pipeline &p2, const Target &target, const MachineParams &params) {
+    const std::string schedule_cache_dir = Internal::get_env_variable("HL_SCHEDULE_CACHE_DIR");
+
+    // The first run searches for a schedule and caches it, and the
+    // second one should use the cached schedule.
+    const std::string temp_dir = Internal::dir_make_temp();
+    set_env_variable("HL_SCHEDULE_CACHE_DIR", temp_dir, /* overwrite */ 1);
+    auto results_searched = p1.auto_schedule(target, params);
+    auto results_cached = p2.auto_schedule(target, params);
+
+    set_env_variable("HL_SCHEDULE_CACHE_DIR", schedule_cache_dir, /* overwrite */ 1);
+    remove_dir(temp_dir);
+
+    return results_searched.schedule_source == results_cached.schedule_source &&
+           results_searched.featurization == results_cached.featurization;
+}
+
 int main(int argc, char **argv) {
     if (argc != 2) {
         fprintf(stderr, "Usage: %s <autoscheduler-lib>\n", argv[0]);
@@ -880,6 +960,76 @@ int main(int argc, char **argv) {
         }
     }
 
+    // A stencil chain, scheduled using multiple threads
+    if (true) {
+        Pipeline p1;
+        Pipeline p2;
+        for (int test_condition = 0; test_condition < 2; test_condition++) {
+            const int N = 8;
+            std::vector<Func> f;
+            for (int i = 0; i < N; i++) {
+                f.emplace_back("f" + std::to_string(i));
+            }
+            f[0](x, y) = (x + y) * (x + 2 * y) * (x + 3 * y);
+            for (int i = 1; i < N; i++) {
+                Expr e = 0;
+                for (int dy = -2; dy <= 2; dy++) {
+                    for (int dx = -2; dx <= 2; dx++) {
+                        e += f[i - 1](x + dx, y + dy);
+                    }
+                }
+                f[i](x, y) = e;
+            }
+            f[N - 1].set_estimate(x, 0, 2048).set_estimate(y, 0, 2048);
+
+            if (test_condition) {
+                p2 = Pipeline(f[N - 1]);
+            } else {
+                p1 = Pipeline(f[N - 1]);
+            }
+        }
+
+        if (!test_threads(p1, p2, target, params)) {
+            std::cerr << "Multithreaded search found a different schedule on stencil chain" << std::endl;
+            return 1;
+        }
+    }
+
+    // A stencil chain, scheduled using a schedule cache
+    if (true) {
+        Pipeline p1;
+        Pipeline p2;
+        for (int test_condition = 0; test_condition < 2; test_condition++) {
+            const int N = 8;
+            std::vector<Func> f;
+            for (int i = 0; i < N; i++) {
+                f.emplace_back("f" + std::to_string(i));
+            }
+            f[0](x, y) = (x + y) * (x + 2 * y) * (x + 3 * y);
+            for (int i = 1; i < N; i++) {
+                Expr e = 0;
+                for (int dy = -2; dy <= 2; dy++) {
+                    for (int dx = -2; dx <= 2; dx++) {
+                        e += f[i - 1](x + dx, y + dy);
+                    }
+                }
+                f[i](x, y) = e;
+            }
+            f[N - 1].set_estimate(x, 0, 2048).set_estimate(y, 0, 2048);
+
+            if (test_condition) {
+                p2 = Pipeline(f[N - 1]);
+            } else {
+                p1 = Pipeline(f[N - 1]);
+            }
+        }
+
+        if (!test_schedule_cache(p1, p2, target, params)) {
+            std::cerr << "Cached schedule differs from the one found on stencil chain" << std::endl;
+            return 1;
+        }
+    }
+
     // Reset environment variables.
     set_env_variable("HL_DISABLE_MEMOIZED_FEATURES", cache_features, /* overwrite */ 1);
     set_env_variable("HL_DISABLE_MEMOIZED_BLOCKS", cache_blocks, /* overwrite */ 1);
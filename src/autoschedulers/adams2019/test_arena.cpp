@@ -0,0 +1,151 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Arena.h"
+
+using namespace Halide::Internal::Autoscheduler;
+
+#define check(c)                                                    \
+    do {                                                            \
+        if (!(c)) {                                                 \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #c); \
+            exit(1);                                                \
+        }                                                           \
+    } while (0)
+
+// Run f on a thread of its own, so that the block that thread was
+// allocating from is let go of when it exits.
+template<typename F>
+void on_new_thread(F f) {
+    std::thread t(f);
+    t.join();
+}
+
+int main(int argc, char **argv) {
+    const size_t block_size = 4096;
+
+    // Allocations are aligned, distinct, and come from a small number of
+    // blocks.
+    {
+        Arena arena(block_size);
+        std::vector<char *> ptrs;
+        on_new_thread([&]() {
+            for (int i = 0; i < 1000; i++) {
+                char *p = (char *)arena.allocate(1 + i % 48);
+                check(((uintptr_t)p & 15) == 0);
+                for (int j = 0; j < 1 + i % 48; j++) {
+                    p[j] = (char)i;
+                }
+                ptrs.push_back(p);
+            }
+        });
+        for (int i = 0; i < 1000; i++) {
+            for (int j = 0; j < 1 + i % 48; j++) {
+                check(ptrs[i][j] == (char)i);
+            }
+        }
+        // Each allocation takes at most 64 bytes, including its header.
+        const size_t blocks = arena.bytes_reserved() / block_size;
+        check(blocks >= 1000 * 32 / block_size && blocks <= 1000 * 64 / block_size + 1);
+
+        // Nothing can be trimmed while the blocks are in use.
+        const size_t reserved = arena.bytes_reserved();
+        arena.trim();
+        check(arena.bytes_reserved() == reserved);
+
+        // Release everything, here on the main thread, and the blocks go back.
+        for (char *p : ptrs) {
+            Arena::release(p);
+        }
+        check(arena.bytes_reserved() == reserved);
+        arena.trim();
+        check(arena.bytes_reserved() == 0);
+    }
+
+    // Memory is only reclaimed a whole block at a time: a single
+    // survivor keeps all of its block reserved.
+    {
+        Arena arena(block_size);
+        std::vector<void *> ptrs;
+        on_new_thread([&]() {
+            for (int i = 0; i < 1000; i++) {
+                ptrs.push_back(arena.allocate(32));
+            }
+        });
+        const size_t reserved = arena.bytes_reserved();
+        check(reserved > 4 * block_size);
+        for (size_t i = 1; i < ptrs.size(); i++) {
+            Arena::release(ptrs[i]);
+        }
+        arena.trim();
+        check(arena.bytes_reserved() > block_size &&
+              arena.bytes_reserved() < 2 * block_size);
+        Arena::release(ptrs[0]);
+        arena.trim();
+        check(arena.bytes_reserved() == 0);
+        check(arena.peak_bytes_reserved() == reserved);
+    }
+
+    // Spare blocks are reused before new ones are made.
+    {
+        Arena arena(block_size);
+        std::vector<void *> ptrs;
+        for (int pass = 0; pass < 2; pass++) {
+            on_new_thread([&]() {
+                for (int i = 0; i < 1000; i++) {
+                    ptrs.push_back(arena.allocate(32));
+                }
+            });
+            for (void *p : ptrs) {
+                Arena::release(p);
+            }
+            ptrs.clear();
+        }
+        check(arena.peak_bytes_reserved() == arena.bytes_reserved());
+        arena.trim();
+        check(arena.bytes_reserved() == 0);
+    }
+
+    // Big allocations get a block of their own, which is freed as soon
+    // as the allocation is.
+    {
+        Arena arena(block_size);
+        void *p = arena.allocate(block_size);
+        check(((uintptr_t)p & 15) == 0);
+        check(arena.bytes_reserved() > block_size);
+        Arena::release(p);
+        check(arena.bytes_reserved() == 0);
+    }
+
+    // Several threads can allocate and release at once.
+    {
+        Arena arena(block_size);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&]() {
+                std::vector<void *> ptrs;
+                for (int i = 0; i < 10000; i++) {
+                    ptrs.push_back(arena.allocate(16 + i % 100));
+                    if (i % 3 == 0) {
+                        Arena::release(ptrs.back());
+                        ptrs.pop_back();
+                    }
+                }
+                for (void *p : ptrs) {
+                    Arena::release(p);
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        arena.trim();
+        check(arena.bytes_reserved() == 0);
+    }
+
+    printf("Success!\n");
+    return 0;
+}
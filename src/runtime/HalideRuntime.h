@@ -361,6 +361,25 @@ extern halide_malloc_t halide_set_custom_malloc(halide_malloc_t user_malloc);
 extern halide_free_t halide_set_custom_free(halide_free_t user_free);
 //@}
 
+/** Tell the default host allocator whether or not it may hold onto
+ * freed allocations to service future requests, instead of returning
+ * them to the system allocator. This helps pipelines that malloc and
+ * free an intermediate once per tile. Freed allocations are kept on
+ * free lists by size class, with up to 128MB held in total. The
+ * default value is false.
+ *
+ * If set to false, releases all unused host allocations back to the
+ * system allocator. This has no effect on a custom malloc or free set
+ * with halide_set_custom_malloc or halide_set_custom_free. */
+extern int halide_reuse_host_allocations(void *user_context, bool);
+
+/** Determines whether on halide_free the default host allocator
+ * returns memory immediately to the system allocator, or places it on
+ * a free list for future use. Override and switch based on the
+ * user_context for finer-grained control. By default just returns the
+ * value most recently set by the method above. */
+extern bool halide_can_reuse_host_allocations(void *user_context);
+
 /** Halide calls these functions to interact with the underlying
  * system runtime functions. To replace in AOT code on platforms that
  * support weak linking, define these functions yourself, or use
@@ -693,6 +712,28 @@ extern void halide_set_trace_file(int fd);
  * information to stdout. */
 extern int halide_get_trace_file(void *user_context);
 
+/** Select a compact encoding for binary trace files, for tracing
+ * loads and stores of large inputs. Loads and stores are buffered,
+ * with threads spread over several buffers so they rarely contend,
+ * and written in chunks of delta-encoded records. All other
+ * events are still written as ordinary halide_trace_packet_t
+ * packets. A chunk is introduced by a 32-bit word with its low two
+ * bits set to 01, which an ordinary packet size never has. See
+ * src/runtime/tracing.cpp for the record layout. HalideTraceDump and
+ * HalideTraceViz decode chunks back into ordinary packets. Loads and
+ * stores from different threads may be reordered relative to each
+ * other, but never move past a realization or production event. If
+ * never called, Halide enables compact tracing when the environment
+ * variable HL_TRACE_COMPACT is set to a nonzero value when it opens
+ * HL_TRACE_FILE. */
+extern void halide_set_trace_compact(bool compact);
+
+/** Only trace every nth load or store event. Other events are
+ * always traced. If never called, Halide reads the rate from the
+ * environment variable HL_TRACE_SAMPLE when it opens
+ * HL_TRACE_FILE. The default is 1, which traces every event. */
+extern void halide_set_trace_sample_rate(int n);
+
 /** If tracing is writing to a file. This call closes that file
  * (flushing the trace). Returns zero on success. */
 extern int halide_shutdown_trace();
@@ -871,6 +912,35 @@ extern int halide_get_gpu_device(void *user_context);
  */
 extern void halide_memoization_cache_set_size(int64_t size);
 
+/** The policies the memoization cache can use to choose which unused
+ * entries to evict when it exceeds its size. Entries are spread over
+ * independently locked shards, so when several threads use the cache
+ * at once the eviction order is approximate. */
+typedef enum halide_memoization_cache_eviction_policy_t {
+    /** Evict the least recently used entry. This is the default. */
+    halide_memoization_cache_evict_lru = 0,
+    /** Evict the entry with the fewest cache hits, breaking ties by
+     * recency. */
+    halide_memoization_cache_evict_lfu = 1,
+    /** Evict the entry with the fewest cache hits per byte stored, so
+     * large, rarely reused results go first. */
+    halide_memoization_cache_evict_size_aware = 2,
+} halide_memoization_cache_eviction_policy_t;
+
+/** Select the policy used to evict entries from the memoization
+ * cache. */
+extern void halide_memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy);
+
+/** Counters describing the behavior of the memoization cache since it
+ * was last cleaned up. */
+struct halide_memoization_cache_stats_t {
+    uint64_t hits, misses, evictions;
+    int64_t entries, current_size, max_size;
+};
+
+/** Fill in the current memoization cache counters. */
+extern void halide_memoization_cache_get_stats(struct halide_memoization_cache_stats_t *stats);
+
 /** Given a cache key for a memoized result, currently constructed
  *  from the Func name and top-level Func name plus the arguments of
  *  the computation, determine if the result is in the cache and
@@ -1337,6 +1407,7 @@ typedef enum halide_target_feature_t {
     halide_llvm_large_code_model,                 ///< Use the LLVM large code model to compile
     halide_target_feature_rvv,                    ///< Enable RISCV "V" Vector Extension
     halide_target_feature_armv81a,                ///< Enable ARMv8.1-a instructions
+    halide_target_feature_profile_counters,       ///< When profiling, also bill hardware performance counters (cycles, instructions, cache and branch misses) to each Func. Currently only supported on x86 Linux. Has no effect without halide_target_feature_profile.
     halide_target_feature_end                     ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
 } halide_target_feature_t;
 
@@ -1734,6 +1805,11 @@ struct halide_profiler_func_stats {
 
     /** The total number of memory allocation of this Func. */
     int num_allocs;
+
+    /** Hardware performance counters billed to this Func. Only
+     * collected for pipelines compiled with the -profile_counters
+     * target flag, on platforms that support it. Zero otherwise. */
+    uint64_t cycles, instructions, llc_misses, branch_misses;
 };
 
 /** Per-pipeline state tracked by the sampling profiler. These exist
@@ -1779,6 +1855,10 @@ struct halide_profiler_pipeline_stats {
 
     /** The total number of memory allocation of funcs in this pipeline. */
     int num_allocs;
+
+    /** Hardware performance counters billed to funcs in this
+     * pipeline. Zero if they were not collected. */
+    uint64_t cycles, instructions, llc_misses, branch_misses;
 };
 
 /** The global state of the profiler. */
@@ -1829,10 +1909,54 @@ enum {
  * inspection. Lock it before using to pause the profiler. */
 extern struct halide_profiler_state *halide_profiler_get_state();
 
+/** The formats halide_profiler_export can write. */
+typedef enum halide_profiler_export_format_t {
+    /** A JSON document with the statistics of each pipeline and Func,
+     * and the timeline of each pipeline invocation. */
+    halide_profiler_export_json = 0,
+    /** The Chrome trace event format, as read by chrome://tracing and
+     * Perfetto. Pipeline invocations and the Funcs they run are shown
+     * as slices on two tracks, the number of active threads and the
+     * heap memory in use as counters, and the statistics of each
+     * pipeline as the arguments of an instant event at the end. */
+    halide_profiler_export_chrome_trace = 1,
+} halide_profiler_export_format_t;
+
+/** Write the statistics gathered since the last reset to a file, in a
+ * machine-readable format. The file also has a timeline of each
+ * pipeline invocation if halide_profiler_record_timeline was turned on
+ * before the pipelines ran. If the HL_PROFILER_EXPORT environment
+ * variable names a file, this happens automatically whenever the
+ * profiler report is printed, with the format chosen by
+ * HL_PROFILER_EXPORT_FORMAT ("json", the default, or "chrome_trace"),
+ * and the timeline is turned on when the profiler starts. Returns zero
+ * on success. */
+extern int halide_profiler_export(void *user_context, const char *filename,
+                                  halide_profiler_export_format_t format);
+
+/** Turn recording of the per-invocation timeline used by
+ * halide_profiler_export on or off. The timeline notes, at the
+ * resolution of the sampling profiler, which Func is running, how many
+ * threads are active, and how much heap memory is in use. It is off by
+ * default and is capped at about a million changes. */
+extern void halide_profiler_record_timeline(bool enabled);
+
 /** Get a pointer to the pipeline state associated with pipeline_name.
  * This function grabs the global profiler state's lock on entry. */
 extern struct halide_profiler_pipeline_stats *halide_profiler_get_pipeline_state(const char *pipeline_name);
 
+/** Ask the profiler to also sample hardware performance counters
+ * (cycles, instructions, last-level cache misses and branch misses)
+ * and bill them to the running Func alongside time. Pipelines compiled
+ * with the -profile_counters target flag call this before starting.
+ * The counters follow every thread created after the first profiled
+ * pipeline starts, which includes the thread pool workers unless they
+ * were already running. Returns zero on success, or a nonzero value if
+ * counters are not available on this platform or the process is not
+ * permitted to open them (see /proc/sys/kernel/perf_event_paranoid on
+ * Linux), in which case profiling continues without them. */
+extern int halide_profiler_enable_hardware_counters();
+
 /** Reset profiler state cheaply. May leave threads running or some
  * memory allocated but all accumluated statistics are reset.
  * WARNING: Do NOT call this method while any halide pipeline is
@@ -84,6 +84,12 @@ struct CacheEntry {
     halide_buffer_t *buf;
     uint64_t eviction_key;
     bool has_eviction_key;
+    // Total size of the tuple buffers, and the number of lookups that
+    // have hit this entry. Used by the eviction policies.
+    uint64_t size_in_bytes;
+    uint64_t hit_count;
+    // When the entry was last stored or looked up, from use_clock.
+    uint64_t last_use;
 
     bool init(const uint8_t *cache_key, size_t cache_key_size,
               uint32_t key_hash,
@@ -126,6 +132,9 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
     in_use_count = 0;
     tuple_count = tuples;
     dimensions = computed_bounds_buf->dimensions;
+    size_in_bytes = 0;
+    hit_count = 0;
+    last_use = 0;
 
     // Allocate all the necessary space (or die)
     size_t storage_bytes = 0;
@@ -170,6 +179,7 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
         for (int j = 0; j < dimensions; j++) {
             buf[i].dim[j] = tuple_buffers[i]->dim[j];
         }
+        size_in_bytes += buf[i].size_in_bytes();
     }
 
     has_eviction_key = has_eviction_key_arg;
@@ -185,42 +195,78 @@ WEAK void CacheEntry::destroy() {
     halide_free(nullptr, metadata_storage);
 }
 
-WEAK uint32_t djb_hash(const uint8_t *key, size_t key_size) {
-    uint32_t h = 5381;
-    for (size_t i = 0; i < key_size; i++) {
-        h = (h << 5) + h + key[i];
-    }
-    return h;
+// A multiplicative hash that consumes the key eight bytes at a time,
+// followed by the 64-bit finalizer from MurmurHash3.
+WEAK uint32_t hash_key(const uint8_t *key, size_t key_size) {
+    const uint64_t m = 0x9e3779b97f4a7c15ULL;
+    uint64_t h = key_size * m;
+    size_t i = 0;
+    for (; i + 8 <= key_size; i += 8) {
+        uint64_t k;
+        memcpy(&k, key + i, 8);
+        h = (h ^ k) * m;
+        h ^= h >> 32;
+    }
+    if (i < key_size) {
+        uint64_t k = 0;
+        memcpy(&k, key + i, key_size - i);
+        h = (h ^ k) * m;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (uint32_t)h;
 }
 
-WEAK halide_mutex memoization_lock = {{0}};
-
+// The cache is split into shards, each with its own lock, hash table and
+// recency list, so that concurrent pipelines looking up different keys
+// rarely contend. The size budget is global: whenever the total size
+// exceeds it, each shard nominates its best victim under the eviction
+// policy and the best of those is evicted.
+const size_t kNumShards = 16;
 const size_t kHashTableSize = 256;
 
-WEAK CacheEntry *cache_entries[kHashTableSize];
+struct CacheShard {
+    halide_mutex lock;
+    CacheEntry *entries[kHashTableSize];
+    CacheEntry *most_recently_used;
+    CacheEntry *least_recently_used;
+    int64_t entry_count;
+    uint64_t hits, misses, evictions;
+};
+
+WEAK CacheShard cache_shards[kNumShards];
 
-WEAK CacheEntry *most_recently_used = nullptr;
-WEAK CacheEntry *least_recently_used = nullptr;
+ALWAYS_INLINE CacheShard &shard_for_hash(uint32_t h) {
+    return cache_shards[h % kNumShards];
+}
+
+ALWAYS_INLINE CacheEntry *&bucket_for_hash(CacheShard &shard, uint32_t h) {
+    return shard.entries[(h / kNumShards) % kHashTableSize];
+}
 
 const uint64_t kDefaultCacheSize = 1 << 20;
 WEAK int64_t max_cache_size = kDefaultCacheSize;
+// Updated atomically, as the shard locks don't cover it.
 WEAK int64_t current_cache_size = 0;
+// Stamps entries with a global order of use, as recency lists are per shard.
+WEAK uint64_t use_clock = 0;
+WEAK halide_memoization_cache_eviction_policy_t eviction_policy = halide_memoization_cache_evict_lru;
 
 #if CACHE_DEBUGGING
-WEAK void validate_cache() {
-    print(nullptr) << "validating cache, "
-                   << "current size " << current_cache_size
-                   << " of maximum " << max_cache_size << "\n";
+WEAK void validate_shard(CacheShard &shard) {
     int entries_in_hash_table = 0;
     for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
+        CacheEntry *entry = shard.entries[i];
         while (entry != nullptr) {
             entries_in_hash_table++;
-            if (entry->more_recent == nullptr && entry != most_recently_used) {
+            if (entry->more_recent == nullptr && entry != shard.most_recently_used) {
                 halide_print(nullptr, "cache invalid case 1\n");
                 __builtin_trap();
             }
-            if (entry->less_recent == nullptr && entry != least_recently_used) {
+            if (entry->less_recent == nullptr && entry != shard.least_recently_used) {
                 halide_print(nullptr, "cache invalid case 2\n");
                 __builtin_trap();
             }
@@ -228,13 +274,13 @@ WEAK void validate_cache() {
         }
     }
     int entries_from_mru = 0;
-    CacheEntry *mru_chain = most_recently_used;
+    CacheEntry *mru_chain = shard.most_recently_used;
     while (mru_chain != nullptr) {
         entries_from_mru++;
         mru_chain = mru_chain->less_recent;
     }
     int entries_from_lru = 0;
-    CacheEntry *lru_chain = least_recently_used;
+    CacheEntry *lru_chain = shard.least_recently_used;
     while (lru_chain != nullptr) {
         entries_from_lru++;
         lru_chain = lru_chain->more_recent;
@@ -250,69 +296,189 @@ WEAK void validate_cache() {
         halide_print(nullptr, "cache invalid case 4\n");
         __builtin_trap();
     }
-    if (current_cache_size < 0) {
+    if (entries_in_hash_table != shard.entry_count) {
+        halide_print(nullptr, "cache invalid case 5\n");
+        __builtin_trap();
+    }
+    if (__atomic_load_n(&current_cache_size, __ATOMIC_SEQ_CST) < 0) {
         halide_print(nullptr, "cache size is negative\n");
         __builtin_trap();
     }
 }
 #endif
 
-WEAK void prune_cache() {
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
-    CacheEntry *prune_candidate = least_recently_used;
-    while (current_cache_size > max_cache_size &&
-           prune_candidate != nullptr) {
-        CacheEntry *more_recent = prune_candidate->more_recent;
-
-        if (prune_candidate->in_use_count == 0) {
-            uint32_t h = prune_candidate->hash;
-            uint32_t index = h % kHashTableSize;
-
-            // Remove from hash table
-            CacheEntry *prev_hash_entry = cache_entries[index];
-            if (prev_hash_entry == prune_candidate) {
-                cache_entries[index] = prune_candidate->next;
-            } else {
-                while (prev_hash_entry != nullptr && prev_hash_entry->next != prune_candidate) {
-                    prev_hash_entry = prev_hash_entry->next;
-                }
-                halide_assert(nullptr, prev_hash_entry != nullptr);
-                prev_hash_entry->next = prune_candidate->next;
-            }
+// Move an entry to the most recently used end of its shard's list. Must
+// be called with the shard locked.
+WEAK void mark_most_recently_used(CacheShard &shard, CacheEntry *entry) {
+    if (entry == shard.most_recently_used) {
+        return;
+    }
+    halide_assert(nullptr, entry->more_recent != nullptr);
+    if (entry->less_recent != nullptr) {
+        entry->less_recent->more_recent = entry->more_recent;
+    } else {
+        halide_assert(nullptr, shard.least_recently_used == entry);
+        shard.least_recently_used = entry->more_recent;
+    }
+    entry->more_recent->less_recent = entry->less_recent;
 
-            // Remove from less recent chain.
-            if (least_recently_used == prune_candidate) {
-                least_recently_used = more_recent;
-            }
-            if (more_recent != nullptr) {
-                more_recent->less_recent = prune_candidate->less_recent;
-            }
+    entry->more_recent = nullptr;
+    entry->less_recent = shard.most_recently_used;
+    if (shard.most_recently_used != nullptr) {
+        shard.most_recently_used->more_recent = entry;
+    }
+    shard.most_recently_used = entry;
+}
 
-            // Remove from more recent chain.
-            if (most_recently_used == prune_candidate) {
-                most_recently_used = prune_candidate->less_recent;
-            }
-            if (prune_candidate->less_recent != nullptr) {
-                prune_candidate->less_recent = more_recent;
-            }
+// Unlink an entry from its shard's hash table and recency list, and
+// free it. Must be called with the shard locked.
+WEAK void remove_entry(CacheShard &shard, CacheEntry *entry) {
+    CacheEntry **prev = &bucket_for_hash(shard, entry->hash);
+    while (*prev != entry) {
+        halide_assert(nullptr, *prev != nullptr);
+        prev = &(*prev)->next;
+    }
+    *prev = entry->next;
 
-            // Decrease cache used amount.
-            for (uint32_t i = 0; i < prune_candidate->tuple_count; i++) {
-                current_cache_size -= prune_candidate->buf[i].size_in_bytes();
-            }
+    if (entry->more_recent != nullptr) {
+        entry->more_recent->less_recent = entry->less_recent;
+    } else {
+        shard.most_recently_used = entry->less_recent;
+    }
+    if (entry->less_recent != nullptr) {
+        entry->less_recent->more_recent = entry->more_recent;
+    } else {
+        shard.least_recently_used = entry->more_recent;
+    }
+
+    shard.entry_count--;
+    __atomic_sub_fetch(&current_cache_size, (int64_t)entry->size_in_bytes, __ATOMIC_SEQ_CST);
 
-            // Deallocate the entry.
-            prune_candidate->destroy();
-            halide_free(nullptr, prune_candidate);
+    entry->destroy();
+    halide_free(nullptr, entry);
+}
+
+// The properties of an entry the eviction policies look at. Copied out
+// of the entry so candidates from different shards can be compared
+// without holding both shard locks.
+struct EvictionRank {
+    uint64_t hit_count;
+    uint64_t size_in_bytes;
+    uint64_t last_use;
+};
+
+ALWAYS_INLINE EvictionRank eviction_rank(const CacheEntry *entry) {
+    return {entry->hit_count, entry->size_in_bytes, entry->last_use};
+}
+
+// Returns true if an entry ranked a should be evicted before one ranked
+// b. Ties are broken in favor of evicting the least recently used entry.
+WEAK bool evict_before(const EvictionRank &a, const EvictionRank &b) {
+    switch (eviction_policy) {
+    case halide_memoization_cache_evict_lfu:
+        if (a.hit_count != b.hit_count) {
+            return a.hit_count < b.hit_count;
+        }
+        break;
+    case halide_memoization_cache_evict_size_aware: {
+        // Evict the entry with the fewest hits per byte, i.e. the one
+        // whose loss costs the fewest future hits for the amount of
+        // memory it frees.
+        uint64_t a_score = (a.hit_count + 1) * b.size_in_bytes;
+        uint64_t b_score = (b.hit_count + 1) * a.size_in_bytes;
+        if (a_score != b_score) {
+            return a_score < b_score;
         }
+        break;
+    }
+    default:
+        break;
+    }
+    return a.last_use < b.last_use;
+}
 
-        prune_candidate = more_recent;
+// Pick the entry to evict next from a shard, or nullptr if every entry
+// is in use. Must be called with the shard locked.
+WEAK CacheEntry *choose_victim(CacheShard &shard) {
+    CacheEntry *victim = nullptr;
+    for (CacheEntry *entry = shard.least_recently_used; entry != nullptr; entry = entry->more_recent) {
+        if (entry->in_use_count != 0) {
+            continue;
+        }
+        if (victim == nullptr) {
+            victim = entry;
+            if (eviction_policy == halide_memoization_cache_evict_lru) {
+                break;
+            }
+        } else if (evict_before(eviction_rank(entry), eviction_rank(victim))) {
+            victim = entry;
+        }
     }
+    return victim;
+}
+
+// Evict entries until the cache fits in its budget. Takes the shard locks
+// one at a time, so must be called with no shard locked. Other threads
+// may use the cache between choosing the shard to evict from and
+// evicting from it, so the choice is approximate under contention.
+WEAK void prune_cache() {
+    while (__atomic_load_n(&current_cache_size, __ATOMIC_SEQ_CST) > max_cache_size) {
+        int best_shard = -1;
+        EvictionRank best_rank = {0, 0, 0};
+        for (size_t i = 0; i < kNumShards; i++) {
+            CacheShard &shard = cache_shards[i];
+            ScopedMutexLock lock(&shard.lock);
+            CacheEntry *victim = choose_victim(shard);
+            if (victim != nullptr &&
+                (best_shard < 0 || evict_before(eviction_rank(victim), best_rank))) {
+                best_shard = (int)i;
+                best_rank = eviction_rank(victim);
+            }
+        }
+        if (best_shard < 0) {
+            // Everything left is in use.
+            return;
+        }
+
+        CacheShard &shard = cache_shards[best_shard];
+        ScopedMutexLock lock(&shard.lock);
+        if (__atomic_load_n(&current_cache_size, __ATOMIC_SEQ_CST) <= max_cache_size) {
+            return;
+        }
+        CacheEntry *victim = choose_victim(shard);
+        if (victim != nullptr) {
+            remove_entry(shard, victim);
+            shard.evictions++;
+        }
 #if CACHE_DEBUGGING
-    validate_cache();
+        validate_shard(shard);
 #endif
+    }
+}
+
+// Find a matching entry in a shard. Must be called with the shard locked.
+WEAK CacheEntry *find_entry(CacheShard &shard, uint32_t h, const uint8_t *cache_key, int32_t size,
+                            const halide_buffer_t *computed_bounds,
+                            int32_t tuple_count, halide_buffer_t **tuple_buffers) {
+    CacheEntry *entry = bucket_for_hash(shard, h);
+    while (entry != nullptr) {
+        if (entry->hash == h && entry->key_size == (size_t)size &&
+            keys_equal(entry->key, cache_key, size) &&
+            buffer_has_shape(computed_bounds, entry->computed_bounds) &&
+            entry->tuple_count == (uint32_t)tuple_count) {
+
+            // Check all the tuple buffers have the same bounds (they should).
+            bool all_bounds_equal = true;
+            for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
+                all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
+            }
+            if (all_bounds_equal) {
+                return entry;
+            }
+        }
+        entry = entry->next;
+    }
+    return nullptr;
 }
 
 }  // namespace Internal
@@ -326,18 +492,43 @@ WEAK void halide_memoization_cache_set_size(int64_t size) {
         size = kDefaultCacheSize;
     }
 
-    ScopedMutexLock lock(&memoization_lock);
-
-    max_cache_size = size;
+    __atomic_store_n(&max_cache_size, size, __ATOMIC_SEQ_CST);
     prune_cache();
 }
 
+WEAK void halide_memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy) {
+    // The shard locks are all taken in turn, so that no shard is in the
+    // middle of choosing a victim under the old policy when this returns.
+    for (size_t i = 0; i < kNumShards; i++) {
+        halide_mutex_lock(&cache_shards[i].lock);
+    }
+    eviction_policy = policy;
+    for (size_t i = 0; i < kNumShards; i++) {
+        halide_mutex_unlock(&cache_shards[i].lock);
+    }
+}
+
+WEAK void halide_memoization_cache_get_stats(halide_memoization_cache_stats_t *stats) {
+    stats->hits = 0;
+    stats->misses = 0;
+    stats->evictions = 0;
+    stats->entries = 0;
+    for (size_t i = 0; i < kNumShards; i++) {
+        CacheShard &shard = cache_shards[i];
+        ScopedMutexLock lock(&shard.lock);
+        stats->hits += shard.hits;
+        stats->misses += shard.misses;
+        stats->evictions += shard.evictions;
+        stats->entries += shard.entry_count;
+    }
+    stats->current_size = __atomic_load_n(&current_cache_size, __ATOMIC_SEQ_CST);
+    stats->max_size = __atomic_load_n(&max_cache_size, __ATOMIC_SEQ_CST);
+}
+
 WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
                                          halide_buffer_t *computed_bounds, int32_t tuple_count, halide_buffer_t **tuple_buffers) {
-    uint32_t h = djb_hash(cache_key, size);
-    uint32_t index = h % kHashTableSize;
-
-    ScopedMutexLock lock(&memoization_lock);
+    uint32_t h = hash_key(cache_key, size);
+    CacheShard &shard = shard_for_hash(h);
 
 #if CACHE_DEBUGGING
     debug_print_key(user_context, "halide_memoization_cache_lookup", cache_key, size);
@@ -352,50 +543,27 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
     }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
-    while (entry != nullptr) {
-        if (entry->hash == h && entry->key_size == (size_t)size &&
-            keys_equal(entry->key, cache_key, size) &&
-            buffer_has_shape(computed_bounds, entry->computed_bounds) &&
-            entry->tuple_count == (uint32_t)tuple_count) {
-
-            // Check all the tuple buffers have the same bounds (they should).
-            bool all_bounds_equal = true;
-            for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
-                all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
-            }
+    {
+        ScopedMutexLock lock(&shard.lock);
 
-            if (all_bounds_equal) {
-                if (entry != most_recently_used) {
-                    halide_assert(user_context, entry->more_recent != nullptr);
-                    if (entry->less_recent != nullptr) {
-                        entry->less_recent->more_recent = entry->more_recent;
-                    } else {
-                        halide_assert(user_context, least_recently_used == entry);
-                        least_recently_used = entry->more_recent;
-                    }
-                    halide_assert(user_context, entry->more_recent != nullptr);
-                    entry->more_recent->less_recent = entry->less_recent;
-
-                    entry->more_recent = nullptr;
-                    entry->less_recent = most_recently_used;
-                    if (most_recently_used != nullptr) {
-                        most_recently_used->more_recent = entry;
-                    }
-                    most_recently_used = entry;
-                }
+        CacheEntry *entry = find_entry(shard, h, cache_key, size, computed_bounds, tuple_count, tuple_buffers);
+        if (entry != nullptr) {
+            mark_most_recently_used(shard, entry);
 
-                for (int32_t i = 0; i < tuple_count; i++) {
-                    halide_buffer_t *buf = tuple_buffers[i];
-                    *buf = entry->buf[i];
-                }
+            for (int32_t i = 0; i < tuple_count; i++) {
+                halide_buffer_t *buf = tuple_buffers[i];
+                *buf = entry->buf[i];
+            }
 
-                entry->in_use_count += tuple_count;
+            entry->in_use_count += tuple_count;
+            entry->hit_count++;
+            entry->last_use = __atomic_add_fetch(&use_clock, 1, __ATOMIC_RELAXED);
+            shard.hits++;
 
-                return 0;
-            }
+            return 0;
         }
-        entry = entry->next;
+
+        shard.misses++;
     }
 
     for (int32_t i = 0; i < tuple_count; i++) {
@@ -415,10 +583,6 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
         header->entry = nullptr;
     }
 
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
-
     return 1;
 }
 
@@ -429,10 +593,7 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
     debug(user_context) << "halide_memoization_cache_store has_eviction_key: " << has_eviction_key << " eviction_key " << eviction_key << " .\n";
 
     uint32_t h = get_pointer_to_header(tuple_buffers[0]->host)->hash;
-
-    uint32_t index = h % kHashTableSize;
-
-    ScopedMutexLock lock(&memoization_lock);
+    CacheShard &shard = shard_for_hash(h);
 
 #if CACHE_DEBUGGING
     debug_print_key(user_context, "halide_memoization_cache_store", cache_key, size);
@@ -447,88 +608,72 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
     }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
-    while (entry != nullptr) {
-        if (entry->hash == h && entry->key_size == (size_t)size &&
-            keys_equal(entry->key, cache_key, size) &&
-            buffer_has_shape(computed_bounds, entry->computed_bounds) &&
-            entry->tuple_count == (uint32_t)tuple_count) {
+    {
+        ScopedMutexLock lock(&shard.lock);
 
-            bool all_bounds_equal = true;
-            bool no_host_pointers_equal = true;
-            {
-                for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
-                    halide_buffer_t *buf = tuple_buffers[i];
-                    all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
-                    if (entry->buf[i].host == buf->host) {
-                        no_host_pointers_equal = false;
-                    }
-                }
+        CacheEntry *entry = find_entry(shard, h, cache_key, size, computed_bounds, tuple_count, tuple_buffers);
+        if (entry != nullptr) {
+            for (int32_t i = 0; i < tuple_count; i++) {
+                halide_assert(user_context, entry->buf[i].host != tuple_buffers[i]->host);
             }
-            if (all_bounds_equal) {
-                halide_assert(user_context, no_host_pointers_equal);
-                // This entry is still in use by the caller. Mark it as having no cache entry
-                // so halide_memoization_cache_release can free the buffer.
-                for (int32_t i = 0; i < tuple_count; i++) {
-                    get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
-                }
-                return 0;
+            // This entry is still in use by the caller. Mark it as having no cache entry
+            // so halide_memoization_cache_release can free the buffer.
+            for (int32_t i = 0; i < tuple_count; i++) {
+                get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
             }
+            return 0;
         }
-        entry = entry->next;
-    }
 
-    uint64_t added_size = 0;
-    {
-        for (int32_t i = 0; i < tuple_count; i++) {
-            halide_buffer_t *buf = tuple_buffers[i];
-            added_size += buf->size_in_bytes();
+        CacheEntry *new_entry = (CacheEntry *)halide_malloc(nullptr, sizeof(CacheEntry));
+        bool inited = false;
+        if (new_entry) {
+            inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers,
+                                     has_eviction_key, eviction_key);
         }
-    }
-    current_cache_size += added_size;
-    prune_cache();
-
-    CacheEntry *new_entry = (CacheEntry *)halide_malloc(nullptr, sizeof(CacheEntry));
-    bool inited = false;
-    if (new_entry) {
-        inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers,
-                                 has_eviction_key, eviction_key);
-    }
-    if (!inited) {
-        current_cache_size -= added_size;
+        if (!inited) {
+            // This entry is still in use by the caller. Mark it as having no cache entry
+            // so halide_memoization_cache_release can free the buffer.
+            for (int32_t i = 0; i < tuple_count; i++) {
+                get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+            }
 
-        // This entry is still in use by the caller. Mark it as having no cache entry
-        // so halide_memoization_cache_release can free the buffer.
-        for (int32_t i = 0; i < tuple_count; i++) {
-            get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+            if (new_entry) {
+                halide_free(user_context, new_entry);
+            }
+            return 0;
         }
 
-        if (new_entry) {
-            halide_free(user_context, new_entry);
+        CacheEntry *&bucket = bucket_for_hash(shard, h);
+        new_entry->next = bucket;
+        bucket = new_entry;
+        new_entry->less_recent = shard.most_recently_used;
+        if (shard.most_recently_used != nullptr) {
+            shard.most_recently_used->more_recent = new_entry;
         }
-        return 0;
-    }
+        shard.most_recently_used = new_entry;
+        if (shard.least_recently_used == nullptr) {
+            shard.least_recently_used = new_entry;
+        }
+        shard.entry_count++;
 
-    new_entry->next = cache_entries[index];
-    new_entry->less_recent = most_recently_used;
-    if (most_recently_used != nullptr) {
-        most_recently_used->more_recent = new_entry;
-    }
-    most_recently_used = new_entry;
-    if (least_recently_used == nullptr) {
-        least_recently_used = new_entry;
-    }
-    cache_entries[index] = new_entry;
+        // The new entry is in use until released, so it can't be chosen
+        // as a victim by the pruning below.
+        new_entry->in_use_count = tuple_count;
+        new_entry->last_use = __atomic_add_fetch(&use_clock, 1, __ATOMIC_RELAXED);
 
-    new_entry->in_use_count = tuple_count;
+        for (int32_t i = 0; i < tuple_count; i++) {
+            get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
+        }
 
-    for (int32_t i = 0; i < tuple_count; i++) {
-        get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
-    }
+        __atomic_add_fetch(&current_cache_size, (int64_t)new_entry->size_in_bytes, __ATOMIC_SEQ_CST);
 
 #if CACHE_DEBUGGING
-    validate_cache();
+        validate_shard(shard);
 #endif
+    }
+
+    prune_cache();
+
     debug(user_context) << "Exiting halide_memoization_cache_store\n";
 
     return 0;
@@ -542,12 +687,13 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
     if (entry == nullptr) {
         halide_free(user_context, header);
     } else {
-        ScopedMutexLock lock(&memoization_lock);
+        CacheShard &shard = shard_for_hash(entry->hash);
+        ScopedMutexLock lock(&shard.lock);
 
         halide_assert(user_context, entry->in_use_count > 0);
         entry->in_use_count--;
 #if CACHE_DEBUGGING
-        validate_cache();
+        validate_shard(shard);
 #endif
     }
 
@@ -556,54 +702,47 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
 
 WEAK void halide_memoization_cache_cleanup() {
     debug(nullptr) << "halide_memoization_cache_cleanup\n";
-    for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
-        cache_entries[i] = nullptr;
-        while (entry != nullptr) {
-            CacheEntry *next = entry->next;
-            entry->destroy();
-            halide_free(nullptr, entry);
-            entry = next;
+    for (size_t s = 0; s < kNumShards; s++) {
+        CacheShard &shard = cache_shards[s];
+        for (size_t i = 0; i < kHashTableSize; i++) {
+            CacheEntry *entry = shard.entries[i];
+            shard.entries[i] = nullptr;
+            while (entry != nullptr) {
+                CacheEntry *next = entry->next;
+                entry->destroy();
+                halide_free(nullptr, entry);
+                entry = next;
+            }
         }
+        shard.most_recently_used = nullptr;
+        shard.least_recently_used = nullptr;
+        shard.entry_count = 0;
+        shard.hits = 0;
+        shard.misses = 0;
+        shard.evictions = 0;
     }
     current_cache_size = 0;
-    most_recently_used = nullptr;
-    least_recently_used = nullptr;
 }
 
 WEAK void halide_memoization_cache_evict(void *user_context, uint64_t eviction_key) {
-    ScopedMutexLock lock(&memoization_lock);
+    for (size_t s = 0; s < kNumShards; s++) {
+        CacheShard &shard = cache_shards[s];
+        ScopedMutexLock lock(&shard.lock);
 
-    for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
-        if (entry != nullptr) {
-            CacheEntry **prev = &cache_entries[i];
+        for (size_t i = 0; i < kHashTableSize; i++) {
+            CacheEntry *entry = shard.entries[i];
             while (entry != nullptr) {
                 CacheEntry *next = entry->next;
                 if (entry->has_eviction_key && entry->eviction_key == eviction_key) {
-                    *prev = next;
-                    if (entry->more_recent != nullptr) {
-                        entry->more_recent->less_recent = entry->less_recent;
-                    } else {
-                        most_recently_used = entry->less_recent;
-                    }
-                    if (entry->less_recent != nullptr) {
-                        entry->less_recent->more_recent = entry->more_recent;
-                    } else {
-                        least_recently_used = entry->more_recent;
-                    }
-                    entry->destroy();
-                    halide_free(user_context, entry);
-                } else {
-                    prev = &entry->next;
+                    remove_entry(shard, entry);
                 }
                 entry = next;
             }
         }
-    }
 #if CACHE_DEBUGGING
-    validate_cache();
+        validate_shard(shard);
 #endif
+    }
 }
 
 namespace {
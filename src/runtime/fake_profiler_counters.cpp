@@ -0,0 +1,19 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+WEAK int halide_profiler_open_hardware_counters() {
+    // Hardware counters are not available on this platform.
+    return halide_error_code_generic_error;
+}
+
+WEAK void halide_profiler_read_hardware_counters(uint64_t *values) {
+    for (int i = 0; i < 4; i++) {
+        values[i] = 0;
+    }
+}
+
+WEAK void halide_profiler_close_hardware_counters() {
+}
+}
@@ -0,0 +1,132 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+// Hardware performance counters for the sampling profiler, read through
+// the Linux perf_event interface.
+
+extern "C" {
+
+extern int syscall(int num, ...);
+extern ssize_t read(int fd, void *buf, size_t count);
+
+// The syscall number for perf_event_open varies across platforms:
+// -- i386 is 336
+// -- x64 is 298
+
+#ifndef SYS_PERF_EVENT_OPEN
+
+#ifdef BITS_64
+#define SYS_PERF_EVENT_OPEN 298
+#endif
+
+#ifdef BITS_32
+#define SYS_PERF_EVENT_OPEN 336
+#endif
+
+#endif
+}
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// The leading fields of struct perf_event_attr from
+// linux/perf_event.h. The kernel accepts this, the original version of
+// the struct, as long as the size field says so.
+struct perf_event_attr_v0 {
+    uint32_t type;
+    uint32_t size;
+    uint64_t config;
+    uint64_t sample_period;
+    uint64_t sample_type;
+    uint64_t read_format;
+    uint64_t flags;
+    uint32_t wakeup_events;
+    uint32_t bp_type;
+    uint64_t config1;
+};
+
+#define PERF_TYPE_HARDWARE 0
+#define PERF_COUNT_HW_CPU_CYCLES 0
+#define PERF_COUNT_HW_INSTRUCTIONS 1
+#define PERF_COUNT_HW_CACHE_MISSES 3
+#define PERF_COUNT_HW_BRANCH_MISSES 5
+
+#define PERF_FORMAT_TOTAL_TIME_ENABLED 1
+#define PERF_FORMAT_TOTAL_TIME_RUNNING 2
+
+// Bits of perf_event_attr_v0::flags.
+#define PERF_ATTR_FLAG_INHERIT (1 << 1)
+#define PERF_ATTR_FLAG_EXCLUDE_KERNEL (1 << 5)
+#define PERF_ATTR_FLAG_EXCLUDE_HV (1 << 6)
+
+// In the order the profiler expects them: cycles, instructions,
+// last-level cache misses, and branch misses.
+const int num_hardware_counters = 4;
+const uint64_t hardware_counter_configs[num_hardware_counters] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES};
+
+WEAK int hardware_counter_fds[num_hardware_counters] = {-1, -1, -1, -1};
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+extern "C" {
+
+WEAK int halide_profiler_open_hardware_counters() {
+    for (int i = 0; i < num_hardware_counters; i++) {
+        perf_event_attr_v0 attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = hardware_counter_configs[i];
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // Count user-space events on this thread and on every thread
+        // it or its descendants go on to create. Reading the counter
+        // sums over all of them. Excluding the kernel lets unprivileged
+        // processes open the counters under the default
+        // perf_event_paranoid setting.
+        attr.flags = PERF_ATTR_FLAG_INHERIT | PERF_ATTR_FLAG_EXCLUDE_KERNEL | PERF_ATTR_FLAG_EXCLUDE_HV;
+        // pid 0 and cpu -1 mean the calling thread, on any cpu.
+        int fd = syscall(SYS_PERF_EVENT_OPEN, &attr, 0, -1, -1, 0);
+        if (fd < 0) {
+            halide_profiler_close_hardware_counters();
+            return halide_error_code_generic_error;
+        }
+        hardware_counter_fds[i] = fd;
+    }
+    return 0;
+}
+
+WEAK void halide_profiler_read_hardware_counters(uint64_t *values) {
+    for (int i = 0; i < num_hardware_counters; i++) {
+        // The count, followed by how long the counter was enabled and
+        // how long it was actually counting. They differ when there are
+        // more counters than the hardware can count at once and the
+        // kernel time-slices between them, in which case the count is
+        // scaled up to estimate the full total.
+        uint64_t buf[3] = {0, 0, 0};
+        if (hardware_counter_fds[i] < 0 ||
+            read(hardware_counter_fds[i], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) {
+            values[i] = 0;
+        } else if (buf[2] == 0 || buf[2] >= buf[1]) {
+            values[i] = buf[0];
+        } else {
+            values[i] = (uint64_t)((double)buf[0] * buf[1] / buf[2]);
+        }
+    }
+}
+
+WEAK void halide_profiler_close_hardware_counters() {
+    for (int i = 0; i < num_hardware_counters; i++) {
+        if (hardware_counter_fds[i] >= 0) {
+            close(hardware_counter_fds[i]);
+            hardware_counter_fds[i] = -1;
+        }
+    }
+}
+}
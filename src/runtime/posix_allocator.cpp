@@ -2,13 +2,158 @@
 #include "runtime_internal.h"
 
 #include "printer.h"
+#include "scoped_mutex_lock.h"
 
 extern "C" {
 
 extern void *malloc(size_t);
 extern void free(void *);
+}
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// Every block handed out by halide_default_malloc stores two words just
+// before the pointer returned: the pointer returned by malloc, and the
+// size class plus one if the block belongs to the host allocation pool,
+// or zero if it does not.
+WEAK void *aligned_block(void *orig, size_t size_class_tag) {
+    const size_t alignment = halide_malloc_alignment();
+    void *ptr = (void *)(((size_t)orig + alignment + 2 * sizeof(void *) - 1) & ~(alignment - 1));
+    ((void **)ptr)[-1] = orig;
+    ((size_t *)ptr)[-2] = size_class_tag;
+    return ptr;
+}
+
+// The host allocation pool. Freed blocks are kept on free lists, one per
+// size class, instead of being returned to the system, and are handed out
+// again by later mallocs of the same size class. Size classes are spaced
+// four to a power of two, so at most a quarter of each block is wasted.
+//
+// The free lists are split into stripes, each with its own lock. A thread
+// uses the stripe selected by the address of its stack, which keeps a
+// thread on the same stripe from one call to the next without needing
+// thread-local storage, and spreads the threads of a parallel loop across
+// the stripes so they rarely contend.
+WEAK bool halide_reuse_host_allocations_flag = false;
+
+const size_t kMinPooledSize = 64;
+const size_t kMaxPooledSize = 16 * 1024 * 1024;
+// One class for kMinPooledSize, then four per power of two up to
+// kMaxPooledSize.
+const int kNumSizeClasses = 1 + 4 * (24 - 6);
+const int kNumStripes = 8;
+// The most memory a stripe holds on to. Blocks freed beyond this go
+// straight back to the system.
+const size_t kMaxCachedBytesPerStripe = 16 * 1024 * 1024;
+
+struct HostPoolStripe {
+    halide_mutex lock;
+    void *free_lists[kNumSizeClasses];
+    size_t cached_bytes;
+    // Keep stripes on separate cache lines.
+    char padding[64];
+};
+
+WEAK HostPoolStripe host_pool_stripes[kNumStripes];
+
+ALWAYS_INLINE int size_class_index(size_t size) {
+    if (size <= kMinPooledSize) {
+        return 0;
+    }
+    // size is in (2^p, 2^(p+1)], and the classes within that range are
+    // 2^p plus k quarters of 2^p, for k = 1 to 4.
+    int p = 63 - __builtin_clzll((uint64_t)(size - 1));
+    size_t k = (size - ((size_t)1 << p) + ((size_t)1 << (p - 2)) - 1) >> (p - 2);
+    return 1 + (p - 6) * 4 + (int)(k - 1);
+}
+
+ALWAYS_INLINE size_t size_class_bytes(int index) {
+    if (index == 0) {
+        return kMinPooledSize;
+    }
+    int p = (index - 1) / 4 + 6;
+    size_t k = (index - 1) % 4 + 1;
+    return ((size_t)1 << p) + k * ((size_t)1 << (p - 2));
+}
+
+ALWAYS_INLINE HostPoolStripe &current_stripe() {
+    int local;
+    // Threads' stacks are far enough apart that dropping the low bits
+    // separates them, while calls at different depths on one thread's
+    // stack usually land on the same stripe.
+    uint64_t h = ((uint64_t)(size_t)&local >> 16) * 0x9e3779b97f4a7c15ULL;
+    return host_pool_stripes[(h >> 32) % kNumStripes];
+}
+
+WEAK void *host_pool_malloc(size_t x) {
+    int index = size_class_index(x);
+    HostPoolStripe &stripe = current_stripe();
+    {
+        ScopedMutexLock lock(&stripe.lock);
+        void *ptr = stripe.free_lists[index];
+        if (ptr != nullptr) {
+            stripe.free_lists[index] = *(void **)ptr;
+            stripe.cached_bytes -= size_class_bytes(index);
+            return ptr;
+        }
+    }
+
+    void *orig = malloc(size_class_bytes(index) + halide_malloc_alignment());
+    if (orig == nullptr) {
+        return nullptr;
+    }
+    return aligned_block(orig, index + 1);
+}
+
+WEAK void host_pool_free(void *user_context, void *ptr, int index) {
+    if (halide_can_reuse_host_allocations(user_context)) {
+        size_t bytes = size_class_bytes(index);
+        HostPoolStripe &stripe = current_stripe();
+        ScopedMutexLock lock(&stripe.lock);
+        if (stripe.cached_bytes + bytes <= kMaxCachedBytesPerStripe) {
+            *(void **)ptr = stripe.free_lists[index];
+            stripe.free_lists[index] = ptr;
+            stripe.cached_bytes += bytes;
+            return;
+        }
+    }
+    free(((void **)ptr)[-1]);
+}
+
+WEAK void host_pool_release_unused() {
+    for (int i = 0; i < kNumStripes; i++) {
+        HostPoolStripe &stripe = host_pool_stripes[i];
+        ScopedMutexLock lock(&stripe.lock);
+        for (int j = 0; j < kNumSizeClasses; j++) {
+            void *ptr = stripe.free_lists[j];
+            while (ptr != nullptr) {
+                void *next = *(void **)ptr;
+                free(((void **)ptr)[-1]);
+                ptr = next;
+            }
+            stripe.free_lists[j] = nullptr;
+        }
+        stripe.cached_bytes = 0;
+    }
+}
+
+WEAK __attribute__((destructor)) void halide_host_pool_cleanup() {
+    host_pool_release_unused();
+}
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+extern "C" {
 
 WEAK void *halide_default_malloc(void *user_context, size_t x) {
+    if (x <= kMaxPooledSize && halide_can_reuse_host_allocations(user_context)) {
+        return host_pool_malloc(x);
+    }
+
     // Allocate enough space for aligning the pointer we return.
     const size_t alignment = halide_malloc_alignment();
     void *orig = malloc(x + alignment);
@@ -17,13 +162,28 @@ WEAK void *halide_default_malloc(void *user_context, size_t x) {
         return nullptr;
     }
     // We want to store the original pointer prior to the pointer we return.
-    void *ptr = (void *)(((size_t)orig + alignment + sizeof(void *) - 1) & ~(alignment - 1));
-    ((void **)ptr)[-1] = orig;
-    return ptr;
+    return aligned_block(orig, 0);
 }
 
 WEAK void halide_default_free(void *user_context, void *ptr) {
-    free(((void **)ptr)[-1]);
+    size_t size_class_tag = ((size_t *)ptr)[-2];
+    if (size_class_tag != 0) {
+        host_pool_free(user_context, ptr, (int)(size_class_tag - 1));
+    } else {
+        free(((void **)ptr)[-1]);
+    }
+}
+
+WEAK int halide_reuse_host_allocations(void *user_context, bool flag) {
+    halide_reuse_host_allocations_flag = flag;
+    if (!flag) {
+        host_pool_release_unused();
+    }
+    return 0;
+}
+
+WEAK bool halide_can_reuse_host_allocations(void *user_context) {
+    return halide_reuse_host_allocations_flag;
 }
 }
 
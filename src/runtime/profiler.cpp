@@ -18,6 +18,91 @@ namespace Halide {
 namespace Runtime {
 namespace Internal {
 
+// Whether the hardware counters have been opened (1), could not be
+// opened (-1), or have not been asked for yet (0). Guarded by the
+// profiler state's lock, as are the values the counters had when the
+// sampling thread last read them.
+WEAK int hardware_counters_status = 0;
+WEAK uint64_t hardware_counters_last[4];
+
+// An optional timeline of what the sampling thread saw, written out by
+// halide_profiler_export. A sample is appended whenever the running
+// Func, the number of active threads, or the heap memory in use
+// changes between ticks, along with an event for each pipeline start
+// and end so the timeline can be split into invocations. Guarded by
+// the profiler state's lock.
+enum TimelineEventKind {
+    timeline_sample = 0,
+    timeline_pipeline_start = 1,
+    timeline_pipeline_end = 2,
+};
+
+struct TimelineEvent {
+    // Nanoseconds since halide_start_clock.
+    uint64_t time;
+    // For samples, the heap memory in use by the running Func's pipeline.
+    uint64_t memory;
+    // For samples, the id of the running Func, or
+    // halide_profiler_outside_of_halide. For pipeline starts, the first
+    // func id of the pipeline. For pipeline ends, the last Func the
+    // pipeline ran, which identifies the pipeline.
+    int32_t id;
+    int16_t kind;
+    int16_t active_threads;
+};
+
+// Caps the timeline at 24MB. Later events are dropped and counted.
+const int kMaxTimelineEvents = 1 << 20;
+
+WEAK bool timeline_enabled = false;
+WEAK TimelineEvent *timeline_events = nullptr;
+WEAK int timeline_size = 0, timeline_capacity = 0;
+WEAK uint64_t timeline_dropped = 0;
+// The last sample appended, used to skip samples that change nothing.
+// Its kind is set to something other than timeline_sample at each
+// pipeline start or end, so that the next sample is always recorded.
+WEAK TimelineEvent timeline_last_sample;
+
+WEAK void timeline_append(int kind, int id, int active_threads, uint64_t memory) {
+    if (timeline_size == timeline_capacity) {
+        int new_capacity = timeline_capacity ? timeline_capacity * 2 : 1024;
+        TimelineEvent *new_events = nullptr;
+        if (timeline_capacity < kMaxTimelineEvents) {
+            new_events = (TimelineEvent *)malloc(new_capacity * sizeof(TimelineEvent));
+        }
+        if (!new_events) {
+            timeline_dropped++;
+            return;
+        }
+        if (timeline_events) {
+            memcpy(new_events, timeline_events, timeline_size * sizeof(TimelineEvent));
+            free(timeline_events);
+        }
+        timeline_events = new_events;
+        timeline_capacity = new_capacity;
+    }
+    TimelineEvent *e = timeline_events + timeline_size++;
+    e->time = halide_current_time_ns(nullptr);
+    e->memory = memory;
+    e->id = id;
+    e->kind = (int16_t)kind;
+    e->active_threads = (int16_t)(active_threads < 32767 ? active_threads : 32767);
+    timeline_last_sample.kind = (int16_t)kind;
+}
+
+WEAK void timeline_sample_if_changed(halide_profiler_pipeline_stats *p, int func, int active_threads) {
+    uint64_t memory = p ? p->memory_current : 0;
+    if (timeline_last_sample.kind != timeline_sample ||
+        timeline_last_sample.id != func ||
+        timeline_last_sample.active_threads != active_threads ||
+        timeline_last_sample.memory != memory) {
+        timeline_append(timeline_sample, func, active_threads, memory);
+        timeline_last_sample.id = func;
+        timeline_last_sample.active_threads = (int16_t)active_threads;
+        timeline_last_sample.memory = memory;
+    }
+}
+
 WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipeline_name, int num_funcs, const uint64_t *func_names) {
     halide_profiler_state *s = halide_profiler_get_state();
 
@@ -49,6 +134,10 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
     p->num_allocs = 0;
     p->active_threads_numerator = 0;
     p->active_threads_denominator = 0;
+    p->cycles = 0;
+    p->instructions = 0;
+    p->llc_misses = 0;
+    p->branch_misses = 0;
     p->funcs = (halide_profiler_func_stats *)malloc(num_funcs * sizeof(halide_profiler_func_stats));
     if (!p->funcs) {
         free(p);
@@ -64,13 +153,17 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
         p->funcs[i].stack_peak = 0;
         p->funcs[i].active_threads_numerator = 0;
         p->funcs[i].active_threads_denominator = 0;
+        p->funcs[i].cycles = 0;
+        p->funcs[i].instructions = 0;
+        p->funcs[i].llc_misses = 0;
+        p->funcs[i].branch_misses = 0;
     }
     s->first_free_id += num_funcs;
     s->pipelines = p;
     return p;
 }
 
-WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int active_threads) {
+WEAK halide_profiler_pipeline_stats *bill_func(halide_profiler_state *s, int func_id, uint64_t time, int active_threads, const uint64_t *counters) {
     halide_profiler_pipeline_stats *p_prev = nullptr;
     for (halide_profiler_pipeline_stats *p = s->pipelines; p;
          p = (halide_profiler_pipeline_stats *)(p->next)) {
@@ -89,11 +182,22 @@ WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int ac
             p->samples++;
             p->active_threads_numerator += active_threads;
             p->active_threads_denominator += 1;
-            return;
+            if (counters) {
+                f->cycles += counters[0];
+                f->instructions += counters[1];
+                f->llc_misses += counters[2];
+                f->branch_misses += counters[3];
+                p->cycles += counters[0];
+                p->instructions += counters[1];
+                p->llc_misses += counters[2];
+                p->branch_misses += counters[3];
+            }
+            return p;
         }
         p_prev = p;
     }
     // Someone must have called reset_state while a kernel was running. Do nothing.
+    return nullptr;
 }
 
 WEAK void sampling_profiler_thread(void *) {
@@ -117,12 +221,29 @@ WEAK void sampling_profiler_thread(void *) {
                 active_threads = s->active_threads;
             }
             uint64_t t_now = halide_current_time_ns(nullptr);
+            uint64_t counter_deltas[4];
+            const uint64_t *counters = nullptr;
+            if (hardware_counters_status > 0) {
+                uint64_t counters_now[4];
+                halide_profiler_read_hardware_counters(counters_now);
+                for (int i = 0; i < 4; i++) {
+                    counter_deltas[i] = counters_now[i] - hardware_counters_last[i];
+                    hardware_counters_last[i] = counters_now[i];
+                }
+                counters = counter_deltas;
+            }
             if (func == halide_profiler_please_stop) {
                 break;
             } else if (func >= 0) {
-                // Assume all time since I was last awake is due to
-                // the currently running func.
-                bill_func(s, func, t_now - t, active_threads);
+                // Assume all time and hardware events since I was last
+                // awake are due to the currently running func.
+                halide_profiler_pipeline_stats *p =
+                    bill_func(s, func, t_now - t, active_threads, counters);
+                if (timeline_enabled) {
+                    timeline_sample_if_changed(p, func, active_threads);
+                }
+            } else if (timeline_enabled) {
+                timeline_sample_if_changed(nullptr, halide_profiler_outside_of_halide, 0);
             }
             t = t_now;
 
@@ -137,6 +258,308 @@ WEAK void sampling_profiler_thread(void *) {
     halide_mutex_unlock(&s->lock);
 }
 
+// Writes the output of halide_profiler_export to a file descriptor,
+// through a buffer.
+class ProfileExportWriter {
+    char buf[4096];
+    char *dst = buf;
+    char *const end = buf + sizeof(buf) - 1;
+    int fd;
+    bool failed = false;
+
+    void flush_if_half_full() {
+        if (dst - buf > (ssize_t)sizeof(buf) / 2) {
+            flush();
+        }
+    }
+
+public:
+    ProfileExportWriter(int fd)
+        : fd(fd) {
+    }
+
+    ProfileExportWriter &operator<<(const char *x) {
+        dst = halide_string_to_string(dst, end, x);
+        flush_if_half_full();
+        return *this;
+    }
+
+    ProfileExportWriter &operator<<(uint64_t x) {
+        dst = halide_uint64_to_string(dst, end, x, 1);
+        flush_if_half_full();
+        return *this;
+    }
+
+    ProfileExportWriter &operator<<(int x) {
+        dst = halide_int64_to_string(dst, end, x, 1);
+        flush_if_half_full();
+        return *this;
+    }
+
+    ProfileExportWriter &operator<<(float x) {
+        dst = halide_double_to_string(dst, end, x, 0);
+        flush_if_half_full();
+        return *this;
+    }
+
+    // Write a JSON string, escaping anything that needs it.
+    void string(const char *str) {
+        char escaped[256];
+        size_t n = 0;
+        *this << "\"";
+        for (const char *c = str; *c; c++) {
+            if (n + 8 > sizeof(escaped)) {
+                escaped[n] = 0;
+                *this << (const char *)escaped;
+                n = 0;
+            }
+            if (*c == '"' || *c == '\\') {
+                escaped[n++] = '\\';
+                escaped[n++] = *c;
+            } else if ((unsigned char)*c < 0x20) {
+                const char *hex = "0123456789abcdef";
+                memcpy(escaped + n, "\\u00", 4);
+                escaped[n + 4] = hex[(*c >> 4) & 0xf];
+                escaped[n + 5] = hex[*c & 0xf];
+                n += 6;
+            } else {
+                escaped[n++] = *c;
+            }
+        }
+        escaped[n] = 0;
+        *this << (const char *)escaped << "\"";
+    }
+
+    // Write a time in nanoseconds as microseconds, the unit of the
+    // Chrome trace event format, keeping the full precision.
+    void micros(uint64_t ns) {
+        char digits[32];
+        char *end = halide_uint64_to_string(digits, digits + sizeof(digits), ns / 1000, 1);
+        *end++ = '.';
+        halide_uint64_to_string(end, digits + sizeof(digits), ns % 1000, 3);
+        *this << (const char *)digits;
+    }
+
+    void flush() {
+        ssize_t size = dst - buf;
+        if (size && write(fd, buf, size) != size) {
+            failed = true;
+        }
+        dst = buf;
+    }
+
+    bool ok() const {
+        return !failed;
+    }
+};
+
+WEAK halide_profiler_pipeline_stats *pipeline_containing_func(halide_profiler_state *s, int func_id) {
+    for (halide_profiler_pipeline_stats *p = s->pipelines; p;
+         p = (halide_profiler_pipeline_stats *)(p->next)) {
+        if (func_id >= p->first_func_id && func_id < p->first_func_id + p->num_funcs) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+WEAK void export_counters(ProfileExportWriter &w, uint64_t cycles, uint64_t instructions,
+                          uint64_t llc_misses, uint64_t branch_misses) {
+    if (instructions) {
+        w << ", \"cycles\": " << cycles
+          << ", \"instructions\": " << instructions
+          << ", \"llc_misses\": " << llc_misses
+          << ", \"branch_misses\": " << branch_misses;
+    }
+}
+
+// Write the aggregate statistics of a pipeline and its Funcs as the
+// members of a JSON object.
+WEAK void export_pipeline_stats(ProfileExportWriter &w, halide_profiler_pipeline_stats *p) {
+    w << "\"name\": ";
+    w.string(p->name);
+    w << ", \"runs\": " << p->runs
+      << ", \"samples\": " << p->samples
+      << ", \"time_ns\": " << p->time
+      << ", \"average_threads\": "
+      << (float)(p->active_threads_numerator / (p->active_threads_denominator + 1e-10))
+      << ", \"num_allocs\": " << p->num_allocs
+      << ", \"memory_peak\": " << p->memory_peak
+      << ", \"memory_total\": " << p->memory_total;
+    export_counters(w, p->cycles, p->instructions, p->llc_misses, p->branch_misses);
+    w << ", \"funcs\": [";
+    for (int i = 0; i < p->num_funcs; i++) {
+        halide_profiler_func_stats *fs = p->funcs + i;
+        w << (i ? ",\n      {" : "\n      {") << "\"name\": ";
+        w.string(fs->name);
+        w << ", \"time_ns\": " << fs->time
+          << ", \"average_threads\": "
+          << (float)(fs->active_threads_numerator / (fs->active_threads_denominator + 1e-10))
+          << ", \"num_allocs\": " << fs->num_allocs
+          << ", \"memory_peak\": " << fs->memory_peak
+          << ", \"memory_total\": " << fs->memory_total
+          << ", \"stack_peak\": " << fs->stack_peak;
+        export_counters(w, fs->cycles, fs->instructions, fs->llc_misses, fs->branch_misses);
+        w << "}";
+    }
+    w << "]";
+}
+
+// Write the invocations of a pipeline found in the timeline as a JSON
+// array. Each invocation lists the Funcs seen running during it, split
+// into segments wherever the number of active threads or the heap
+// memory in use changed.
+WEAK void export_invocations(ProfileExportWriter &w, halide_profiler_state *s, halide_profiler_pipeline_stats *p) {
+    bool in_invocation = false, in_segment = false, first_invocation = true, first_segment = true;
+    uint64_t end_time = 0;
+    w << "[";
+    for (int i = 0; i < timeline_size; i++) {
+        const TimelineEvent &e = timeline_events[i];
+        end_time = e.time;
+        bool ours = e.id >= p->first_func_id && e.id < p->first_func_id + p->num_funcs;
+        if (in_segment) {
+            w << ", \"end_ns\": " << e.time << "}";
+            in_segment = false;
+        }
+        if (e.kind == timeline_pipeline_start && e.id == p->first_func_id) {
+            if (in_invocation) {
+                w << "], \"end_ns\": " << e.time << "}";
+            }
+            w << (first_invocation ? "\n      " : ",\n      ")
+              << "{\"start_ns\": " << e.time << ", \"timeline\": [";
+            in_invocation = true;
+            first_invocation = false;
+            first_segment = true;
+        } else if (e.kind == timeline_pipeline_end && in_invocation &&
+                   (ours || !pipeline_containing_func(s, e.id))) {
+            w << "], \"end_ns\": " << e.time << "}";
+            in_invocation = false;
+        } else if (e.kind == timeline_sample && in_invocation && ours) {
+            w << (first_segment ? "\n        " : ",\n        ") << "{\"func\": ";
+            w.string(p->funcs[e.id - p->first_func_id].name);
+            w << ", \"active_threads\": " << (int)e.active_threads
+              << ", \"memory\": " << e.memory
+              << ", \"start_ns\": " << e.time;
+            in_segment = true;
+            first_segment = false;
+        }
+    }
+    if (in_segment) {
+        w << ", \"end_ns\": " << end_time << "}";
+    }
+    if (in_invocation) {
+        w << "], \"end_ns\": " << end_time << "}";
+    }
+    w << "]";
+}
+
+WEAK void export_json(ProfileExportWriter &w, halide_profiler_state *s) {
+    w << "{\n  \"pipelines\": [";
+    bool first = true;
+    for (halide_profiler_pipeline_stats *p = s->pipelines; p;
+         p = (halide_profiler_pipeline_stats *)(p->next)) {
+        if (!p->runs) {
+            continue;
+        }
+        w << (first ? "\n    {" : ",\n    {");
+        first = false;
+        export_pipeline_stats(w, p);
+        w << ",\n     \"invocations\": ";
+        export_invocations(w, s, p);
+        w << "}";
+    }
+    w << "],\n  \"timeline_recorded\": " << (timeline_enabled ? "true" : "false")
+      << ",\n  \"dropped_timeline_events\": " << timeline_dropped << "\n}\n";
+}
+
+// Pipeline invocations go on one track of the trace and the Funcs they
+// run on another, with counters tracking the number of active threads
+// and the heap memory in use. The aggregate statistics of each pipeline
+// are attached to an instant event at the end.
+WEAK void export_chrome_trace(ProfileExportWriter &w, halide_profiler_state *s) {
+    w << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+      << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": \"Halide profiler\"}},\n"
+      << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 0, \"args\": {\"name\": \"pipelines\"}},\n"
+      << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 1, \"args\": {\"name\": \"funcs\"}}";
+
+    int open_pipelines = 0;
+    bool in_func = false;
+    int last_threads = -1;
+    uint64_t last_memory = ~(uint64_t)0;
+    uint64_t end_time = 0;
+    for (int i = 0; i < timeline_size; i++) {
+        const TimelineEvent &e = timeline_events[i];
+        end_time = e.time;
+        if (in_func) {
+            w << ",\n{\"ph\": \"E\", \"pid\": 0, \"tid\": 1, \"ts\": ";
+            w.micros(e.time);
+            w << "}";
+            in_func = false;
+        }
+        if (e.kind == timeline_pipeline_start) {
+            halide_profiler_pipeline_stats *p = pipeline_containing_func(s, e.id);
+            w << ",\n{\"name\": ";
+            w.string(p ? p->name : "<unknown>");
+            w << ", \"cat\": \"pipeline\", \"ph\": \"B\", \"pid\": 0, \"tid\": 0, \"ts\": ";
+            w.micros(e.time);
+            w << "}";
+            open_pipelines++;
+        } else if (e.kind == timeline_pipeline_end && open_pipelines > 0) {
+            w << ",\n{\"ph\": \"E\", \"pid\": 0, \"tid\": 0, \"ts\": ";
+            w.micros(e.time);
+            w << "}";
+            open_pipelines--;
+        } else if (e.kind == timeline_sample) {
+            halide_profiler_pipeline_stats *p = pipeline_containing_func(s, e.id);
+            if (p) {
+                w << ",\n{\"name\": ";
+                w.string(p->funcs[e.id - p->first_func_id].name);
+                w << ", \"cat\": \"func\", \"ph\": \"B\", \"pid\": 0, \"tid\": 1, \"ts\": ";
+                w.micros(e.time);
+                w << ", \"args\": {\"pipeline\": ";
+                w.string(p->name);
+                w << "}}";
+                in_func = true;
+            }
+            if (e.active_threads != last_threads) {
+                w << ",\n{\"name\": \"active threads\", \"ph\": \"C\", \"pid\": 0, \"ts\": ";
+                w.micros(e.time);
+                w << ", \"args\": {\"threads\": " << (int)e.active_threads << "}}";
+                last_threads = e.active_threads;
+            }
+            if (e.memory != last_memory) {
+                w << ",\n{\"name\": \"heap memory\", \"ph\": \"C\", \"pid\": 0, \"ts\": ";
+                w.micros(e.time);
+                w << ", \"args\": {\"bytes\": " << e.memory << "}}";
+                last_memory = e.memory;
+            }
+        }
+    }
+    if (in_func) {
+        w << ",\n{\"ph\": \"E\", \"pid\": 0, \"tid\": 1, \"ts\": ";
+        w.micros(end_time);
+        w << "}";
+    }
+    for (; open_pipelines > 0; open_pipelines--) {
+        w << ",\n{\"ph\": \"E\", \"pid\": 0, \"tid\": 0, \"ts\": ";
+        w.micros(end_time);
+        w << "}";
+    }
+
+    for (halide_profiler_pipeline_stats *p = s->pipelines; p;
+         p = (halide_profiler_pipeline_stats *)(p->next)) {
+        if (!p->runs) {
+            continue;
+        }
+        w << ",\n{\"name\": \"summary\", \"cat\": \"pipeline\", \"ph\": \"i\", \"s\": \"g\", \"pid\": 0, \"tid\": 0, \"ts\": ";
+        w.micros(end_time);
+        w << ", \"args\": {";
+        export_pipeline_stats(w, p);
+        w << "}}";
+    }
+    w << "\n],\n\"otherData\": {\"dropped_timeline_events\": \"" << timeline_dropped << "\"}}\n";
+}
+
 }  // namespace Internal
 }  // namespace Runtime
 }  // namespace Halide
@@ -175,6 +598,23 @@ WEAK halide_profiler_pipeline_stats *halide_profiler_get_pipeline_state(const ch
     return nullptr;
 }
 
+WEAK int halide_profiler_enable_hardware_counters() {
+    halide_profiler_state *s = halide_profiler_get_state();
+
+    ScopedMutexLock lock(&s->lock);
+
+    if (hardware_counters_status == 0) {
+        if (halide_profiler_open_hardware_counters() == 0) {
+            halide_profiler_read_hardware_counters(hardware_counters_last);
+            hardware_counters_status = 1;
+        } else {
+            // Don't try again for every pipeline run.
+            hardware_counters_status = -1;
+        }
+    }
+    return hardware_counters_status > 0 ? 0 : halide_error_code_generic_error;
+}
+
 // Returns a token identifying this pipeline instance.
 WEAK int halide_profiler_pipeline_start(void *user_context,
                                         const char *pipeline_name,
@@ -187,6 +627,9 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
     if (!s->sampling_thread) {
         halide_start_clock(user_context);
         s->sampling_thread = halide_spawn_thread(sampling_profiler_thread, nullptr);
+        if (getenv("HL_PROFILER_EXPORT")) {
+            timeline_enabled = true;
+        }
     }
 
     halide_profiler_pipeline_stats *p =
@@ -197,6 +640,10 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
     }
     p->runs++;
 
+    if (timeline_enabled) {
+        timeline_append(timeline_pipeline_start, p->first_func_id, 0, 0);
+    }
+
     return p->first_func_id;
 }
 
@@ -286,6 +733,32 @@ WEAK void halide_profiler_memory_free(void *user_context,
     __sync_sub_and_fetch(&f_stats->memory_current, decr);
 }
 
+WEAK int halide_profiler_export_unlocked(void *user_context, halide_profiler_state *s,
+                                         const char *filename, halide_profiler_export_format_t format) {
+    void *file = fopen(filename, "w");
+    if (!file) {
+        error(user_context) << "Failed to open profiler export file " << filename << "\n";
+        return halide_error_code_generic_error;
+    }
+    bool ok;
+    {
+        ProfileExportWriter w(fileno(file));
+        if (format == halide_profiler_export_chrome_trace) {
+            export_chrome_trace(w, s);
+        } else {
+            export_json(w, s);
+        }
+        w.flush();
+        ok = w.ok();
+    }
+    fclose(file);
+    if (!ok) {
+        error(user_context) << "Failed to write profiler export file " << filename << "\n";
+        return halide_error_code_generic_error;
+    }
+    return 0;
+}
+
 WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_state *s) {
 
     char line_buf[1024];
@@ -310,6 +783,15 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
         }
         sstr << " heap allocations: " << p->num_allocs
              << "  peak heap usage: " << p->memory_peak << " bytes\n";
+        if (p->instructions) {
+            sstr << " cycles: " << p->cycles
+                 << "  instructions: " << p->instructions
+                 << "  ipc: " << (float)p->instructions / (p->cycles + 1e-10) << "\n"
+                 << " llc misses: " << p->llc_misses
+                 << " (" << 1000.0f * p->llc_misses / p->instructions << " per 1k instructions)"
+                 << "  branch misses: " << p->branch_misses
+                 << " (" << 1000.0f * p->branch_misses / p->instructions << " per 1k instructions)\n";
+        }
         halide_print(user_context, sstr.str());
 
         bool print_f_states = p->time || p->memory_total;
@@ -391,12 +873,43 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
                 if (fs->stack_peak > 0) {
                     sstr << " stack: " << fs->stack_peak;
                 }
+                if (fs->instructions) {
+                    // Instructions per cycle, and last-level cache and
+                    // branch misses per thousand instructions.
+                    sstr << " ipc: " << (float)fs->instructions / (fs->cycles + 1e-10);
+                    sstr.erase(4);
+                    sstr << " llc/ki: " << 1000.0f * fs->llc_misses / fs->instructions;
+                    sstr.erase(4);
+                    sstr << " br/ki: " << 1000.0f * fs->branch_misses / fs->instructions;
+                    sstr.erase(4);
+                }
                 sstr << "\n";
 
                 halide_print(user_context, sstr.str());
             }
         }
     }
+
+    const char *export_file = getenv("HL_PROFILER_EXPORT");
+    if (export_file && *export_file) {
+        const char *format = getenv("HL_PROFILER_EXPORT_FORMAT");
+        bool chrome_trace = format && strcmp(format, "chrome_trace") == 0;
+        halide_profiler_export_unlocked(user_context, s, export_file,
+                                        chrome_trace ? halide_profiler_export_chrome_trace : halide_profiler_export_json);
+    }
+}
+
+WEAK int halide_profiler_export(void *user_context, const char *filename,
+                                halide_profiler_export_format_t format) {
+    halide_profiler_state *s = halide_profiler_get_state();
+    ScopedMutexLock lock(&s->lock);
+    return halide_profiler_export_unlocked(user_context, s, filename, format);
+}
+
+WEAK void halide_profiler_record_timeline(bool enabled) {
+    halide_profiler_state *s = halide_profiler_get_state();
+    ScopedMutexLock lock(&s->lock);
+    timeline_enabled = enabled;
 }
 
 WEAK void halide_profiler_report(void *user_context) {
@@ -413,6 +926,10 @@ WEAK void halide_profiler_reset_unlocked(halide_profiler_state *s) {
         free(p);
     }
     s->first_free_id = 0;
+    // The timeline refers to funcs by id, so it goes too.
+    timeline_size = 0;
+    timeline_dropped = 0;
+    timeline_last_sample.kind = timeline_pipeline_end;
 }
 
 WEAK void halide_profiler_reset() {
@@ -440,11 +957,20 @@ halide_profiler_shutdown() {
     s->sampling_thread = nullptr;
     s->current_func = halide_profiler_outside_of_halide;
 
+    if (hardware_counters_status > 0) {
+        halide_profiler_close_hardware_counters();
+    }
+    hardware_counters_status = 0;
+
     // Print results. No need to lock anything because we just shut
     // down the thread.
     halide_profiler_report_unlocked(nullptr, s);
 
     halide_profiler_reset_unlocked(s);
+    free(timeline_events);
+    timeline_events = nullptr;
+    timeline_capacity = 0;
+    timeline_enabled = false;
 }
 
 namespace {
@@ -470,7 +996,12 @@ WEAK void halide_windows_profiler_shutdown() {
 }  // namespace
 
 WEAK void halide_profiler_pipeline_end(void *user_context, void *state) {
-    ((halide_profiler_state *)state)->current_func = halide_profiler_outside_of_halide;
+    halide_profiler_state *s = (halide_profiler_state *)state;
+    if (timeline_enabled) {
+        ScopedMutexLock lock(&s->lock);
+        timeline_append(timeline_pipeline_end, s->current_func, 0, 0);
+    }
+    s->current_func = halide_profiler_outside_of_halide;
 }
 
 }  // extern "C"
@@ -126,4 +126,14 @@ WEAK void *halide_malloc(void *user_context, size_t x) {
 WEAK void halide_free(void *user_context, void *ptr) {
     halide_default_free(user_context, ptr);
 }
+
+// The pool of pre-allocated buffers above is always in use on Hexagon,
+// so these do nothing.
+WEAK int halide_reuse_host_allocations(void *user_context, bool flag) {
+    return 0;
+}
+
+WEAK bool halide_can_reuse_host_allocations(void *user_context) {
+    return true;
+}
 }
@@ -156,6 +156,13 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
                                         const char *pipeline_name,
                                         int num_funcs,
                                         const uint64_t *func_names);
+// Hardware performance counters sampled by the profiler when asked to
+// by halide_profiler_enable_hardware_counters. Reading them fills in
+// cumulative cycles, instructions, last-level cache misses and branch
+// misses. Opening them returns zero on success.
+WEAK int halide_profiler_open_hardware_counters();
+WEAK void halide_profiler_read_hardware_counters(uint64_t *values);
+WEAK void halide_profiler_close_hardware_counters();
 WEAK int halide_host_cpu_count();
 
 WEAK int halide_device_and_host_malloc(void *user_context, struct halide_buffer_t *buf,
@@ -151,6 +151,243 @@ WEAK ScopedSpinLock::AtomicFlag halide_trace_file_lock = 0;
 WEAK bool halide_trace_file_initialized = false;
 WEAK void *halide_trace_file_internally_opened = nullptr;
 
+// Only every Nth load or store event is traced.
+WEAK int halide_trace_sample_rate = 1;
+WEAK uint32_t halide_trace_sample_counter = 0;
+
+// The size of a complete packet for an event.
+ALWAYS_INLINE uint32_t trace_packet_size(const halide_trace_event_t *e) {
+    uint32_t value_bytes = (uint32_t)(e->type.lanes * e->type.bytes());
+    uint32_t header_bytes = (uint32_t)sizeof(halide_trace_packet_t);
+    uint32_t coords_bytes = e->dimensions * (uint32_t)sizeof(int32_t);
+    uint32_t name_bytes = strlen(e->func) + 1;
+    uint32_t trace_tag_bytes = e->trace_tag ? (strlen(e->trace_tag) + 1) : 1;
+    uint32_t total_size_without_padding = header_bytes + value_bytes + coords_bytes + name_bytes + trace_tag_bytes;
+    return (total_size_without_padding + 3) & ~3;
+}
+
+ALWAYS_INLINE void write_trace_packet(halide_trace_packet_t *packet, uint32_t total_size,
+                                      int32_t id, const halide_trace_event_t *e) {
+    uint32_t value_bytes = (uint32_t)(e->type.lanes * e->type.bytes());
+    uint32_t coords_bytes = e->dimensions * (uint32_t)sizeof(int32_t);
+    uint32_t name_bytes = strlen(e->func) + 1;
+    uint32_t trace_tag_bytes = e->trace_tag ? (strlen(e->trace_tag) + 1) : 1;
+
+    packet->size = total_size;
+    packet->id = id;
+    packet->type = e->type;
+    packet->event = e->event;
+    packet->parent_id = e->parent_id;
+    packet->value_index = e->value_index;
+    packet->dimensions = e->dimensions;
+    if (e->coordinates) {
+        memcpy((void *)packet->coordinates(), e->coordinates, coords_bytes);
+    }
+    if (e->value) {
+        memcpy((void *)packet->value(), e->value, value_bytes);
+    }
+    memcpy((void *)packet->func(), e->func, name_bytes);
+    memcpy((void *)packet->trace_tag(), e->trace_tag ? e->trace_tag : "", trace_tag_bytes);
+}
+
+// Compact tracing. Loads and stores are delta-encoded into one of a set
+// of buffers, each with its own lock, and written to the trace file as
+// chunks when a buffer fills. A thread picks its buffer from the address
+// of its stack, so the threads of a parallel loop rarely contend. All
+// other events flush every buffer first and are then written out
+// directly as ordinary packets, so the loads and stores inside a
+// production stay between its begin and end events in the file.
+//
+// A chunk starts with a 32-bit word holding the length of the encoded
+// records in bytes, shifted left by two and with the low bit set.
+// Packet sizes are multiples of four, so readers can tell the two apart.
+// The records are padded to a multiple of four bytes. Each record is:
+//
+//   flags (1 byte). If the low bit is set, a new header follows:
+//     event (1 byte), type code (1 byte), type bits (1 byte),
+//     type lanes (2 bytes, little-endian), parent_id (zigzag varint),
+//     value_index (varint), dimensions (varint), func name and trace
+//     tag (both nul-terminated).
+//     Otherwise the header of the previous record in the chunk is reused.
+//   id, as a zigzag varint delta from the previous record's id.
+//   coordinates, each a zigzag varint delta from the same coordinate
+//     of the previous record.
+//   value (lanes * bytes, raw).
+//
+// Ids and coordinates of the previous record start at zero in each chunk.
+const static int compact_buffer_size = 64 * 1024;
+const static int compact_max_coordinates = 64;
+const static int compact_num_stripes = 8;
+const static uint8_t compact_new_header = 1;
+
+struct CompactTraceStripe {
+    ScopedSpinLock::AtomicFlag lock;
+    uint32_t cursor;
+    // The header of the last record written, reused when the next
+    // record matches it.
+    bool has_header;
+    const char *func, *trace_tag;
+    halide_type_t type;
+    int32_t event, parent_id, value_index, dimensions;
+    int32_t last_id;
+    int32_t coordinates[compact_max_coordinates];
+    // The first four bytes are the chunk length.
+    uint8_t buf[compact_buffer_size];
+
+    ALWAYS_INLINE void reset() {
+        cursor = 4;
+        has_header = false;
+        last_id = 0;
+        memset(coordinates, 0, sizeof(coordinates));
+    }
+};
+
+WEAK bool halide_trace_compact = false;
+WEAK CompactTraceStripe *halide_trace_compact_stripes = nullptr;
+WEAK ScopedSpinLock::AtomicFlag halide_trace_write_lock = 0;
+
+ALWAYS_INLINE CompactTraceStripe &current_compact_stripe() {
+    int local;
+    uint64_t h = ((uint64_t)(size_t)&local >> 16) * 0x9e3779b97f4a7c15ULL;
+    return halide_trace_compact_stripes[(h >> 32) % compact_num_stripes];
+}
+
+ALWAYS_INLINE uint8_t *put_varint(uint8_t *dst, uint32_t x) {
+    while (x >= 0x80) {
+        *dst++ = (uint8_t)(x | 0x80);
+        x >>= 7;
+    }
+    *dst++ = (uint8_t)x;
+    return dst;
+}
+
+ALWAYS_INLINE uint8_t *put_zigzag(uint8_t *dst, int32_t x) {
+    return put_varint(dst, ((uint32_t)x << 1) ^ (uint32_t)(x >> 31));
+}
+
+WEAK void write_to_trace_file(void *user_context, int fd, const void *buf, uint32_t size) {
+    bool success;
+    {
+        ScopedSpinLock lock(&halide_trace_write_lock);
+        success = (size == (uint32_t)write(fd, buf, size));
+    }
+    halide_assert(user_context, success && "Could not write to trace file");
+}
+
+// Write out a stripe's records as a chunk. Must be called with the
+// stripe locked.
+WEAK void flush_compact_stripe(void *user_context, int fd, CompactTraceStripe &stripe) {
+    uint32_t length = stripe.cursor - 4;
+    if (length == 0) {
+        return;
+    }
+    while (stripe.cursor & 3) {
+        stripe.buf[stripe.cursor++] = 0;
+    }
+    uint32_t marker = (length << 2) | 1;
+    memcpy(stripe.buf, &marker, sizeof(marker));
+    write_to_trace_file(user_context, fd, stripe.buf, stripe.cursor);
+    stripe.reset();
+}
+
+WEAK void flush_compact_stripes(void *user_context, int fd) {
+    if (!halide_trace_compact_stripes) {
+        return;
+    }
+    for (int i = 0; i < compact_num_stripes; i++) {
+        CompactTraceStripe &stripe = halide_trace_compact_stripes[i];
+        ScopedSpinLock lock(&stripe.lock);
+        flush_compact_stripe(user_context, fd, stripe);
+    }
+}
+
+WEAK void compact_trace(void *user_context, int fd, int32_t id, const halide_trace_event_t *e) {
+    uint32_t value_bytes = (uint32_t)(e->type.lanes * e->type.bytes());
+    const char *trace_tag = e->trace_tag ? e->trace_tag : "";
+    uint32_t name_bytes = strlen(e->func) + 1;
+    uint32_t trace_tag_bytes = strlen(trace_tag) + 1;
+    // The largest the record could be: a varint takes at most five bytes.
+    uint32_t max_record_size = 1 + 5 + 3 * 5 + name_bytes + trace_tag_bytes +
+                               5 + 5 * e->dimensions + value_bytes;
+
+    bool compactable = (e->event == halide_trace_load || e->event == halide_trace_store) &&
+                       e->dimensions <= compact_max_coordinates &&
+                       max_record_size + 8 <= (uint32_t)compact_buffer_size;
+    if (!compactable) {
+        flush_compact_stripes(user_context, fd);
+
+        uint32_t total_size = trace_packet_size(e);
+        uint8_t stack_buf[1024];
+        uint8_t *buf = total_size <= sizeof(stack_buf) ? stack_buf : (uint8_t *)malloc(total_size);
+        halide_assert(user_context, buf && "Could not allocate trace packet");
+        write_trace_packet((halide_trace_packet_t *)buf, total_size, id, e);
+        write_to_trace_file(user_context, fd, buf, total_size);
+        if (buf != stack_buf) {
+            free(buf);
+        }
+        return;
+    }
+
+    CompactTraceStripe &stripe = current_compact_stripe();
+    ScopedSpinLock lock(&stripe.lock);
+    if (stripe.cursor + max_record_size + 3 > (uint32_t)compact_buffer_size) {
+        flush_compact_stripe(user_context, fd, stripe);
+    }
+
+    uint8_t *dst = stripe.buf + stripe.cursor;
+    bool same_header = (stripe.has_header &&
+                        stripe.func == e->func &&
+                        stripe.trace_tag == trace_tag &&
+                        stripe.type == e->type &&
+                        stripe.event == e->event &&
+                        stripe.parent_id == e->parent_id &&
+                        stripe.value_index == e->value_index &&
+                        stripe.dimensions == e->dimensions);
+    if (same_header) {
+        *dst++ = 0;
+    } else {
+        *dst++ = compact_new_header;
+        *dst++ = (uint8_t)e->event;
+        *dst++ = e->type.code;
+        *dst++ = e->type.bits;
+        *dst++ = (uint8_t)(e->type.lanes & 0xff);
+        *dst++ = (uint8_t)(e->type.lanes >> 8);
+        dst = put_zigzag(dst, e->parent_id);
+        dst = put_varint(dst, (uint32_t)e->value_index);
+        dst = put_varint(dst, (uint32_t)e->dimensions);
+        memcpy(dst, e->func, name_bytes);
+        dst += name_bytes;
+        memcpy(dst, trace_tag, trace_tag_bytes);
+        dst += trace_tag_bytes;
+
+        stripe.has_header = true;
+        stripe.func = e->func;
+        stripe.trace_tag = trace_tag;
+        stripe.type = e->type;
+        stripe.event = e->event;
+        stripe.parent_id = e->parent_id;
+        stripe.value_index = e->value_index;
+        stripe.dimensions = e->dimensions;
+    }
+
+    // Do the deltas in unsigned arithmetic, so they wrap rather than overflow.
+    dst = put_zigzag(dst, (int32_t)((uint32_t)id - (uint32_t)stripe.last_id));
+    stripe.last_id = id;
+    for (int i = 0; i < e->dimensions; i++) {
+        int32_t c = e->coordinates[i];
+        dst = put_zigzag(dst, (int32_t)((uint32_t)c - (uint32_t)stripe.coordinates[i]));
+        stripe.coordinates[i] = c;
+    }
+    if (e->value) {
+        memcpy(dst, e->value, value_bytes);
+    } else {
+        memset(dst, 0, value_bytes);
+    }
+    dst += value_bytes;
+
+    stripe.cursor = (uint32_t)(dst - stripe.buf);
+}
+
 }  // namespace Internal
 }  // namespace Runtime
 }  // namespace Halide
@@ -162,17 +399,19 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
 
     int32_t my_id = __sync_fetch_and_add(&ids, 1);
 
+    if (halide_trace_sample_rate > 1 &&
+        (e->event == halide_trace_load || e->event == halide_trace_store) &&
+        __sync_fetch_and_add(&halide_trace_sample_counter, 1) % halide_trace_sample_rate != 0) {
+        return my_id;
+    }
+
     // If we're dumping to a file, use a binary format
     int fd = halide_get_trace_file(user_context);
-    if (fd > 0) {
+    if (fd > 0 && halide_trace_compact_stripes) {
+        compact_trace(user_context, fd, my_id, e);
+    } else if (fd > 0) {
         // Compute the total packet size
-        uint32_t value_bytes = (uint32_t)(e->type.lanes * e->type.bytes());
-        uint32_t header_bytes = (uint32_t)sizeof(halide_trace_packet_t);
-        uint32_t coords_bytes = e->dimensions * (uint32_t)sizeof(int32_t);
-        uint32_t name_bytes = strlen(e->func) + 1;
-        uint32_t trace_tag_bytes = e->trace_tag ? (strlen(e->trace_tag) + 1) : 1;
-        uint32_t total_size_without_padding = header_bytes + value_bytes + coords_bytes + name_bytes + trace_tag_bytes;
-        uint32_t total_size = (total_size_without_padding + 3) & ~3;
+        uint32_t total_size = trace_packet_size(e);
 
         // Claim some space to write to in the trace buffer
         halide_trace_packet_t *packet = halide_trace_buffer->acquire_packet(user_context, fd, total_size);
@@ -182,21 +421,7 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
         }
 
         // Write a packet into it
-        packet->size = total_size;
-        packet->id = my_id;
-        packet->type = e->type;
-        packet->event = e->event;
-        packet->parent_id = e->parent_id;
-        packet->value_index = e->value_index;
-        packet->dimensions = e->dimensions;
-        if (e->coordinates) {
-            memcpy((void *)packet->coordinates(), e->coordinates, coords_bytes);
-        }
-        if (e->value) {
-            memcpy((void *)packet->value(), e->value, value_bytes);
-        }
-        memcpy((void *)packet->func(), e->func, name_bytes);
-        memcpy((void *)packet->trace_tag(), e->trace_tag ? e->trace_tag : "", trace_tag_bytes);
+        write_trace_packet(packet, total_size, my_id, e);
 
         // Release it
         halide_trace_buffer->release_packet(packet);
@@ -342,6 +567,14 @@ WEAK void halide_set_trace_file(int fd) {
     halide_trace_file = fd;
 }
 
+WEAK void halide_set_trace_compact(bool compact) {
+    halide_trace_compact = compact;
+}
+
+WEAK void halide_set_trace_sample_rate(int n) {
+    halide_trace_sample_rate = n < 1 ? 1 : n;
+}
+
 extern int errno;
 
 WEAK int halide_get_trace_file(void *user_context) {
@@ -357,10 +590,32 @@ WEAK int halide_get_trace_file(void *user_context) {
                 halide_trace_buffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
                 halide_trace_buffer->init();
             }
+            const char *compact = getenv("HL_TRACE_COMPACT");
+            if (compact && atoi(compact)) {
+                halide_set_trace_compact(true);
+            }
+            const char *sample_rate = getenv("HL_TRACE_SAMPLE");
+            if (sample_rate) {
+                halide_set_trace_sample_rate(atoi(sample_rate));
+            }
         } else {
             halide_set_trace_file(0);
         }
     }
+    if (halide_trace_compact && halide_trace_file > 0 && !halide_trace_compact_stripes) {
+        CompactTraceStripe *stripes =
+            (CompactTraceStripe *)malloc(compact_num_stripes * sizeof(CompactTraceStripe));
+        halide_assert(user_context, stripes && "Could not allocate compact trace buffers");
+        for (int i = 0; i < compact_num_stripes; i++) {
+            stripes[i].lock = 0;
+            stripes[i].reset();
+        }
+        // Anything already traced must come before the first chunk.
+        if (halide_trace_buffer) {
+            halide_trace_buffer->flush(user_context, halide_trace_file);
+        }
+        halide_trace_compact_stripes = stripes;
+    }
     return halide_trace_file;
 }
 
@@ -369,6 +624,13 @@ WEAK int32_t halide_trace(void *user_context, const halide_trace_event_t *e) {
 }
 
 WEAK int halide_shutdown_trace() {
+    if (halide_trace_compact_stripes) {
+        if (halide_trace_file > 0) {
+            flush_compact_stripes(nullptr, halide_trace_file);
+        }
+        free(halide_trace_compact_stripes);
+        halide_trace_compact_stripes = nullptr;
+    }
     if (halide_trace_file_internally_opened) {
         int ret = fclose(halide_trace_file_internally_opened);
         halide_trace_file = 0;
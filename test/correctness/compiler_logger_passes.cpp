@@ -0,0 +1,56 @@
+#include "Halide.h"
+#include "halide_test_dirs.h"
+
+#include <cstdio>
+#include <sstream>
+
+using namespace Halide;
+
+bool expect_contains(const std::string &log, const std::string &substr) {
+    if (log.find(substr) == std::string::npos) {
+        printf("Expected the compiler log to contain %s. Got:\n%s\n", substr.c_str(), log.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    ImageParam input(Float(32), 2, "input");
+    Var x("x"), y("y");
+    Func blur_x("blur_x"), blur_y("blur_y");
+    blur_x(x, y) = (input(x, y) + input(x + 1, y) + input(x + 2, y)) / 3;
+    blur_y(x, y) = (blur_x(x, y) + blur_x(x, y + 1) + blur_x(x, y + 2)) / 3;
+    blur_x.compute_at(blur_y, y).vectorize(x, 8);
+    blur_y.parallel(y).vectorize(x, 8);
+
+    Target target = get_host_target();
+    std::string object = Internal::get_test_tmp_dir() + "halide_test_correctness_compiler_logger_passes.o";
+    Internal::ensure_no_file_exists(object);
+
+    Internal::set_compiler_logger(std::unique_ptr<Internal::CompilerLogger>(new Internal::JSONCompilerLogger()));
+    Module m = blur_y.compile_to_module({input}, "blur", target);
+    m.compile({{Output::object, object}});
+
+    std::ostringstream log;
+    Internal::get_compiler_logger()->emit_to_stream(log);
+    Internal::set_compiler_logger(nullptr);
+
+    // Every lowering pass is recorded in order, along with the size of
+    // the IR after it. The LLVM passes are combined by name.
+    if (!expect_contains(log.str(), "\"compilation_passes_halide_lowering\" : [") ||
+        !expect_contains(log.str(), "{\"name\" : \"creating initial loop nests\", \"invocations\" : 1, ") ||
+        !expect_contains(log.str(), "{\"name\" : \"vectorizing\"") ||
+        !expect_contains(log.str(), "\"compilation_passes_llvm\" : [") ||
+        !expect_contains(log.str(), "{\"name\" : \"CodeGen\"") ||
+        !expect_contains(log.str(), "\"peak_memory\" : ")) {
+        return -1;
+    }
+
+    // The first pass starts from nothing.
+    if (!expect_contains(log.str(), "\"ir_size_before\" : 0, ")) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int mallocs = 0;
+
+void *my_malloc(void *user_context, size_t x) {
+    mallocs++;
+    void *orig = malloc(x + 32);
+    void *ptr = (void *)((((size_t)orig + 32) >> 5) << 5);
+    ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    free(((void **)ptr)[-1]);
+}
+
+enum class Hoist {
+    None,
+    ToY,
+    ToRoot,
+};
+
+// Realize a pipeline with a producer computed per tile of its
+// consumer, and return the number of heap allocations it made, or -1
+// if the output is wrong.
+int run(Hoist hoist) {
+    const int width = 100, height = 32;
+
+    Func f("f"), g("g");
+    Var x("x"), y("y"), xo("xo"), xi("xi");
+    Param<int> tile;
+
+    f(x, y) = x * y;
+    g(x, y) = f(x, y) + f(x + 1, y) + f(x, y + 1) + f(x + 1, y + 1);
+
+    // The size of f isn't known at compile time, so it goes on the
+    // heap.
+    g.split(x, xo, xi, tile);
+    f.compute_at(g, xo);
+    if (hoist == Hoist::ToY) {
+        f.hoist_storage(g, y);
+    } else if (hoist == Hoist::ToRoot) {
+        f.hoist_storage_root();
+    }
+
+    g.set_custom_allocator(my_malloc, my_free);
+    tile.set(8);
+    mallocs = 0;
+    Buffer<int> out = g.realize({width, height});
+
+    for (int yy = 0; yy < height; yy++) {
+        for (int xx = 0; xx < width; xx++) {
+            int correct = xx * yy + (xx + 1) * yy + xx * (yy + 1) + (xx + 1) * (yy + 1);
+            if (out(xx, yy) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", xx, yy, out(xx, yy), correct);
+                return -1;
+            }
+        }
+    }
+    return mallocs;
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not support set_custom_allocator().\n");
+        return 0;
+    }
+
+    int not_hoisted = run(Hoist::None);
+    int hoisted_to_y = run(Hoist::ToY);
+    int hoisted_to_root = run(Hoist::ToRoot);
+    if (not_hoisted < 0 || hoisted_to_y < 0 || hoisted_to_root < 0) {
+        return -1;
+    }
+
+    // f is allocated once per tile, once per row, or once in total.
+    if (not_hoisted <= 32 || hoisted_to_y != 32 || hoisted_to_root != 1) {
+        printf("Unexpected number of allocations: %d %d %d\n",
+               not_hoisted, hoisted_to_y, hoisted_to_root);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
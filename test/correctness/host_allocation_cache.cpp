@@ -0,0 +1,51 @@
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // A chain of Funcs computed per tile of a parallel loop, so that
+    // each tile mallocs and frees every intermediate. The tile size
+    // varies with the Param, so allocations of many different sizes go
+    // through the pool.
+    Param<int> tile;
+    Var x("x"), xo("xo"), xi("xi");
+
+    const int N = 10;
+    Func f[N];
+    f[0](x) = x;
+    for (int i = 1; i < N; i++) {
+        f[i](x) = f[i - 1](x) * 3 + i;
+    }
+    Func out;
+    out(x) = f[N - 1](x);
+    out.split(x, xo, xi, tile, TailStrategy::GuardWithIf).parallel(xo);
+    for (int i = 0; i < N; i++) {
+        f[i].compute_at(out, xo).store_in(MemoryType::Heap);
+    }
+
+    Buffer<int> reference;
+    for (int use_pool = 0; use_pool < 2; use_pool++) {
+        Internal::JITSharedRuntime::reuse_host_allocations(use_pool != 0);
+        for (int t = 1; t <= 4096; t = t * 3 + 1) {
+            tile.set(t);
+            Buffer<int> result = out.realize({10000});
+            if (!reference.defined()) {
+                reference = result;
+                continue;
+            }
+            for (int i = 0; i < result.width(); i++) {
+                if (result(i) != reference(i)) {
+                    printf("result(%d) = %d instead of %d with tile size %d (pooling %s)\n",
+                           i, result(i), reference(i), t, use_pool ? "on" : "off");
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Release everything the pool is holding onto.
+    Internal::JITSharedRuntime::reuse_host_allocations(false);
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "Halide.h"
+#include <algorithm>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+using namespace Halide;
+
+#ifndef _WIN32
+namespace {
+
+std::vector<std::string> list_dir(const std::string &dir) {
+    std::vector<std::string> files;
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        return files;
+    }
+    while (dirent *e = readdir(d)) {
+        std::string name = e->d_name;
+        if (name != "." && name != "..") {
+            files.push_back(dir + "/" + name);
+        }
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// Cache entries are replaced by renaming a new file into place, so an
+// entry that was rewritten has a new inode.
+std::vector<ino_t> inodes(const std::vector<std::string> &files) {
+    std::vector<ino_t> result;
+    for (const auto &f : files) {
+        struct stat s;
+        result.push_back(stat(f.c_str(), &s) == 0 ? s.st_ino : 0);
+    }
+    return result;
+}
+
+}  // namespace
+#endif
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+    printf("[SKIP] Windows does not have a working setenv\n");
+#else
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not use the JIT disk cache.\n");
+        return 0;
+    }
+
+    std::string cache_dir = Internal::dir_make_temp();
+    setenv("HL_JIT_CACHE_DIR", cache_dir.c_str(), 1);
+
+    {
+        Func f("f"), g("g");
+        Var x("x"), y("y");
+        ImageParam input(Int(32), 2, "input");
+        Param<int> offset("offset");
+
+        f(x, y) = input(x, y) * 3 + offset;
+        g(x, y) = f(x, y) + f(x + 1, y);
+        f.compute_at(g, y).vectorize(x, 8);
+        g.parallel(y);
+
+        Buffer<int> in(33, 16);
+        in.for_each_element([&](int x, int y) { in(x, y) = x * 7 + y; });
+        input.set(in);
+        offset.set(5);
+
+        Pipeline p(g);
+
+        // Compile twice. The first compilation populates the cache, and
+        // the second one must load its machine code back from it. Both
+        // must produce the right answer.
+        std::vector<std::string> entry;
+        for (int i = 0; i < 2; i++) {
+            p.invalidate_cache();
+            Buffer<int> out = p.realize({32, 16});
+            for (int y = 0; y < 16; y++) {
+                for (int x = 0; x < 32; x++) {
+                    int correct = (in(x, y) * 3 + 5) + (in(x + 1, y) * 3 + 5);
+                    if (out(x, y) != correct) {
+                        printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                        return -1;
+                    }
+                }
+            }
+
+            // An entry is an object file and a bitcode stub.
+            std::vector<std::string> files = list_dir(cache_dir);
+            if (files.size() != 2) {
+                printf("Expected one cache entry after compilation %d, but found %d files\n",
+                       i, (int)files.size());
+                return -1;
+            }
+            if (i == 0) {
+                entry = files;
+            } else if (files != entry || inodes(files) != inodes(entry)) {
+                printf("The second compilation did not reuse the cache entry\n");
+                return -1;
+            }
+        }
+    }
+
+    // Two pipelines that differ only in a float constant, which the
+    // default IR printer rounds to the same text, must get different
+    // entries.
+    const float constants[] = {1.0000001f, 1.0000002f};
+    for (int i = 0; i < 2; i++) {
+        Func h("h");
+        Var x("x");
+        h(x) = cast<float>(x) * constants[i];
+
+        Buffer<float> out = h.realize({16});
+        for (int x = 0; x < 16; x++) {
+            float correct = (float)x * constants[i];
+            if (out(x) != correct) {
+                printf("With constant %d, out(%d) = %.9g instead of %.9g\n", i, x, out(x), correct);
+                return -1;
+            }
+        }
+    }
+    if (list_dir(cache_dir).size() != 6) {
+        printf("Expected three cache entries, but found %d files\n", (int)list_dir(cache_dir).size());
+        return -1;
+    }
+
+    unsetenv("HL_JIT_CACHE_DIR");
+    for (const auto &f : list_dir(cache_dir)) {
+        Internal::file_unlink(f);
+    }
+    Internal::dir_rmdir(cache_dir);
+
+    printf("Success!\n");
+#endif
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+int call_count = 0;
+extern "C" DLLEXPORT int call_counter(int x) {
+    call_count++;
+    return x;
+}
+HalideExtern_1(int, call_counter, int);
+
+// Each memoized result is 1024 ints.
+const int kSize = 1024;
+const int64_t kEntryBytes = kSize * sizeof(int32_t);
+const uint64_t kEvictionKey = 1;
+
+Param<int> key;
+Func g;
+
+// Realize g for one key and return whether the memoized Func was
+// recomputed.
+bool realize_misses(int k) {
+    key.set(k);
+    call_count = 0;
+    Buffer<int> out = g.realize({kSize});
+    for (int x = 0; x < kSize; x++) {
+        if (out(x) != x + k + 1) {
+            printf("out(%d) = %d instead of %d\n", x, out(x), x + k + 1);
+            exit(-1);
+        }
+    }
+    return call_count != 0;
+}
+
+int main(int argc, char **argv) {
+    Func f;
+    Var x;
+    f(x) = call_counter(x + key);
+    f.compute_root().memoize(EvictionKey(Expr(kEvictionKey)));
+    g(x) = f(x) + 1;
+
+    // Room for three results.
+    Internal::JITSharedRuntime::memoization_cache_set_size(3 * kEntryBytes);
+
+    const halide_memoization_cache_eviction_policy_t policies[] = {
+        halide_memoization_cache_evict_lru,
+        halide_memoization_cache_evict_lfu,
+        halide_memoization_cache_evict_size_aware};
+    const char *policy_names[] = {"lru", "lfu", "size_aware"};
+
+    for (int p = 0; p < 3; p++) {
+        Internal::JITSharedRuntime::memoization_cache_evict(kEvictionKey);
+        Internal::JITSharedRuntime::memoization_cache_set_eviction_policy(policies[p]);
+        halide_memoization_cache_stats_t before = Internal::JITSharedRuntime::memoization_cache_get_stats();
+
+        // Fill the cache, then reuse the first result a few times.
+        for (int k = 0; k < 3; k++) {
+            if (!realize_misses(k)) {
+                printf("%s: expected a miss for key %d\n", policy_names[p], k);
+                return -1;
+            }
+        }
+        for (int i = 0; i < 3; i++) {
+            if (realize_misses(0)) {
+                printf("%s: expected a hit for key 0\n", policy_names[p]);
+                return -1;
+            }
+        }
+
+        // Push three new results through the cache. LRU evicts key 0
+        // once it becomes the least recently used entry. The other
+        // policies keep it, as it is the only entry with any hits.
+        for (int k = 3; k < 6; k++) {
+            realize_misses(k);
+        }
+
+        halide_memoization_cache_stats_t after = Internal::JITSharedRuntime::memoization_cache_get_stats();
+        uint64_t hits = after.hits - before.hits;
+        uint64_t misses = after.misses - before.misses;
+        if (hits != 3 || misses != 6) {
+            printf("%s: expected 3 hits and 6 misses, got %d and %d\n",
+                   policy_names[p], (int)hits, (int)misses);
+            return -1;
+        }
+        if (after.evictions - before.evictions != 3) {
+            printf("%s: expected 3 evictions, got %d\n",
+                   policy_names[p], (int)(after.evictions - before.evictions));
+            return -1;
+        }
+        if (after.entries != 3 || after.current_size != 3 * kEntryBytes ||
+            after.max_size != 3 * kEntryBytes) {
+            printf("%s: unexpected cache occupancy: %d entries, %d bytes of %d\n",
+                   policy_names[p], (int)after.entries, (int)after.current_size, (int)after.max_size);
+            return -1;
+        }
+
+        bool key_0_evicted = realize_misses(0);
+        if (key_0_evicted != (policies[p] == halide_memoization_cache_evict_lru)) {
+            printf("%s: key 0 was unexpectedly %s\n",
+                   policy_names[p], key_0_evicted ? "evicted" : "kept");
+            return -1;
+        }
+    }
+
+    // Return the cache to its defaults.
+    Internal::JITSharedRuntime::memoization_cache_evict(kEvictionKey);
+    Internal::JITSharedRuntime::memoization_cache_set_eviction_policy(halide_memoization_cache_evict_lru);
+    Internal::JITSharedRuntime::memoization_cache_set_size(0);
+
+    printf("Success!\n");
+    return 0;
+}
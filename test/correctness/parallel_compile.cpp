@@ -0,0 +1,85 @@
+#include "Halide.h"
+#include "halide_test_dirs.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace Halide;
+
+std::string get_fname(const std::string &base) {
+    return Internal::get_test_tmp_dir() + "halide_test_correctness_parallel_compile_" + base;
+}
+
+std::string read_file(const std::string &filename) {
+    std::ifstream f(filename, std::ios::binary);
+    std::stringstream contents;
+    contents << f.rdbuf();
+    return contents.str();
+}
+
+int main(int argc, char **argv) {
+    ImageParam input(Float(32), 2, "input");
+    Var x("x"), y("y");
+    Func blur_x("blur_x"), blur_y("blur_y"), sharpen("sharpen");
+    blur_x(x, y) = (input(x, y) + input(x + 1, y) + input(x + 2, y)) / 3;
+    blur_y(x, y) = (blur_x(x, y) + blur_x(x, y + 1) + blur_x(x, y + 2)) / 3;
+    sharpen(x, y) = 2 * input(x, y) - blur_y(x, y);
+    blur_x.compute_at(sharpen, y).vectorize(x, 8);
+    sharpen.parallel(y).vectorize(x, 8);
+
+    const std::vector<std::string> target_strings = {
+        "host-profile-no_bounds_query",
+        "host-no_asserts",
+        "host",
+    };
+    std::vector<Target> targets;
+    for (const auto &s : target_strings) {
+        targets.emplace_back(s);
+    }
+    const std::vector<std::string> suffixes = {"a", "b", "c"};
+
+    // Lower each sub-target once, so that both compilations below
+    // generate code from the same lowered modules.
+    std::map<std::string, Module> modules;
+    auto module_factory = [&](const std::string &fn_name, const Target &target) {
+        auto it = modules.find(fn_name);
+        if (it == modules.end()) {
+            it = modules.emplace(fn_name, sharpen.compile_to_module({input}, fn_name, target)).first;
+        }
+        return it->second;
+    };
+
+    const char *o = get_host_target().os == Target::Windows ? ".obj" : ".o";
+    std::vector<std::string> outputs = {"_runtime", "_wrapper"};
+    for (const auto &s : suffixes) {
+        outputs.push_back("-" + s);
+    }
+
+    std::map<std::string, std::string> serial_outputs;
+    for (int threads : {1, 4}) {
+        Internal::set_compile_thread_count(threads);
+
+        std::string fname = get_fname(std::to_string(threads));
+        for (const auto &s : outputs) {
+            Internal::ensure_no_file_exists(fname + s + o);
+        }
+        compile_multitarget("sharpen", {{Output::object, fname + o}}, targets, suffixes, module_factory);
+
+        for (const auto &s : outputs) {
+            Internal::assert_file_exists(fname + s + o);
+            std::string contents = read_file(fname + s + o);
+            if (threads == 1) {
+                serial_outputs[s] = contents;
+            } else if (contents != serial_outputs[s]) {
+                printf("Object file %s%s differs when compiled with %d threads\n", s.c_str(), o, threads);
+                return -1;
+            }
+        }
+    }
+    Internal::set_compile_thread_count(1);
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "Halide.h"
+#include "halide_test_dirs.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace Halide;
+
+namespace {
+
+bool contains(const std::vector<char> &data, const std::string &s) {
+    return std::search(data.begin(), data.end(), s.begin(), s.end()) != data.end();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+    printf("[SKIP] Windows does not have a working setenv\n");
+#else
+    Func f("f"), g("g"), h("h");
+    Var x("x"), y("y");
+    ImageParam input(Float(32), 2, "input");
+
+    f(x, y) = input(x, y) * 2.0f;
+    g(x, y) = f(x - 1, y) + f(x + 1, y);
+    h(x, y) = g(x, y - 1) * g(x, y + 1);
+    f.compute_root().parallel(y);
+    g.compute_root().parallel(y).vectorize(x, 8);
+    h.parallel(y).vectorize(x, 8);
+
+    // Compile the library in four objects, which should all end up in
+    // the archive. The objects are named after the library.
+    setenv("HL_LLVM_PARTITIONS", "4", 1);
+    std::string lib = Internal::get_test_tmp_dir() + "p" + ".a";
+    Internal::ensure_no_file_exists(lib);
+    h.compile_to({{Output::static_library, lib}}, {input}, "p", get_host_target());
+    unsetenv("HL_LLVM_PARTITIONS");
+
+    Internal::assert_file_exists(lib);
+    std::vector<char> archive = Internal::read_entire_file(lib);
+    for (int i = 0; i < 4; i++) {
+        std::string member = "p_" + std::to_string(i) + ".o";
+        if (!contains(archive, member)) {
+            printf("%s is missing from %s\n", member.c_str(), lib.c_str());
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+#endif
+    return 0;
+}
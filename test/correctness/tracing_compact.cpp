@@ -0,0 +1,212 @@
+#include "Halide.h"
+#include "../../util/HalideTraceCompact.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace Halide;
+
+namespace {
+
+struct Event {
+    int id, parent_id, event, value_index;
+    std::string func;
+    std::vector<int> coordinates;
+    std::vector<uint8_t> value;
+
+    bool is_load_or_store() const {
+        return event == halide_trace_load || event == halide_trace_store;
+    }
+
+    bool operator==(const Event &other) const {
+        return (id == other.id &&
+                parent_id == other.parent_id &&
+                event == other.event &&
+                value_index == other.value_index &&
+                func == other.func &&
+                coordinates == other.coordinates &&
+                value == other.value);
+    }
+};
+
+Event to_event(const halide_trace_packet_t *p) {
+    Event e;
+    e.id = p->id;
+    e.parent_id = p->parent_id;
+    e.event = p->event;
+    e.value_index = p->value_index;
+    e.func = p->func();
+    e.coordinates.assign(p->coordinates(), p->coordinates() + p->dimensions);
+    const uint8_t *value = (const uint8_t *)p->value();
+    e.value.assign(value, value + p->type.lanes * p->type.bytes());
+    return e;
+}
+
+// Read a trace file, decoding any compact chunks in it. Returns the
+// number of chunks found.
+int read_trace(const std::string &filename, std::vector<Event> *events) {
+    std::vector<char> data = Internal::read_entire_file(filename);
+    Internal::CompactTraceDecoder decoder;
+    std::vector<uint32_t> packet(1024);
+    int chunks = 0;
+    size_t pos = 0;
+    while (pos + 4 <= data.size()) {
+        uint32_t word;
+        memcpy(&word, &data[pos], 4);
+        if (Internal::CompactTraceDecoder::is_chunk_marker(word)) {
+            size_t bytes = Internal::CompactTraceDecoder::chunk_bytes(word);
+            if (pos + 4 + bytes > data.size()) {
+                printf("Truncated chunk in %s\n", filename.c_str());
+                exit(-1);
+            }
+            memcpy(decoder.begin_chunk(word), &data[pos + 4], bytes);
+            pos += 4 + bytes;
+            chunks++;
+            while (decoder.has_packets()) {
+                halide_trace_packet_t *p = (halide_trace_packet_t *)packet.data();
+                if (!decoder.next_packet(p, packet.size() * 4 - sizeof(halide_trace_packet_t))) {
+                    printf("Malformed chunk in %s\n", filename.c_str());
+                    exit(-1);
+                }
+                events->push_back(to_event(p));
+            }
+        } else {
+            if (word < sizeof(halide_trace_packet_t) || pos + word > data.size()) {
+                printf("Malformed packet in %s\n", filename.c_str());
+                exit(-1);
+            }
+            events->push_back(to_event((const halide_trace_packet_t *)&data[pos]));
+            pos += word;
+        }
+    }
+    if (pos != data.size()) {
+        printf("Trailing bytes in %s\n", filename.c_str());
+        exit(-1);
+    }
+    return chunks;
+}
+
+// Run the pipeline with its trace going to a new file, under the
+// given settings for HL_TRACE_COMPACT and HL_TRACE_SAMPLE.
+std::vector<Event> run_traced(Pipeline p, const char *compact, const char *sample_rate, int *chunks) {
+    std::string filename = Internal::file_make_temp("tracing_compact", ".bin");
+    setenv("HL_TRACE_FILE", filename.c_str(), 1);
+    setenv("HL_TRACE_COMPACT", compact, 1);
+    setenv("HL_TRACE_SAMPLE", sample_rate, 1);
+
+    Buffer<int> out = p.realize({16, 8});
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 16; x++) {
+            int correct = 2 * x + 1 + y * 10;
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                exit(-1);
+            }
+        }
+    }
+
+    // The runtime reads the environment once, and flushes and closes
+    // the trace file when it is destroyed, so start over with a new one.
+    p.invalidate_cache();
+    Internal::JITSharedRuntime::release_all();
+
+    std::vector<Event> events;
+    *chunks = read_trace(filename, &events);
+    Internal::file_unlink(filename);
+    return events;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+    printf("[SKIP] Windows does not have a working setenv\n");
+#else
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not support writing trace files.\n");
+        return 0;
+    }
+
+    Func f("f"), g("g");
+    Var x("x"), y("y");
+    f(x, y) = x + y * 10;
+    g(x, y) = f(x, y) + f(x + 1, y) - y * 10;
+    // Keep the pipeline serial, so the events are always in the same
+    // order.
+    f.compute_root().trace_stores().trace_loads();
+    g.trace_stores().trace_realizations();
+    Pipeline p(g);
+
+    int chunks;
+    std::vector<Event> plain = run_traced(p, "0", "1", &chunks);
+    if (chunks != 0) {
+        printf("Found %d compact chunks in a plain trace\n", chunks);
+        return -1;
+    }
+    // 17x8 stores to f, 2x16x8 loads from f, and 16x8 stores to g.
+    int loads_and_stores = 0;
+    for (const Event &e : plain) {
+        loads_and_stores += e.is_load_or_store();
+        if (e.event == halide_trace_store && e.func == "f") {
+            int value;
+            memcpy(&value, e.value.data(), sizeof(value));
+            if (value != e.coordinates[0] + e.coordinates[1] * 10) {
+                printf("Traced store f(%d, %d) = %d\n", e.coordinates[0], e.coordinates[1], value);
+                return -1;
+            }
+        }
+    }
+    if (loads_and_stores != 17 * 8 + 2 * 16 * 8 + 16 * 8) {
+        printf("Found %d loads and stores in the plain trace\n", loads_and_stores);
+        return -1;
+    }
+
+    // A compact trace decodes to exactly the same events.
+    std::vector<Event> compact = run_traced(p, "1", "1", &chunks);
+    if (chunks == 0) {
+        printf("Found no compact chunks in a compact trace\n");
+        return -1;
+    }
+    if (compact.size() != plain.size()) {
+        printf("Compact trace has %d events instead of %d\n", (int)compact.size(), (int)plain.size());
+        return -1;
+    }
+    for (size_t i = 0; i < plain.size(); i++) {
+        if (!(compact[i] == plain[i])) {
+            printf("Event %d of the compact trace (%s, id %d) differs from the plain trace (%s, id %d)\n",
+                   (int)i, compact[i].func.c_str(), compact[i].id, plain[i].func.c_str(), plain[i].id);
+            return -1;
+        }
+    }
+
+    // Sampling every third load or store keeps just those, and all the
+    // other events.
+    std::vector<Event> expected;
+    int n = 0;
+    for (const Event &e : plain) {
+        if (!e.is_load_or_store() || n++ % 3 == 0) {
+            expected.push_back(e);
+        }
+    }
+    std::vector<Event> sampled = run_traced(p, "1", "3", &chunks);
+    if (sampled.size() != expected.size()) {
+        printf("Sampled trace has %d events instead of %d\n", (int)sampled.size(), (int)expected.size());
+        return -1;
+    }
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (!(sampled[i] == expected[i])) {
+            printf("Event %d of the sampled trace (%s, id %d) should be %s, id %d\n",
+                   (int)i, sampled[i].func.c_str(), sampled[i].id, expected[i].func.c_str(), expected[i].id);
+            return -1;
+        }
+    }
+
+    unsetenv("HL_TRACE_FILE");
+    unsetenv("HL_TRACE_COMPACT");
+    unsetenv("HL_TRACE_SAMPLE");
+
+    printf("Success!\n");
+#endif
+    return 0;
+}
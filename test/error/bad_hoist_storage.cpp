@@ -0,0 +1,24 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f("f"), g("g");
+    Var x("x"), y("y");
+
+    f(x, y) = x + y;
+    g(x, y) = f(x, y) + f(x + 1, y);
+
+    g.parallel(y);
+    f.compute_at(g, y);
+
+    // This schedule should be forbidden, because every thread would
+    // share the storage of f.
+    f.hoist_storage_root();
+
+    g.realize({10, 10});
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+#include <stdio.h>
+
+#include "llvm_partitions.h"
+
+using namespace Halide::Runtime;
+
+const int W = 67, H = 43;
+
+int main(int argc, char **argv) {
+    Buffer<int32_t> input(W + 1, H + 1);
+    input.for_each_element([&](int x, int y) {
+        input(x, y) = x * 3 + y * y;
+    });
+
+    Buffer<int32_t> output(W, H);
+    int result = llvm_partitions(input, output);
+    if (result != 0) {
+        printf("llvm_partitions failed with %d\n", result);
+        return -1;
+    }
+
+    auto h = [&](int x, int y) {
+        return input(x, y) * 2 + input(x + 1, y) + 3;
+    };
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int correct = h(x, y) - h(x, y + 1);
+            if (output(x, y) != correct) {
+                printf("output(%d, %d) = %d instead of %d\n", x, y, output(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include "Halide.h"
+
+#include <stdlib.h>
+
+using namespace Halide;
+
+class LLVMPartitions : public Generator<LLVMPartitions> {
+public:
+    Input<Buffer<int32_t>> input{"input", 2};
+    Output<Buffer<int32_t>> output{"output", 2};
+
+    void generate() {
+        // Compile the code in the static library as several objects (see
+        // HL_LLVM_PARTITIONS in README.md), to check that a library built
+        // that way links and computes the right thing.
+#ifdef _MSC_VER
+        _putenv_s("HL_LLVM_PARTITIONS", "4");
+#else
+        setenv("HL_LLVM_PARTITIONS", "4", 1);
+#endif
+
+        // Several parallel loops and async tasks, so that there are
+        // closures to spread across the partitions.
+        Var x("x"), y("y");
+        Func f("f"), g("g"), h("h");
+        f(x, y) = input(x, y) * 2;
+        g(x, y) = input(x, y) + 3;
+        h(x, y) = f(x, y) + g(x + 1, y);
+        output(x, y) = h(x, y) - h(x, y + 1);
+
+        f.compute_root().parallel(y);
+        g.compute_root().parallel(y).vectorize(x, 8, TailStrategy::RoundUp);
+        h.compute_at(output, y).async();
+        output.parallel(y, 4).vectorize(x, 8, TailStrategy::GuardWithIf);
+    }
+};
+
+HALIDE_REGISTER_GENERATOR(LLVMPartitions, llvm_partitions)
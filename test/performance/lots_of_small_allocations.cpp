@@ -12,10 +12,10 @@ int main(int argc, char **argv) {
 
     Param<int> p;
 
-    const char *names[3] = {"heap", "pseudostack", "stack"};
+    const char *names[4] = {"heap", "pseudostack", "stack", "pooled heap"};
 
-    double t[3];
-    for (int i = 0; i < 3; i++) {
+    double t[4];
+    for (int i = 0; i < 4; i++) {
         Var x("x");
 
         Func in;
@@ -35,7 +35,7 @@ int main(int argc, char **argv) {
         chain.back().split(x, xo, xi, p, TailStrategy::RoundUp);
         for (size_t j = 0; j < chain.size() - 1; j++) {
             chain[j].compute_at(chain.back(), xo);
-            if (i != 0) {
+            if (i == 1 || i == 2) {
                 chain[j].store_in(MemoryType::Stack);
             }
             if (i == 2) {
@@ -61,12 +61,18 @@ int main(int argc, char **argv) {
         // pseudostack, not stack to register.
         p.set(200);
 
+        // The last run uses the heap again, but lets the runtime keep
+        // freed allocations to reuse.
+        Internal::JITSharedRuntime::reuse_host_allocations(i == 3);
+
         Buffer<int> out(16 * 1000 * 1000);
         t[i] = Halide::Tools::benchmark([&] { chain.back().realize(out); });
 
         printf("Time using %s: %f\n", names[i], t[i]);
     }
 
+    Internal::JITSharedRuntime::reuse_host_allocations(false);
+
     if (t[0] < t[1]) {
         printf("Heap allocation was faster than pseudostack!\n");
         return -1;
@@ -0,0 +1,91 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace Halide;
+
+bool counters_reported = false;
+float compute_ipc = -1, compute_llc = -1, gather_ipc = -1, gather_llc = -1;
+
+void my_print(void *, const char *msg) {
+    if (strstr(msg, " cycles: ")) {
+        counters_reported = true;
+    }
+    const char *counters = strstr(msg, " ipc: ");
+    if (!counters) {
+        return;
+    }
+    float ipc, llc, br;
+    if (sscanf(counters, " ipc: %f llc/ki: %f br/ki: %f", &ipc, &llc, &br) != 3) {
+        return;
+    }
+    if (strncmp(msg, "  compute:", 10) == 0) {
+        compute_ipc = ipc;
+        compute_llc = llc;
+    } else if (strncmp(msg, "  gather:", 9) == 0) {
+        gather_ipc = ipc;
+        gather_llc = llc;
+    }
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+    if (target.os != Target::Linux || target.arch != Target::X86) {
+        printf("[SKIP] Hardware counters are only collected on x86 Linux.\n");
+        return 0;
+    }
+
+    // A compute-bound Func working on a small amount of data.
+    Var x;
+    Func compute("compute");
+    Expr e = cast<float>(x);
+    for (int j = 0; j < 100; j++) {
+        e = sin(e);
+    }
+    compute(x) = e;
+
+    // A memory-bound Func that gathers from pseudo-random locations in
+    // a buffer much larger than the last-level cache.
+    const int size = 64 * 1024 * 1024;
+    Buffer<float> table(size);
+    table.fill(1.0f);
+    Func gather("gather");
+    Expr index = cast<uint32_t>(x) * Expr((uint32_t)2654435761U);
+    gather(x) = table(cast<int>(index % size)) + compute(x % 1024);
+
+    compute.compute_root();
+    gather.compute_root();
+
+    Func out;
+    out(x) = gather(x);
+    out.set_custom_print(&my_print);
+
+    Target t = target.with_feature(Target::Profile).with_feature(Target::ProfileCounters);
+    out.realize({size / 4}, t);
+
+    if (!counters_reported) {
+        printf("[SKIP] Hardware counters are not available. "
+               "Check /proc/sys/kernel/perf_event_paranoid.\n");
+        return 0;
+    }
+
+    printf("compute: ipc %f, llc misses per 1k instructions %f\n", compute_ipc, compute_llc);
+    printf("gather: ipc %f, llc misses per 1k instructions %f\n", gather_ipc, gather_llc);
+
+    if (compute_ipc <= 0 || gather_ipc <= 0) {
+        printf("Expected hardware counters to be reported for both Funcs\n");
+        return -1;
+    }
+
+    if (gather_llc <= compute_llc) {
+        printf("The gather should miss in the last-level cache more often than the compute-bound Func\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
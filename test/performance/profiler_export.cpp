@@ -0,0 +1,87 @@
+#include "Halide.h"
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+std::string read_file(const std::string &filename) {
+    std::ifstream f(filename);
+    std::stringstream contents;
+    contents << f.rdbuf();
+    return contents.str();
+}
+
+bool expect_contains(const std::string &contents, const std::string &substr, const char *format) {
+    if (contents.find(substr) == std::string::npos) {
+        printf("Expected %s export to contain %s. Got:\n%s\n", format, substr.c_str(), contents.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+    printf("[SKIP] Windows does not have a working setenv\n");
+#else
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    std::string filename = Internal::file_make_temp("profiler_export", ".json");
+    // Must be set before the first profiled pipeline runs, so that the
+    // timeline is recorded.
+    setenv("HL_PROFILER_EXPORT", filename.c_str(), 1);
+
+    // Two expensive Funcs, one of which uses a heap allocation and
+    // runs in parallel.
+    Var x, y;
+    Func producer("producer"), consumer("consumer");
+    Expr e = cast<float>(x + y);
+    for (int i = 0; i < 50; i++) {
+        e = sin(e);
+    }
+    producer(x, y) = e;
+    consumer(x, y) = sqrt(producer(x, y) * producer(x, y) + 1.0f);
+    producer.compute_root().store_in(MemoryType::Heap).parallel(y);
+
+    Target t = target.with_feature(Target::Profile);
+    for (const char *format : {"json", "chrome_trace"}) {
+        setenv("HL_PROFILER_EXPORT_FORMAT", format, 1);
+
+        // The export is written when the profiler report is printed,
+        // after each realization.
+        consumer.realize({1000, 1000}, t);
+
+        std::string contents = read_file(filename);
+        if (!expect_contains(contents, "\"producer\"", format) ||
+            !expect_contains(contents, "\"consumer\"", format) ||
+            !expect_contains(contents, "\"memory_peak\": 4000000", format)) {
+            return -1;
+        }
+        if (format == std::string("json")) {
+            if (!expect_contains(contents, "\"invocations\": [", format) ||
+                !expect_contains(contents, "\"timeline\": [", format) ||
+                !expect_contains(contents, "{\"func\": \"producer\"", format)) {
+                return -1;
+            }
+        } else {
+            if (!expect_contains(contents, "\"traceEvents\": [", format) ||
+                !expect_contains(contents, "\"cat\": \"func\"", format) ||
+                !expect_contains(contents, "\"name\": \"active threads\"", format)) {
+                return -1;
+            }
+        }
+    }
+
+    unsetenv("HL_PROFILER_EXPORT");
+    unsetenv("HL_PROFILER_EXPORT_FORMAT");
+    remove(filename.c_str());
+
+    printf("Success!\n");
+#endif
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "Halide.h"
+#include <random>
+#include <stdio.h>
+
+#include "halide_benchmark.h"
+
+using namespace Halide;
+using namespace Halide::Internal;
+using namespace Halide::Tools;
+
+namespace {
+
+// Counts the nodes of the IR tree, visiting shared subtrees once per
+// use, as the simplifier does.
+class CountNodes : public IRMutator {
+public:
+    using IRMutator::mutate;
+
+    int count = 0;
+
+    Expr mutate(const Expr &e) override {
+        count++;
+        return IRMutator::mutate(e);
+    }
+
+    Stmt mutate(const Stmt &s) override {
+        count++;
+        return IRMutator::mutate(s);
+    }
+};
+
+// The lowered body of a separable blur, scheduled like apps/blur.
+Stmt blur_ir() {
+    ImageParam input(UInt(16), 2, "input");
+    Func blur_x("blur_x"), blur_y("blur_y");
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+
+    blur_x(x, y) = (input(x, y) + input(x + 1, y) + input(x + 2, y)) / 3;
+    blur_y(x, y) = (blur_x(x, y) + blur_x(x, y + 1) + blur_x(x, y + 2)) / 3;
+
+    blur_y.split(y, y, yi, 8).parallel(y).vectorize(x, 8);
+    blur_x.store_at(blur_y, y).compute_at(blur_y, yi).vectorize(x, 8);
+
+    Target t = get_host_target().with_feature(Target::NoAsserts);
+    return blur_y.compile_to_module({input}, "blur", t).functions()[0].body;
+}
+
+// The lowered body of a Gaussian pyramid with a boundary condition,
+// similar to the pyramids in apps/local_laplacian.
+Stmt pyramid_ir() {
+    const int levels = 4;
+    ImageParam input(Float(32), 2, "input");
+    Var x("x"), y("y");
+
+    Func clamped = BoundaryConditions::repeat_edge(input);
+    std::vector<Func> down(levels);
+    down[0](x, y) = clamped(x, y);
+    for (int i = 1; i < levels; i++) {
+        Func dx;
+        dx(x, y) = (down[i - 1](2 * x - 1, y) + 2 * down[i - 1](2 * x, y) + down[i - 1](2 * x + 1, y)) / 4;
+        down[i](x, y) = (dx(x, 2 * y - 1) + 2 * dx(x, 2 * y) + dx(x, 2 * y + 1)) / 4;
+    }
+    Func up;
+    up(x, y) = down[levels - 1](x / 2, y / 2) * 0.25f + down[0](x, y);
+
+    Var yo("yo");
+    up.split(y, yo, y, 16).parallel(yo).vectorize(x, 8);
+    for (int i = 0; i < levels; i++) {
+        down[i].compute_root().parallel(y).vectorize(x, 8);
+    }
+
+    Target t = get_host_target().with_feature(Target::NoAsserts);
+    return up.compile_to_module({input}, "pyramid", t).functions()[0].body;
+}
+
+// Random integer expressions, which give the rewrite rules more to do
+// than already-lowered code.
+Expr random_expr(std::mt19937 &rng, int depth, Type t) {
+    if (depth == 0) {
+        Expr e;
+        if (rng() % 2) {
+            e = Variable::make(t.element_of(), std::string(1, 'a' + rng() % 3));
+        } else {
+            e = make_const(t.element_of(), (int)(rng() % 7) - 3);
+        }
+        if (t.is_vector()) {
+            if (rng() % 2) {
+                e = Broadcast::make(e, t.lanes());
+            } else {
+                e = Ramp::make(e, make_const(t.element_of(), (int)(rng() % 3)), t.lanes());
+            }
+        }
+        return e;
+    }
+    Expr a = random_expr(rng, depth - 1, t);
+    Expr b = random_expr(rng, depth - 1, t);
+    switch (rng() % 9) {
+    case 0:
+        return a + b;
+    case 1:
+        return a - b;
+    case 2:
+        return a * b;
+    case 3:
+        return min(a, b);
+    case 4:
+        return max(a, b);
+    case 5:
+        return select(a < b, a, b);
+    case 6:
+        return select(a == b || a <= 2, a, b + 1);
+    case 7:
+        return a / 4;
+    default:
+        return a % 4;
+    }
+}
+
+Stmt random_ir() {
+    std::mt19937 rng(0);
+    Stmt s;
+    for (int i = 0; i < 2000; i++) {
+        Type t = (i % 2 == 0) ? Int(32) : Int(32, 4);
+        Stmt e = Evaluate::make(random_expr(rng, 1 + i % 5, t));
+        s = s.defined() ? Block::make(s, e) : e;
+    }
+    return s;
+}
+
+void run(const char *name, const Stmt &s) {
+    CountNodes counter;
+    counter.mutate(s);
+
+    BenchmarkConfig config;
+    config.min_time = 0.5;
+    double t = benchmark([&]() { simplify(s); }, config);
+
+    printf("%-10s %8d nodes: %8.3f ms, %10.0f nodes/s\n",
+           name, counter.count, t * 1e3, counter.count / t);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    run("blur", blur_ir());
+    run("pyramid", pyramid_ir());
+    run("random", random_ir());
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include "halide_work_stealing.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// Compare the default thread pool against the work-stealing one in
+// tools/halide_work_stealing.h on a parallel loop with lots of small
+// tasks, which is where contention on the default pool's single work
+// queue lock shows up. On machines with more than one NUMA node, also
+// time the work-stealing pool's NUMA-aware mode.
+
+#define W 64
+#define H 16384
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    Var x, y;
+    Func f;
+
+    Expr math = cast<float>(x + y);
+    for (int i = 0; i < 10; i++) {
+        math = sqrt(cos(sin(math)));
+    }
+    f(x, y) = math;
+    f.vectorize(x, 8).parallel(y);
+
+    Pipeline p(f);
+
+    Buffer<float> reference = p.realize({W, H});
+    Buffer<float> out(W, H);
+
+    int max_threads = (int)std::thread::hardware_concurrency();
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+
+    bool numa = halide_work_stealing_num_numa_nodes() > 1;
+
+    printf("threads   default (ms)   work stealing (ms)   ratio\n");
+    for (int t = 1;; t = std::min(t * 2, max_threads)) {
+        // The default thread pool picks up the thread count from the
+        // environment when the shared runtime is recreated.
+#ifdef _WIN32
+        _putenv_s("HL_NUM_THREADS", std::to_string(t).c_str());
+#else
+        setenv("HL_NUM_THREADS", std::to_string(t).c_str(), 1);
+#endif
+        p.invalidate_cache();
+        Halide::Internal::JITSharedRuntime::release_all();
+
+        p.set_custom_do_par_for(nullptr);
+        p.compile_jit();
+        double default_time = benchmark([&]() { p.realize(out); });
+
+        halide_work_stealing_set_num_threads(t);
+        p.set_custom_do_par_for(halide_work_stealing_do_par_for);
+        out.fill(0.0f);
+        p.realize(out);
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W; xx++) {
+                if (out(xx, yy) != reference(xx, yy)) {
+                    printf("out(%d, %d) = %f instead of %f\n", xx, yy, out(xx, yy), reference(xx, yy));
+                    return -1;
+                }
+            }
+        }
+        double stealing_time = benchmark([&]() { p.realize(out); });
+
+        printf("%7d   %12.3f   %18.3f   %5.2f\n",
+               t, default_time * 1e3, stealing_time * 1e3, default_time / stealing_time);
+
+        if (numa) {
+            halide_work_stealing_set_numa_mode(true);
+            p.set_custom_allocator(halide_numa_first_touch_malloc, halide_numa_first_touch_free);
+            double numa_time = benchmark([&]() { p.realize(out); });
+            printf("%7d   %12s   %18.3f   %5.2f (NUMA-aware)\n",
+                   t, "", numa_time * 1e3, default_time / numa_time);
+            halide_work_stealing_set_numa_mode(false);
+            p.set_custom_allocator(nullptr, nullptr);
+        }
+
+        if (t == max_threads) {
+            break;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,720 @@
+#ifndef HALIDE_WORK_STEALING_H
+#define HALIDE_WORK_STEALING_H
+
+//---------------------------------------------------------------------------
+// An alternative implementation of halide_do_par_for built on per-thread
+// work-stealing deques instead of the single mutex-protected work queue used
+// by the default Halide thread pool. It can be enabled in an application by
+// calling:
+//
+//   halide_enable_work_stealing();
+//
+// or, when JIT compiling, by passing halide_work_stealing_do_par_for to
+// Func::set_custom_do_par_for / Pipeline::set_custom_do_par_for.
+//
+// Each parallel loop is recursively split in half. The thread that splits a
+// range keeps the lower half and pushes the upper half onto the bottom of
+// its own deque. Idle threads steal from the top of a randomly chosen
+// victim's deque, so they pick up the largest remaining ranges and no lock is
+// taken on the fast path. The thread that called halide_do_par_for helps
+// execute work until all iterations of its loop have completed, which makes
+// nested parallel loops safe.
+//
+// Only halide_do_par_for is replaced. halide_do_parallel_tasks (used for
+// async producers and for parallel loops that acquire semaphores) keeps
+// running on the default Halide thread pool.
+//
+// On Linux machines with more than one NUMA node, the pool can also be run
+// in a NUMA-aware mode by calling:
+//
+//   halide_enable_numa_work_stealing();
+//
+// In this mode workers are pinned to the cpus of a node, round-robin. A
+// top-level parallel loop is cut into one contiguous slice per node, and
+// slice k is always handed to node k first, so successive loops over the
+// same rows of an image run on the same node. Idle workers steal from their
+// own node before crossing to another one. Large halide_malloc allocations
+// are given fresh pages that have not been touched, so the kernel places
+// each page on the node of the thread that first writes it, which is the
+// node that owns that slice of the loop.
+//---------------------------------------------------------------------------
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <cstdio>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "HalideRuntime.h"
+
+namespace Halide {
+namespace Tools {
+
+namespace WorkStealingInternal {
+
+// A parallel loop in flight. Lives on the stack of the thread that called
+// halide_do_par_for, which doesn't return until remaining reaches zero.
+struct ParForJob {
+    int (*f)(void *, int, uint8_t *);
+    void *user_context;
+    uint8_t *closure;
+    std::atomic<int> remaining;
+    std::atomic<int> exit_status;
+};
+
+// A contiguous range of iterations of a ParForJob. The fields are atomics
+// only so that a thief may read a slot concurrently with the owner writing a
+// different generation of it; the Chase-Lev protocol guarantees that a thief
+// only uses the value if no such overwrite happened.
+struct Range {
+    std::atomic<ParForJob *> job;
+    std::atomic<int> min, max;
+};
+
+// A fixed-capacity Chase-Lev deque. The owning thread pushes and pops at the
+// bottom; any other thread may steal from the top. Because loops are split
+// in half before being pushed, the occupancy is bounded by the log of the
+// loop extent times the nesting depth, so the deque never needs to grow. If
+// it does fill up, the caller just runs the range itself.
+class Deque {
+    static constexpr int64_t capacity = 1024;
+
+    // Keep the thieves' end and the owner's end on separate cache lines.
+    std::atomic<int64_t> top;
+    char padding[64 - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t> bottom;
+    Range slots[capacity];
+
+public:
+    Deque()
+        : top(0), bottom(0) {
+    }
+
+    bool push(ParForJob *job, int min, int max) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= capacity) {
+            return false;
+        }
+        Range &r = slots[b % capacity];
+        r.job.store(job, std::memory_order_relaxed);
+        r.min.store(min, std::memory_order_relaxed);
+        r.max.store(max, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool pop(ParForJob **job, int *min, int *max) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            // Empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        Range &r = slots[b % capacity];
+        *job = r.job.load(std::memory_order_relaxed);
+        *min = r.min.load(std::memory_order_relaxed);
+        *max = r.max.load(std::memory_order_relaxed);
+        bool success = true;
+        if (t == b) {
+            // Last element. Race any thieves for it.
+            success = top.compare_exchange_strong(t, t + 1,
+                                                  std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return success;
+    }
+
+    bool steal(ParForJob **job, int *min, int *max) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        Range &r = slots[t % capacity];
+        *job = r.job.load(std::memory_order_relaxed);
+        *min = r.min.load(std::memory_order_relaxed);
+        *max = r.max.load(std::memory_order_relaxed);
+        return top.compare_exchange_strong(t, t + 1,
+                                           std::memory_order_seq_cst,
+                                           std::memory_order_relaxed);
+    }
+};
+
+// The NUMA nodes of the machine, as lists of cpus. On anything other than
+// Linux there is a single node.
+struct NumaTopology {
+    std::vector<std::vector<int>> node_cpus;
+
+    int node_of_cpu(int cpu) const {
+        for (size_t n = 0; n < node_cpus.size(); n++) {
+            for (int c : node_cpus[n]) {
+                if (c == cpu) {
+                    return (int)n;
+                }
+            }
+        }
+        return 0;
+    }
+
+    // The node the calling thread is currently running on.
+    int current_node() const {
+#ifdef __linux__
+        if (node_cpus.size() > 1) {
+            int cpu = sched_getcpu();
+            if (cpu >= 0) {
+                return node_of_cpu(cpu);
+            }
+        }
+#endif
+        return 0;
+    }
+
+    // Parse a list of the form "0-3,8,10-11"
+    static std::vector<int> parse_cpu_list(const std::string &str) {
+        std::vector<int> cpus;
+        size_t i = 0;
+        while (i < str.size()) {
+            size_t end = str.find(',', i);
+            if (end == std::string::npos) {
+                end = str.size();
+            }
+            std::string item = str.substr(i, end - i);
+            size_t dash = item.find('-');
+            if (!item.empty() && item[0] >= '0' && item[0] <= '9') {
+                int lo = atoi(item.c_str());
+                int hi = dash == std::string::npos ? lo : atoi(item.c_str() + dash + 1);
+                for (int c = lo; c <= hi; c++) {
+                    cpus.push_back(c);
+                }
+            }
+            i = end + 1;
+        }
+        return cpus;
+    }
+
+    static NumaTopology query() {
+        NumaTopology t;
+#ifdef __linux__
+        // Node ids may be sparse, so check a generous range of them.
+        for (int n = 0; n < 256; n++) {
+            std::string path = "/sys/devices/system/node/node" + std::to_string(n) + "/cpulist";
+            FILE *f = fopen(path.c_str(), "r");
+            if (!f) {
+                continue;
+            }
+            char buf[4096] = {0};
+            size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+            fclose(f);
+            std::vector<int> cpus = parse_cpu_list(std::string(buf, len));
+            if (!cpus.empty()) {
+                t.node_cpus.push_back(cpus);
+            }
+        }
+#endif
+        if (t.node_cpus.empty()) {
+            t.node_cpus.resize(1);
+        }
+        return t;
+    }
+
+    static const NumaTopology &get() {
+        static NumaTopology topology = query();
+        return topology;
+    }
+};
+
+class ThreadPool {
+    // Every thread that has ever run a parallel loop through this pool gets
+    // a deque. Deques are never freed before the pool is, so thieves can
+    // walk this array without locking.
+    static constexpr int max_deques = 1024;
+    std::atomic<Deque *> deques[max_deques];
+    // The NUMA node of the thread that owns each deque.
+    std::atomic<int> deque_nodes[max_deques];
+    std::atomic<int> num_deques{0};
+
+    // In NUMA mode, each node has a deque into which slices of top-level
+    // parallel loops are pushed by whichever thread called
+    // halide_do_par_for. Pushes are serialized by the mutex; steals are
+    // lock-free as usual. Empty when not in NUMA mode.
+    struct NodeMailbox {
+        std::mutex mutex;
+        Deque deque;
+    };
+    std::vector<std::unique_ptr<NodeMailbox>> mailboxes;
+
+    std::vector<std::thread> workers;
+
+    // Idle workers spin for a while, then sleep on this condition
+    // variable. Pushers only touch the mutex if somebody is asleep.
+    std::mutex sleep_mutex;
+    std::condition_variable wake_workers;
+    std::atomic<int> sleepers{0};
+    std::atomic<uint64_t> work_epoch{0};
+    bool shutdown = false;
+
+    // Guards starting and stopping the workers.
+    std::mutex lifecycle_mutex;
+    std::atomic<bool> started{false};
+    int desired_num_threads = 0;
+    bool numa = false;
+    uint64_t generation = 0;
+
+    struct ThreadState {
+        ThreadPool *pool = nullptr;
+        uint64_t generation = 0;
+        Deque *deque = nullptr;
+        uint32_t rng = 0;
+        int node = 0;
+        bool is_worker = false;
+    };
+
+    static ThreadState &thread_state() {
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    Deque *register_deque(int node) {
+        int idx = num_deques.load(std::memory_order_relaxed);
+        while (true) {
+            if (idx >= max_deques) {
+                return nullptr;
+            }
+            if (num_deques.compare_exchange_weak(idx, idx + 1)) {
+                break;
+            }
+        }
+        Deque *d = new Deque;
+        deque_nodes[idx].store(node, std::memory_order_relaxed);
+        deques[idx].store(d, std::memory_order_release);
+        return d;
+    }
+
+    ThreadState &this_thread(int worker_node = -1) {
+        ThreadState &s = thread_state();
+        if (s.pool != this || s.generation != generation) {
+            s.pool = this;
+            s.generation = generation;
+            s.is_worker = worker_node >= 0;
+            s.node = s.is_worker ? worker_node : (numa ? NumaTopology::get().current_node() : 0);
+            s.deque = register_deque(s.node);
+            s.rng = (uint32_t)(uintptr_t)&s;
+        }
+        return s;
+    }
+
+    static uint32_t next_random(uint32_t *state) {
+        // xorshift32
+        uint32_t x = *state ? *state : 0x9e3779b9u;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        *state = x;
+        return x;
+    }
+
+    void notify_new_work() {
+        work_epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            wake_workers.notify_all();
+        }
+    }
+
+    // Run a range of a job, splitting off the upper halves for other
+    // threads to steal as we go.
+    void run_range(ThreadState &self, ParForJob *job, int min, int max) {
+        while (max - min > 1) {
+            int mid = min + (max - min) / 2;
+            if (!self.deque || !self.deque->push(job, mid, max)) {
+                break;
+            }
+            notify_new_work();
+            max = mid;
+        }
+        int done = 0;
+        for (int i = min; i < max; i++) {
+            if (job->exit_status.load(std::memory_order_relaxed) == 0) {
+                int result = job->f(job->user_context, i, job->closure);
+                if (result != 0) {
+                    int expected = 0;
+                    job->exit_status.compare_exchange_strong(expected, result);
+                }
+            }
+            done++;
+        }
+        job->remaining.fetch_sub(done, std::memory_order_acq_rel);
+    }
+
+    bool try_steal(ThreadState &self, ParForJob **job, int *min, int *max) {
+        int n = num_deques.load(std::memory_order_acquire);
+        int num_mailboxes = (int)mailboxes.size();
+        // In NUMA mode, make a first pass that only considers work on our
+        // own node, then a second pass over everything.
+        for (int pass = mailboxes.empty() ? 1 : 0; pass < 2; pass++) {
+            bool local_only = pass == 0;
+            if (local_only && mailboxes[self.node]->deque.steal(job, min, max)) {
+                return true;
+            }
+            if (n > 0) {
+                int start = (int)(next_random(&self.rng) % (uint32_t)n);
+                for (int i = 0; i < n; i++) {
+                    int idx = (start + i) % n;
+                    if (local_only && deque_nodes[idx].load(std::memory_order_relaxed) != self.node) {
+                        continue;
+                    }
+                    Deque *victim = deques[idx].load(std::memory_order_acquire);
+                    if (victim && victim != self.deque && victim->steal(job, min, max)) {
+                        return true;
+                    }
+                }
+            }
+            if (!local_only) {
+                for (int k = 0; k < num_mailboxes; k++) {
+                    if (k != self.node && mailboxes[k]->deque.steal(job, min, max)) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // Find one piece of work and run it. Returns false if there was
+    // nothing to do.
+    bool run_one(ThreadState &self) {
+        ParForJob *job;
+        int min, max;
+        if ((self.deque && self.deque->pop(&job, &min, &max)) ||
+            try_steal(self, &job, &min, &max)) {
+            run_range(self, job, min, max);
+            return true;
+        }
+        return false;
+    }
+
+    void worker_loop(int node) {
+#ifdef __linux__
+        if (numa) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            for (int c : NumaTopology::get().node_cpus[node]) {
+                CPU_SET(c, &cpus);
+            }
+            pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        }
+#endif
+        ThreadState &self = this_thread(node);
+        const int max_spin_count = 40;
+        int spin_count = 0;
+        while (true) {
+            uint64_t epoch = work_epoch.load(std::memory_order_seq_cst);
+            if (run_one(self)) {
+                spin_count = 0;
+                continue;
+            }
+            if (spin_count++ < max_spin_count) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            if (shutdown) {
+                return;
+            }
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (work_epoch.load(std::memory_order_seq_cst) == epoch) {
+                wake_workers.wait(lock);
+            }
+            sleepers.fetch_sub(1, std::memory_order_seq_cst);
+            if (shutdown) {
+                return;
+            }
+            spin_count = 0;
+        }
+    }
+
+    void start_workers() {
+        int n = desired_num_threads;
+        if (n <= 0) {
+            n = default_num_threads();
+        }
+        int num_nodes = numa ? (int)NumaTopology::get().node_cpus.size() : 1;
+        if (num_nodes > 1) {
+            for (int k = 0; k < num_nodes; k++) {
+                mailboxes.emplace_back(new NodeMailbox);
+            }
+        }
+        // The thread calling halide_do_par_for also does work, so
+        // spawn one fewer worker.
+        for (int i = 0; i < n - 1; i++) {
+            int node = i % num_nodes;
+            workers.emplace_back([this, node]() { worker_loop(node); });
+        }
+    }
+
+    void stop_workers() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            shutdown = true;
+            wake_workers.notify_all();
+        }
+        for (std::thread &t : workers) {
+            t.join();
+        }
+        workers.clear();
+        mailboxes.clear();
+        shutdown = false;
+        int n = num_deques.exchange(0);
+        for (int i = 0; i < n; i++) {
+            delete deques[i].exchange(nullptr);
+        }
+        // Invalidate the deques cached in thread-local state.
+        generation++;
+    }
+
+public:
+    ThreadPool() {
+        for (int i = 0; i < max_deques; i++) {
+            deques[i].store(nullptr, std::memory_order_relaxed);
+            deque_nodes[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    ~ThreadPool() {
+        std::lock_guard<std::mutex> lock(lifecycle_mutex);
+        stop_workers();
+    }
+
+    static ThreadPool &get() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    static int default_num_threads() {
+        const char *threads_str = getenv("HL_NUM_THREADS");
+        int n = threads_str ? atoi(threads_str) : (int)std::thread::hardware_concurrency();
+        return n < 1 ? 1 : n;
+    }
+
+    // Must not be called while any parallel loop is running on this pool.
+    int set_num_threads(int n) {
+        std::lock_guard<std::mutex> lock(lifecycle_mutex);
+        int old = desired_num_threads;
+        if (started.load(std::memory_order_relaxed)) {
+            stop_workers();
+            started.store(false, std::memory_order_release);
+        }
+        desired_num_threads = n;
+        return old;
+    }
+
+    // Must not be called while any parallel loop is running on this pool.
+    bool set_numa_mode(bool enable) {
+        std::lock_guard<std::mutex> lock(lifecycle_mutex);
+        bool old = numa;
+        if (started.load(std::memory_order_relaxed)) {
+            stop_workers();
+            started.store(false, std::memory_order_release);
+        }
+        numa = enable;
+        return old;
+    }
+
+    int do_par_for(void *user_context, int (*f)(void *, int, uint8_t *),
+                   int min, int size, uint8_t *closure) {
+        if (size <= 0) {
+            return 0;
+        }
+
+        if (!started.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(lifecycle_mutex);
+            if (!started.load(std::memory_order_relaxed)) {
+                start_workers();
+                started.store(true, std::memory_order_release);
+            }
+        }
+
+        ParForJob job;
+        job.f = f;
+        job.user_context = user_context;
+        job.closure = closure;
+        job.remaining.store(size, std::memory_order_relaxed);
+        job.exit_status.store(0, std::memory_order_relaxed);
+
+        ThreadState &self = this_thread();
+        int num_nodes = (int)mailboxes.size();
+        if (num_nodes > 1 && !self.is_worker) {
+            // Hand each node its own contiguous slice of the loop. Nested
+            // loops (called from a worker) stay on the worker's node.
+            int local_min = min, local_max = min;
+            for (int k = 0; k < num_nodes; k++) {
+                int slice_min = min + (int)(((int64_t)size * k) / num_nodes);
+                int slice_max = min + (int)(((int64_t)size * (k + 1)) / num_nodes);
+                if (slice_min == slice_max) {
+                    continue;
+                }
+                if (k == self.node) {
+                    local_min = slice_min;
+                    local_max = slice_max;
+                    continue;
+                }
+                bool pushed;
+                {
+                    std::lock_guard<std::mutex> lock(mailboxes[k]->mutex);
+                    pushed = mailboxes[k]->deque.push(&job, slice_min, slice_max);
+                }
+                if (pushed) {
+                    notify_new_work();
+                } else {
+                    run_range(self, &job, slice_min, slice_max);
+                }
+            }
+            if (local_min < local_max) {
+                run_range(self, &job, local_min, local_max);
+            }
+        } else {
+            run_range(self, &job, min, min + size);
+        }
+
+        // Help out until every iteration of this loop is done. We may
+        // end up running ranges belonging to other loops while we
+        // wait, which is fine.
+        while (job.remaining.load(std::memory_order_acquire) != 0) {
+            if (!run_one(self)) {
+                std::this_thread::yield();
+            }
+        }
+        return job.exit_status.load(std::memory_order_relaxed);
+    }
+};
+
+}  // namespace WorkStealingInternal
+
+/** A drop-in replacement for halide_do_par_for that schedules the
+ * iterations of parallel loops using work stealing. */
+inline int halide_work_stealing_do_par_for(void *user_context,
+                                           int (*f)(void *, int, uint8_t *),
+                                           int min, int size, uint8_t *closure) {
+    return WorkStealingInternal::ThreadPool::get().do_par_for(user_context, f, min, size, closure);
+}
+
+/** Set the number of threads used by the work-stealing thread pool,
+ * including the calling thread. Zero means use HL_NUM_THREADS or the
+ * number of cores. Shuts down any existing workers, so it must not be
+ * called while a parallel loop is in flight. Returns the old value. */
+inline int halide_work_stealing_set_num_threads(int n) {
+    return WorkStealingInternal::ThreadPool::get().set_num_threads(n);
+}
+
+/** Turn NUMA-aware scheduling in the work-stealing thread pool on or
+ * off. Has no effect unless the machine has more than one NUMA node.
+ * Shuts down any existing workers, so it must not be called while a
+ * parallel loop is in flight. Returns the old value. */
+inline bool halide_work_stealing_set_numa_mode(bool enable) {
+    return WorkStealingInternal::ThreadPool::get().set_numa_mode(enable);
+}
+
+/** The number of NUMA nodes found on this machine. Always 1 on anything
+ * other than Linux. */
+inline int halide_work_stealing_num_numa_nodes() {
+    return (int)WorkStealingInternal::NumaTopology::get().node_cpus.size();
+}
+
+/** A replacement for halide_malloc that gives allocations of at least
+ * 1MB pages that have never been touched, so that each page ends up on
+ * the NUMA node of the thread that first writes to it. Smaller
+ * allocations come from the system malloc. */
+inline void *halide_numa_first_touch_malloc(void * /*user_context*/, size_t x) {
+    // Just before the returned pointer we store the address to pass to
+    // free or munmap, and the size of the mapping (or zero for memory
+    // that came from malloc).
+    const size_t header = 2 * sizeof(size_t);
+#ifdef __linux__
+    const size_t large_allocation = 1 << 20;
+    if (x >= large_allocation) {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        // The header gets its own page, which is touched here on the
+        // calling thread.
+        size_t len = page + ((x + page - 1) / page) * page;
+        void *base = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            return nullptr;
+        }
+        size_t *ptr = (size_t *)((char *)base + page);
+        ptr[-2] = (size_t)base;
+        ptr[-1] = len;
+        return ptr;
+    }
+#endif
+    // Align to 128 bytes, as the default halide_malloc does.
+    const size_t alignment = 128;
+    void *orig = malloc(x + header + alignment - 1);
+    if (orig == nullptr) {
+        return nullptr;
+    }
+    size_t *ptr = (size_t *)(((size_t)orig + header + alignment - 1) & ~(alignment - 1));
+    ptr[-2] = (size_t)orig;
+    ptr[-1] = 0;
+    return ptr;
+}
+
+/** The halide_free counterpart to halide_numa_first_touch_malloc. */
+inline void halide_numa_first_touch_free(void * /*user_context*/, void *ptr) {
+    size_t *p = (size_t *)ptr;
+    void *base = (void *)p[-2];
+#ifdef __linux__
+    if (p[-1] != 0) {
+        munmap(base, p[-1]);
+        return;
+    }
+#endif
+    free(base);
+}
+
+/** Route halide_do_par_for through the work-stealing thread pool. For
+ * AOT-compiled pipelines only; when JIT compiling, use
+ * set_custom_do_par_for on the Func or Pipeline instead. */
+inline void halide_enable_work_stealing() {
+    halide_set_custom_parallel_runtime(halide_work_stealing_do_par_for,
+                                       halide_default_do_task,
+                                       halide_default_do_loop_task,
+                                       halide_default_do_parallel_tasks,
+                                       halide_default_semaphore_init,
+                                       halide_default_semaphore_try_acquire,
+                                       halide_default_semaphore_release);
+}
+
+/** As halide_enable_work_stealing, but with NUMA-aware scheduling turned
+ * on and halide_malloc replaced with halide_numa_first_touch_malloc. For
+ * AOT-compiled pipelines only; when JIT compiling, pass those functions to
+ * set_custom_do_par_for and set_custom_allocator instead. */
+inline void halide_enable_numa_work_stealing() {
+    halide_work_stealing_set_numa_mode(true);
+    halide_enable_work_stealing();
+    halide_set_custom_malloc(halide_numa_first_touch_malloc);
+    halide_set_custom_free(halide_numa_first_touch_free);
+}
+
+}  // namespace Tools
+}  // namespace Halide
+
+#endif  // HALIDE_WORK_STEALING_H
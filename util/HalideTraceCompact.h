@@ -0,0 +1,183 @@
+#ifndef HALIDE_TRACE_COMPACT_H
+#define HALIDE_TRACE_COMPACT_H
+
+#include "HalideRuntime.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Halide {
+namespace Internal {
+
+// Decodes the chunks of delta-encoded load and store records written
+// by the runtime when compact tracing is enabled (see
+// halide_set_trace_compact) back into ordinary trace packets. The
+// record layout is described in src/runtime/tracing.cpp.
+class CompactTraceDecoder {
+    std::vector<uint8_t> chunk;
+    size_t cursor = 0, end = 0;
+
+    // The header and coordinates of the previous record.
+    bool has_header = false;
+    halide_trace_packet_t header;
+    std::string func, trace_tag;
+    int32_t last_id = 0;
+    std::vector<int32_t> coordinates;
+
+    bool get_byte(uint8_t *x) {
+        if (cursor >= end) {
+            return false;
+        }
+        *x = chunk[cursor++];
+        return true;
+    }
+
+    bool get_varint(uint32_t *x) {
+        *x = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t b;
+            if (!get_byte(&b)) {
+                return false;
+            }
+            *x |= (uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool get_zigzag(int32_t *x) {
+        uint32_t u;
+        if (!get_varint(&u)) {
+            return false;
+        }
+        *x = (int32_t)((u >> 1) ^ (~(u & 1) + 1));
+        return true;
+    }
+
+    bool get_string(std::string *s) {
+        const uint8_t *start = chunk.data() + cursor;
+        const void *nul = memchr(start, 0, end - cursor);
+        if (!nul) {
+            return false;
+        }
+        size_t len = (const uint8_t *)nul - start;
+        s->assign((const char *)start, len);
+        cursor += len + 1;
+        return true;
+    }
+
+    bool read_header() {
+        uint8_t event, code, bits, lanes_lo, lanes_hi;
+        uint32_t value_index, dimensions;
+        int32_t parent_id;
+        if (!get_byte(&event) || !get_byte(&code) || !get_byte(&bits) ||
+            !get_byte(&lanes_lo) || !get_byte(&lanes_hi) ||
+            !get_zigzag(&parent_id) || !get_varint(&value_index) || !get_varint(&dimensions) ||
+            !get_string(&func) || !get_string(&trace_tag)) {
+            return false;
+        }
+        header.event = (halide_trace_event_code_t)event;
+        header.type.code = (halide_type_code_t)code;
+        header.type.bits = bits;
+        header.type.lanes = (uint16_t)(lanes_lo | (lanes_hi << 8));
+        header.parent_id = parent_id;
+        header.value_index = (int32_t)value_index;
+        header.dimensions = (int32_t)dimensions;
+        if (coordinates.size() < dimensions) {
+            coordinates.resize(dimensions, 0);
+        }
+        has_header = true;
+        return true;
+    }
+
+public:
+    // Whether the first word of a packet introduces a chunk rather
+    // than being the size of an ordinary packet.
+    static bool is_chunk_marker(uint32_t word) {
+        return (word & 3) == 1;
+    }
+
+    // The number of bytes that follow a chunk marker in the stream.
+    static size_t chunk_bytes(uint32_t marker) {
+        return ((marker >> 2) + 3) & ~(size_t)3;
+    }
+
+    // Start decoding a new chunk. Returns where the caller should read
+    // the chunk_bytes(marker) bytes following the marker to.
+    uint8_t *begin_chunk(uint32_t marker) {
+        chunk.resize(chunk_bytes(marker));
+        cursor = 0;
+        end = marker >> 2;
+        has_header = false;
+        last_id = 0;
+        std::fill(coordinates.begin(), coordinates.end(), 0);
+        return chunk.data();
+    }
+
+    // Whether there are records left in the current chunk.
+    bool has_packets() const {
+        return cursor < end;
+    }
+
+    // Decode the next record into an ordinary packet, laid out in memory
+    // as it would have been written, with payload_capacity bytes
+    // available after the halide_trace_packet_t header. Returns false if
+    // the record is malformed or too large.
+    bool next_packet(halide_trace_packet_t *packet, size_t payload_capacity) {
+        uint8_t flags;
+        if (!get_byte(&flags)) {
+            return false;
+        }
+        if (flags & 1) {
+            if (!read_header()) {
+                return false;
+            }
+        } else if (!has_header) {
+            return false;
+        }
+
+        int32_t id_delta;
+        if (!get_zigzag(&id_delta)) {
+            return false;
+        }
+        last_id = (int32_t)((uint32_t)last_id + (uint32_t)id_delta);
+
+        *packet = header;
+        packet->id = last_id;
+        size_t value_bytes = header.type.lanes * header.type.bytes();
+        size_t payload_bytes = header.dimensions * sizeof(int32_t) + value_bytes +
+                               func.size() + 1 + trace_tag.size() + 1;
+        size_t total_size = (sizeof(halide_trace_packet_t) + payload_bytes + 3) & ~(size_t)3;
+        if (total_size - sizeof(halide_trace_packet_t) > payload_capacity) {
+            return false;
+        }
+        packet->size = (uint32_t)total_size;
+
+        int32_t *coords = packet->coordinates();
+        for (int i = 0; i < header.dimensions; i++) {
+            int32_t delta;
+            if (!get_zigzag(&delta)) {
+                return false;
+            }
+            coordinates[i] = (int32_t)((uint32_t)coordinates[i] + (uint32_t)delta);
+            coords[i] = coordinates[i];
+        }
+        if (end - cursor < value_bytes) {
+            return false;
+        }
+        memcpy(packet->value(), chunk.data() + cursor, value_bytes);
+        cursor += value_bytes;
+        memcpy(packet->func(), func.c_str(), func.size() + 1);
+        memcpy(packet->trace_tag(), trace_tag.c_str(), trace_tag.size() + 1);
+        return true;
+    }
+};
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
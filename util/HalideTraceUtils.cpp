@@ -1,4 +1,5 @@
 #include "HalideTraceUtils.h"
+#include "HalideTraceCompact.h"
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
@@ -11,21 +12,50 @@ bool Packet::read_from_stdin() {
     return read_from_filedesc(stdin);
 }
 
+namespace {
+
+// Compact trace records left over from the last chunk read.
+CompactTraceDecoder compact_decoder;
+
+}  // namespace
+
 bool Packet::read_from_filedesc(FILE *fdesc) {
     size_t header_size = sizeof(halide_trace_packet_t);
-    if (!Packet::read(this, header_size, fdesc)) {
-        return false;
+    while (!compact_decoder.has_packets()) {
+        uint32_t word;
+        if (!Packet::read(&word, sizeof(word), fdesc)) {
+            return false;
+        }
+        if (!CompactTraceDecoder::is_chunk_marker(word)) {
+            // An ordinary packet. The word we read was its size.
+            size = word;
+            if (!Packet::read((uint8_t *)this + sizeof(word), header_size - sizeof(word), fdesc)) {
+                fprintf(stderr, "Unexpected EOF mid-packet");
+                return false;
+            }
+            size_t payload_size = size - header_size;
+            if (payload_size > sizeof(payload)) {
+                fprintf(stderr, "Payload larger than %d bytes in trace stream (%d)\n", (int)sizeof(payload), (int)payload_size);
+                abort();
+                return false;
+            }
+            if (!Packet::read(payload, payload_size, fdesc)) {
+                fprintf(stderr, "Unexpected EOF mid-packet");
+                return false;
+            }
+            return true;
+        }
+        uint8_t *chunk = compact_decoder.begin_chunk(word);
+        if (!Packet::read(chunk, CompactTraceDecoder::chunk_bytes(word), fdesc)) {
+            fprintf(stderr, "Unexpected EOF mid-chunk");
+            return false;
+        }
     }
-    size_t payload_size = size - header_size;
-    if (payload_size > sizeof(payload)) {
-        fprintf(stderr, "Payload larger than %d bytes in trace stream (%d)\n", (int)sizeof(payload), (int)payload_size);
+    if (!compact_decoder.next_packet(this, sizeof(payload))) {
+        fprintf(stderr, "Malformed compact trace record\n");
         abort();
         return false;
     }
-    if (!Packet::read(payload, payload_size, fdesc)) {
-        fprintf(stderr, "Unexpected EOF mid-packet");
-        return false;
-    }
     return true;
 }
 
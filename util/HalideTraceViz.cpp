@@ -24,6 +24,7 @@
 #endif
 
 #include "HalideRuntime.h"
+#include "HalideTraceCompact.h"
 #include "inconsolata.h"
 
 #include "halide_trace_config.h"
@@ -174,9 +175,34 @@ struct PacketAndPayload : public halide_trace_packet_t {
     }
 
     bool read() {
+        // Compact trace records left over from the last chunk read.
+        static Halide::Internal::CompactTraceDecoder compact_decoder;
+
         constexpr size_t header_size = sizeof(halide_trace_packet_t);
-        if (!read_or_die(this, header_size)) {
-            return false;  // EOF
+        while (!compact_decoder.has_packets()) {
+            uint32_t word;
+            if (!read_or_die(&word, sizeof(word))) {
+                return false;  // EOF
+            }
+            if (!compact_decoder.is_chunk_marker(word)) {
+                // An ordinary packet. The word we read was its size.
+                this->size = word;
+                break;
+            }
+            uint8_t *chunk = compact_decoder.begin_chunk(word);
+            if (!read_or_die(chunk, compact_decoder.chunk_bytes(word))) {
+                fail() << "Unable to read compact trace chunk";
+            }
+        }
+        if (compact_decoder.has_packets()) {
+            if (!compact_decoder.next_packet(this, sizeof(this->payload))) {
+                fail() << "Malformed compact trace record";
+            }
+            return true;
+        }
+
+        if (!read_or_die((uint8_t *)this + sizeof(this->size), header_size - sizeof(this->size))) {
+            fail() << "Unable to read packet header";
         }
 
         const size_t payload_size = this->size - header_size;